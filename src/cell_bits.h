@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// One bit per grid cell, stored a row at a time in 64-bit words so a run
+// of cells along a row is set or tested with a word or two whatever its
+// length. Rows start on a word boundary. Cells read in row-major order
+// like a std::bitset of Width * Height, and the set count is kept as bits
+// are set, so count() is free.
+template <int Width, int Height> struct CellBits {
+  static constexpr int WORDS_PER_ROW = (Width + 63) / 64;
+
+  std::array<uint64_t, WORDS_PER_ROW * Height> words{};
+  size_t set_count{0};
+
+  static constexpr size_t size() { return static_cast<size_t>(Width) * Height; }
+  size_t count() const { return set_count; }
+  bool none() const { return set_count == 0; }
+
+  bool test(int x, int y) const {
+    return (words[word_index(x, y)] >> (x & 63)) & 1;
+  }
+  bool operator[](size_t cell) const {
+    return test(static_cast<int>(cell % Width), static_cast<int>(cell / Width));
+  }
+
+  // True when the cell was not already set
+  bool set(int x, int y) { return set_bits(word_index(x, y), bit(x)) != 0; }
+
+  // Sets the given bits of one word and returns those that were clear
+  uint64_t set_bits(size_t word, uint64_t bits) {
+    uint64_t fresh = bits & ~words[word];
+    words[word] |= fresh;
+    set_count += static_cast<size_t>(std::popcount(fresh));
+    return fresh;
+  }
+
+  void reset() {
+    words.fill(0);
+    set_count = 0;
+  }
+
+  // Calls fn(word, bits) for each word covering cells x0..x1 of row y with
+  // just those cells' bits; the span must lie inside the grid
+  template <typename Fn>
+  static void for_each_span_word(int y, int x0, int x1, Fn &&fn) {
+    for (int first = x0; first <= x1; first = (first | 63) + 1) {
+      int last = std::min(x1, first | 63);
+      int width = last - first + 1;
+      uint64_t bits = (width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1)
+                      << (first & 63);
+      fn(word_index(first, y), bits);
+    }
+  }
+
+  // Sets cells x0..x1 of row y and returns how many were clear
+  size_t set_span(int y, int x0, int x1) {
+    size_t fresh = 0;
+    for_each_span_word(y, x0, x1, [&](size_t word, uint64_t bits) {
+      fresh += static_cast<size_t>(std::popcount(set_bits(word, bits)));
+    });
+    return fresh;
+  }
+
+  // True when every cell x0..x1 of row y is set
+  bool all_in_span(int y, int x0, int x1) const {
+    bool all = true;
+    for_each_span_word(y, x0, x1, [&](size_t word, uint64_t bits) {
+      all = all && (words[word] & bits) == bits;
+    });
+    return all;
+  }
+
+  // True when any cell x0..x1 of row y is set
+  bool any_in_span(int y, int x0, int x1) const {
+    bool any = false;
+    for_each_span_word(y, x0, x1, [&](size_t word, uint64_t bits) {
+      any = any || (words[word] & bits) != 0;
+    });
+    return any;
+  }
+
+  static size_t word_index(int x, int y) {
+    return static_cast<size_t>(y) * WORDS_PER_ROW + (x >> 6);
+  }
+  static uint64_t bit(int x) { return uint64_t{1} << (x & 63); }
+};
@@ -1,5 +1,20 @@
 #pragma once
 
+#include "cell_bits.h"
+#include "coverage_planner.h"
+#include "endpoint_grid.h"
+#include "exploration_buffers.h"
+#include "frontier_claims.h"
+#include "frontier_field.h"
+#include "road_chains.h"
+#include "road_chunks.h"
+#include "road_components.h"
+#include "road_graph.h"
+#include "road_streamer.h"
+#include "road_turns.h"
+#include "sim_random.h"
+#include "unvisited_index.h"
+#include "worker_pool.h"
 #include "game_constants.h"
 #include "log.h"
 #include "render_backend.h"
@@ -46,7 +61,7 @@ struct CanDamage : afterhours::BaseComponent {
       : id(id_in), amount(amount_in) {}
 };
 
-enum class MazeAlgorithm { WallFollower, Tremaux, DFS, AStar };
+enum class MazeAlgorithm { WallFollower, Tremaux, DFS, AStar, Route };
 
 struct IsShopManager : afterhours::BaseComponent {
   int car_cost;
@@ -150,12 +165,18 @@ struct IsShopManager : afterhours::BaseComponent {
       return MazeAlgorithm::Tremaux;
     } else if (maze_algorithm_level == 2) {
       return MazeAlgorithm::DFS;
-    } else {
+    } else if (maze_algorithm_level == 3) {
       return MazeAlgorithm::AStar;
+    } else {
+      return MazeAlgorithm::Route;
     }
   }
 };
 
+// Fog and photo reveal state, one bit per brick cell
+using FogCells =
+    CellBits<game_constants::GRID_WIDTH, game_constants::GRID_HEIGHT>;
+
 struct RevealedRect {
   float x;
   float y;
@@ -168,7 +189,7 @@ struct RevealedRect {
 };
 
 struct IsPhotoReveal : afterhours::BaseComponent {
-  std::bitset<game_constants::GRID_SIZE> revealed_cells;
+  FogCells revealed_cells;
   std::vector<RevealedRect> merged_rects;
   float cell_size;
   raylib::Texture2D photo_texture{};
@@ -189,7 +210,7 @@ struct IsPhotoReveal : afterhours::BaseComponent {
         grid_y >= game_constants::GRID_HEIGHT) {
       return false;
     }
-    return revealed_cells[grid_y * game_constants::GRID_WIDTH + grid_x];
+    return revealed_cells.test(grid_x, grid_y);
   }
 
   void set_revealed(int grid_x, int grid_y) {
@@ -197,9 +218,12 @@ struct IsPhotoReveal : afterhours::BaseComponent {
         grid_y >= game_constants::GRID_HEIGHT) {
       return;
     }
-    int idx = grid_y * game_constants::GRID_WIDTH + grid_x;
-    if (!revealed_cells[idx]) {
-      revealed_cells[idx] = true;
+    reveal_bits(FogCells::word_index(grid_x, grid_y), FogCells::bit(grid_x));
+  }
+
+  // Reveals the given bits of one word of revealed_cells
+  void reveal_bits(size_t word, uint64_t bits) {
+    if (revealed_cells.set_bits(word, bits) != 0) {
       merged_rects_dirty = true;
       mask_texture_dirty = true;
     }
@@ -305,13 +329,7 @@ struct IsPhotoReveal : afterhours::BaseComponent {
   }
 
   float get_reveal_percentage() const {
-    int revealed_count = 0;
-    for (int i = 0; i < game_constants::GRID_SIZE; ++i) {
-      if (revealed_cells[i]) {
-        revealed_count++;
-      }
-    }
-    return (static_cast<float>(revealed_count) /
+    return (static_cast<float>(revealed_cells.count()) /
             static_cast<float>(game_constants::GRID_SIZE)) *
            100.0f;
   }
@@ -388,29 +406,59 @@ struct RoadSegment {
 };
 
 struct RoadNetwork : afterhours::BaseComponent {
-  std::vector<RoadSegment> segments;
+  MappedArray<RoadSegment> segments;
   std::vector<bool> visited_segments;
   bool is_loaded{false};
 
-  // Connected component tracking
-  std::vector<size_t> component_id; // maps segment index to component ID
-  std::vector<std::vector<size_t>>
-      components; // list of segments in each component
-  std::unordered_map<size_t, size_t> component_sizes; // cache component sizes
+  // Connected component tracking; a component's id is its root segment
+  RoadComponents components;
   size_t current_component_id{SIZE_MAX};
 
-  // Precomputed segment connections for fast candidate lookup
-  // For each segment, stores two vectors: [0] = connections from start, [1] =
-  // connections from end Each connection is (connected_segment_index,
-  // use_reverse)
-  std::vector<std::array<std::vector<std::pair<size_t, bool>>, 2>>
-      segment_connections;
+  // Rebuilt alongside the components and kept current by mark_visited
+  UnvisitedIndex unvisited;
+
+  static constexpr size_t ROAD_TYPE_COUNT = magic_enum::enum_count<RoadType>();
+  std::array<uint32_t, ROAD_TYPE_COUNT> road_type_total{};
+  std::array<uint32_t, ROAD_TYPE_COUNT> road_type_visited{};
+
+  // Roots of components whose last segment was just visited, oldest first.
+  // HandleComponentCompletion drains it every frame.
+  std::vector<size_t> completed_components;
+
+  // Junction graph built alongside the components; see road_graph.h
+  static constexpr float NODE_WELD_DISTANCE = 0.5f;
+  RoadGraph graph;
+  // Degree-2 runs of the graph; cars only decide at chain ends
+  RoadChains chains;
+  // Which car is driving each chain; see frontier_claims.h
+  FrontierClaims claims;
+  // Junction choices per exit port in wall-follower order
+  RoadTurns turns;
+  // Downhill routes to the nearest unvisited segment; built by the first
+  // step_toward_frontier, then kept current by mark_visited and refreshed
+  // before each read
+  FrontierField frontier;
+
+  // Spatial chunks the segments are grouped by; see road_chunks.h
+  RoadChunkGrid chunks;
 
   RoadNetwork() = default;
 
   void mark_visited(size_t segment_index) {
-    if (segment_index < visited_segments.size()) {
-      visited_segments[segment_index] = true;
+    if (segment_index >= visited_segments.size() ||
+        visited_segments[segment_index]) {
+      return;
+    }
+    visited_segments[segment_index] = true;
+    road_type_visited[static_cast<size_t>(
+        segments[segment_index].road_type)]++;
+    frontier.on_visited(segment_index);
+    if (unvisited.contains(segment_index)) {
+      uint32_t root = components.find(segment_index);
+      unvisited.erase(segment_index, root);
+      if (unvisited.count_in_component(root) == 0) {
+        completed_components.push_back(root);
+      }
     }
   }
 
@@ -421,19 +469,208 @@ struct RoadNetwork : afterhours::BaseComponent {
     return visited_segments[segment_index];
   }
 
-  size_t find_random_unvisited_segment() const {
-    std::vector<size_t> unvisited;
+  // Unvisited and not being driven by any other car
+  bool is_open_for(size_t segment_index, uint32_t agent) const {
+    return !is_visited(segment_index) &&
+           !claims.is_claimed_by_other(chains.chain_of(segment_index), agent);
+  }
+
+  size_t find_random_unvisited_segment(
+      SimRandom::Engine &rng = SimRandom::engine()) const {
+    return unvisited.sample(rng);
+  }
+
+  // Link to drive after the current one to reach the nearest unvisited
+  // segment of this component, or RoadGraph::INVALID if none is left
+  uint32_t step_toward_frontier(size_t segment_index, bool reverse) {
+    ensure_frontier();
+    frontier.refresh(graph, chains);
+    return frontier.next_link(RoadGraph::make_link(segment_index, reverse));
+  }
+
+  // Builds the frontier field from the current visits if it isn't yet
+  void ensure_frontier() {
+    if (!frontier.is_built()) {
+      frontier.build(graph, chains, segments, visited_segments);
+    }
+  }
+
+  size_t get_unvisited_count() const { return unvisited.count(); }
+
+  size_t get_road_type_count(RoadType road_type) const {
+    return road_type_total[static_cast<size_t>(road_type)];
+  }
+
+  size_t get_road_type_visited_count(RoadType road_type) const {
+    return road_type_visited[static_cast<size_t>(road_type)];
+  }
+
+  // Visited flags survive; the counters and index over them are rebuilt
+  void rebuild_visit_tracking() {
+    visited_segments.resize(segments.size(), false);
+    unvisited.build(components, visited_segments);
+    road_type_total.fill(0);
+    road_type_visited.fill(0);
+    for (size_t i = 0; i < segments.size(); ++i) {
+      size_t type = static_cast<size_t>(segments[i].road_type);
+      road_type_total[type]++;
+      road_type_visited[type] += visited_segments[i] ? 1 : 0;
+    }
+    completed_components.clear();
+    // A full Dijkstra over every link, so it waits for the first car that
+    // actually seeks new road rather than slowing every load
+    frontier.clear();
+  }
+
+  // Reorders segments chunk-major. Runs before build_connected_components,
+  // which numbers ports and components by segment index.
+  void build_chunks(float chunk_size) {
+    chunks.clear();
+    if (segments.empty()) {
+      return;
+    }
+
+    vec2 min_pos = segments[0].start;
+    vec2 max_pos = segments[0].start;
+    for (const RoadSegment &segment : segments) {
+      min_pos.x = std::min({min_pos.x, segment.start.x, segment.end.x});
+      min_pos.y = std::min({min_pos.y, segment.start.y, segment.end.y});
+      max_pos.x = std::max({max_pos.x, segment.start.x, segment.end.x});
+      max_pos.y = std::max({max_pos.y, segment.start.y, segment.end.y});
+    }
+    float extent_x = max_pos.x - min_pos.x;
+    float extent_y = max_pos.y - min_pos.y;
+
+    // Same guard as EndpointGrid: a few far-flung segments must not turn
+    // into millions of empty chunks
+    RoadChunkLayout &layout = chunks.layout;
+    float max_chunks =
+        std::max(64.0f, static_cast<float>(segments.size()) / 16.0f);
+    layout.chunk_size = std::max(chunk_size, 1.0f);
+    float area_chunks = ((extent_x / layout.chunk_size) + 1.0f) *
+                        ((extent_y / layout.chunk_size) + 1.0f);
+    if (area_chunks > max_chunks) {
+      layout.chunk_size = std::sqrt((extent_x + layout.chunk_size) *
+                                    (extent_y + layout.chunk_size) /
+                                    max_chunks);
+    }
+    layout.origin = min_pos;
+    layout.columns = static_cast<uint32_t>(extent_x / layout.chunk_size) + 1;
+    layout.rows = static_cast<uint32_t>(extent_y / layout.chunk_size) + 1;
+
+    // Stable counting sort keeps the source order inside each chunk
+    size_t chunk_count = chunks.chunk_count();
+    std::vector<uint32_t> segment_chunk(segments.size());
+    chunks.segment_offsets.assign(chunk_count + 1, 0);
+    for (size_t i = 0; i < segments.size(); ++i) {
+      const RoadSegment &segment = segments[i];
+      vec2 mid{(segment.start.x + segment.end.x) * 0.5f,
+               (segment.start.y + segment.end.y) * 0.5f};
+      segment_chunk[i] = chunks.chunk_at(mid);
+      chunks.segment_offsets[segment_chunk[i] + 1]++;
+    }
+    for (size_t c = 0; c < chunk_count; ++c) {
+      chunks.segment_offsets[c + 1] += chunks.segment_offsets[c];
+    }
+    MappedArray<RoadSegment> sorted;
+    sorted.resize(segments.size());
+    std::vector<uint32_t> cursor(chunks.segment_offsets.begin(),
+                                 chunks.segment_offsets.end() - 1);
     for (size_t i = 0; i < segments.size(); ++i) {
-      if (!is_visited(i)) {
-        unvisited.push_back(i);
+      sorted[cursor[segment_chunk[i]]++] = segments[i];
+    }
+    segments = std::move(sorted);
+
+    chunks.bounds.resize(chunk_count);
+    for (size_t c = 0; c < chunk_count; ++c) {
+      vec2 cell_min{
+          layout.origin.x +
+              static_cast<float>(c % layout.columns) * layout.chunk_size,
+          layout.origin.y +
+              static_cast<float>(c / layout.columns) * layout.chunk_size};
+      RoadChunkBounds box{cell_min, cell_min};
+      for (uint32_t i = chunks.first_segment(c); i < chunks.last_segment(c);
+           ++i) {
+        const RoadSegment &segment = segments[i];
+        if (i == chunks.first_segment(c)) {
+          box = {segment.start, segment.start};
+        }
+        box.min.x = std::min({box.min.x, segment.start.x, segment.end.x});
+        box.min.y = std::min({box.min.y, segment.start.y, segment.end.y});
+        box.max.x = std::max({box.max.x, segment.start.x, segment.end.x});
+        box.max.y = std::max({box.max.y, segment.start.y, segment.end.y});
       }
+      chunks.bounds[c] = box;
+      layout.overhang = std::max(
+          {layout.overhang, cell_min.x - box.min.x, cell_min.y - box.min.y,
+           box.max.x - (cell_min.x + layout.chunk_size),
+           box.max.y - (cell_min.y + layout.chunk_size)});
     }
-    if (unvisited.empty()) {
-      return SIZE_MAX;
+  }
+
+  // Squared distance from position to the segment's closest point
+  static float distance_sq_to_segment(const RoadSegment &segment,
+                                      vec2 position) {
+    vec2 dir = {segment.end.x - segment.start.x,
+                segment.end.y - segment.start.y};
+    float len_sq = dir.x * dir.x + dir.y * dir.y;
+    float t = 0.0f;
+    if (len_sq >= 0.001f) {
+      t = std::clamp(((position.x - segment.start.x) * dir.x +
+                      (position.y - segment.start.y) * dir.y) /
+                         len_sq,
+                     0.0f, 1.0f);
     }
-    static std::mt19937 rng(std::random_device{}());
-    std::uniform_int_distribution<size_t> dist(0, unvisited.size() - 1);
-    return unvisited[dist(rng)];
+    float dx = position.x - (segment.start.x + t * dir.x);
+    float dy = position.y - (segment.start.y + t * dir.y);
+    return dx * dx + dy * dy;
+  }
+
+  // Segments appended since build_chunks are not in any chunk yet
+  size_t first_unchunked_segment() const {
+    return chunks.empty() ? 0 : chunks.last_segment(chunks.chunk_count() - 1);
+  }
+
+  // Closest segment to position, SIZE_MAX when there are none. Ties go to
+  // the lowest index, like a linear scan.
+  size_t find_nearest_segment(vec2 position) const {
+    size_t nearest = SIZE_MAX;
+    float best_dist_sq = std::numeric_limits<float>::max();
+    auto scan = [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        float dist_sq = distance_sq_to_segment(segments[i], position);
+        if (dist_sq < best_dist_sq ||
+            (dist_sq == best_dist_sq && i < nearest)) {
+          best_dist_sq = dist_sq;
+          nearest = i;
+        }
+      }
+    };
+    scan(first_unchunked_segment(), segments.size());
+    chunks.for_each_near(position, best_dist_sq, [&](uint32_t chunk) {
+      scan(chunks.first_segment(chunk), chunks.last_segment(chunk));
+    });
+    return nearest;
+  }
+
+  // Calls fn(segment) for every segment passing within radius of position
+  template <typename Fn>
+  void for_each_segment_in_radius(vec2 position, float radius,
+                                  Fn &&fn) const {
+    float radius_sq = radius * radius;
+    auto scan = [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        if (distance_sq_to_segment(segments[i], position) <= radius_sq) {
+          fn(i);
+        }
+      }
+    };
+    chunks.for_each_overlapping(
+        {position.x - radius, position.y - radius},
+        {position.x + radius, position.y + radius}, [&](uint32_t chunk) {
+          scan(chunks.first_segment(chunk), chunks.last_segment(chunk));
+        });
+    scan(first_unchunked_segment(), segments.size());
   }
 
   void build_connected_components(float connection_tolerance) {
@@ -441,172 +678,171 @@ struct RoadNetwork : afterhours::BaseComponent {
       return;
     }
 
-    component_id.clear();
-    component_id.resize(segments.size(), SIZE_MAX);
     components.clear();
-    component_sizes.clear();
-    segment_connections.clear();
-    segment_connections.resize(segments.size());
+    components.grow(segments.size());
+    graph.clear();
+    chains.clear();
+    claims.clear();
+    turns.clear();
+    frontier.clear();
+
+    // Endpoint e belongs to segment e / 2; even = start, odd = end
+    size_t endpoint_count = segments.size() * 2;
+    std::vector<vec2> endpoints(endpoint_count);
+    for (size_t i = 0; i < segments.size(); ++i) {
+      endpoints[i * 2] = segments[i].start;
+      endpoints[i * 2 + 1] = segments[i].end;
+    }
 
-    size_t next_component_id = 0;
+    EndpointGrid grid;
+    grid.build(endpoints, connection_tolerance);
 
-    // Build adjacency list and precompute connections
-    std::vector<std::vector<size_t>> adjacency(segments.size());
+    graph.port_offsets.assign(endpoint_count + 1, 0);
+    graph.links.reserve(endpoint_count * 2);
+    graph.port_node.assign(endpoint_count, RoadGraph::INVALID);
 
-    for (size_t i = 0; i < segments.size(); ++i) {
-      const RoadSegment &seg_i = segments[i];
-      vec2 seg_i_start = seg_i.start;
-      vec2 seg_i_end = seg_i.end;
-
-      for (size_t j = i + 1; j < segments.size(); ++j) {
-        const RoadSegment &seg_j = segments[j];
-        vec2 seg_j_start = seg_j.start;
-        vec2 seg_j_end = seg_j.end;
-
-        // Check all endpoint combinations
-        float dist_ss = std::sqrt(
-            (seg_i_start.x - seg_j_start.x) * (seg_i_start.x - seg_j_start.x) +
-            (seg_i_start.y - seg_j_start.y) * (seg_i_start.y - seg_j_start.y));
-        float dist_se = std::sqrt(
-            (seg_i_start.x - seg_j_end.x) * (seg_i_start.x - seg_j_end.x) +
-            (seg_i_start.y - seg_j_end.y) * (seg_i_start.y - seg_j_end.y));
-        float dist_es = std::sqrt(
-            (seg_i_end.x - seg_j_start.x) * (seg_i_end.x - seg_j_start.x) +
-            (seg_i_end.y - seg_j_start.y) * (seg_i_end.y - seg_j_start.y));
-        float dist_ee = std::sqrt(
-            (seg_i_end.x - seg_j_end.x) * (seg_i_end.x - seg_j_end.x) +
-            (seg_i_end.y - seg_j_end.y) * (seg_i_end.y - seg_j_end.y));
-
-        if (dist_ss < connection_tolerance || dist_se < connection_tolerance ||
-            dist_es < connection_tolerance || dist_ee < connection_tolerance) {
-          adjacency[i].push_back(j);
-          adjacency[j].push_back(i);
-
-          // Precompute connections from seg_i's END (index 1)
-          // seg_i.end connects to seg_j.start -> use seg_j normally
-          // (reverse=false) seg_i.end connects to seg_j.end -> use seg_j
-          // reversed (reverse=true)
-          if (dist_es < connection_tolerance) {
-            segment_connections[i][1].push_back({j, false});
-          }
-          if (dist_ee < connection_tolerance) {
-            segment_connections[i][1].push_back({j, true});
-          }
+    float tolerance_sq = connection_tolerance * connection_tolerance;
+    float weld_distance =
+        std::min(NODE_WELD_DISTANCE, connection_tolerance * 0.5f);
+    float weld_sq = weld_distance * weld_distance;
 
-          // Precompute connections from seg_i's START (index 0)
-          // seg_i.start connects to seg_j.start -> use seg_j normally
-          // (reverse=false) seg_i.start connects to seg_j.end -> use seg_j
-          // reversed (reverse=true)
-          if (dist_ss < connection_tolerance) {
-            segment_connections[i][0].push_back({j, false});
-          }
-          if (dist_se < connection_tolerance) {
-            segment_connections[i][0].push_back({j, true});
-          }
+    for (size_t e = 0; e < endpoint_count; ++e) {
+      size_t seg = e / 2;
+      vec2 pos = endpoints[e];
 
-          // Same for seg_j: connections from seg_j's END
-          if (dist_ee < connection_tolerance) {
-            segment_connections[j][1].push_back({i, true});
-          }
-          if (dist_se < connection_tolerance) {
-            segment_connections[j][1].push_back({i, false});
-          }
+      grid.for_each_near(pos, [&](uint32_t other) {
+        vec2 other_pos = endpoints[other];
+        float dist_sq = (pos.x - other_pos.x) * (pos.x - other_pos.x) +
+                        (pos.y - other_pos.y) * (pos.y - other_pos.y);
+        if (dist_sq >= tolerance_sq) {
+          return;
+        }
 
-          // Connections from seg_j's START
-          if (dist_ss < connection_tolerance) {
-            segment_connections[j][0].push_back({i, false});
-          }
-          if (dist_es < connection_tolerance) {
-            segment_connections[j][0].push_back({i, true});
+        // Weld onto the first node whose leader is close enough; leaders
+        // never move so chains of short segments cannot collapse together
+        if (other < e && graph.port_node[e] == RoadGraph::INVALID) {
+          const vec2 &leader = graph.node_at(other).position;
+          float leader_sq = (pos.x - leader.x) * (pos.x - leader.x) +
+                            (pos.y - leader.y) * (pos.y - leader.y);
+          if (leader_sq <= weld_sq) {
+            graph.port_node[e] = graph.port_node[other];
           }
         }
+
+        size_t other_seg = other / 2;
+        if (other_seg == seg) {
+          return;
+        }
+        // Entering through the other segment's end means driving it reversed
+        graph.links.push_back(other);
+        components.unite(seg, other_seg);
+      });
+
+      if (graph.port_node[e] == RoadGraph::INVALID) {
+        graph.port_node[e] = static_cast<uint32_t>(graph.nodes.size());
+        RoadNode node;
+        node.position = pos;
+        graph.nodes.push_back(node);
       }
+
+      // Ports are visited in order, so each port's links are contiguous
+      graph.port_offsets[e + 1] = static_cast<uint32_t>(graph.links.size());
+      std::sort(graph.links.begin() + graph.port_offsets[e], graph.links.end());
     }
+    graph.links.shrink_to_fit();
+    graph.build_node_ports();
+    chains.build(graph);
+    claims.build(chains.chain_count());
+    turns.build(graph, segments);
+
+    components.flatten();
+    rebuild_visit_tracking();
+  }
 
-    // DFS to find connected components
-    std::vector<bool> visited(segments.size(), false);
-    for (size_t i = 0; i < segments.size(); ++i) {
-      if (!visited[i]) {
-        std::vector<size_t> component;
-        std::vector<size_t> stack;
-        stack.push_back(i);
-        visited[i] = true;
-
-        while (!stack.empty()) {
-          size_t current = stack.back();
-          stack.pop_back();
-          component.push_back(current);
-          component_id[current] = next_component_id;
-
-          for (size_t neighbor : adjacency[current]) {
-            if (!visited[neighbor]) {
-              visited[neighbor] = true;
-              stack.push_back(neighbor);
-            }
-          }
-        }
+  // Starts component tracking for segments appended since the last build;
+  // each is its own component until connect_segments joins it. Cars only
+  // route onto them once the junction graph is rebuilt.
+  void track_new_segments() {
+    components.grow(segments.size());
+    for (size_t i = visited_segments.size(); i < segments.size(); ++i) {
+      road_type_total[static_cast<size_t>(segments[i].road_type)]++;
+    }
+    visited_segments.resize(segments.size(), false);
+    unvisited.grow(segments.size());
+  }
 
-        components.push_back(component);
-        component_sizes[next_component_id] = component.size();
-        next_component_id++;
-      }
+  // Records that two segments now touch, merging their components without
+  // a rebuild. Returns false when they were already connected.
+  bool connect_segments(size_t a, size_t b) {
+    if (a >= components.segment_count() || b >= components.segment_count()) {
+      return false;
+    }
+    uint32_t root_a = components.find(a);
+    uint32_t root_b = components.find(b);
+    if (!components.unite(a, b)) {
+      return false;
     }
+    unvisited.merge(root_a, root_b, components.find(a));
+    return true;
   }
 
+  size_t component_count() const { return components.count(); }
+
   size_t get_component_id(size_t segment_index) const {
-    if (segment_index >= component_id.size()) {
+    if (segment_index >= components.segment_count()) {
       return SIZE_MAX;
     }
-    return component_id[segment_index];
+    return components.find(segment_index);
   }
 
   size_t get_component_size(size_t comp_id) const {
-    auto it = component_sizes.find(comp_id);
-    if (it != component_sizes.end()) {
-      return it->second;
-    }
-    return 0;
+    return components.size_of(comp_id);
+  }
+
+  size_t get_unvisited_count_in_component(size_t comp_id) const {
+    return components.is_root(comp_id) ? unvisited.count_in_component(comp_id)
+                                       : 0;
   }
 
   size_t get_visited_count_in_component(size_t comp_id) const {
-    if (comp_id >= components.size()) {
-      return 0;
-    }
-    size_t count = 0;
-    for (size_t seg_idx : components[comp_id]) {
-      if (is_visited(seg_idx)) {
-        count++;
-      }
-    }
-    return count;
+    return get_component_size(comp_id) -
+           get_unvisited_count_in_component(comp_id);
   }
 
   bool is_component_complete(size_t comp_id) const {
-    if (comp_id >= components.size()) {
-      return true;
+    return !components.is_root(comp_id) ||
+           get_unvisited_count_in_component(comp_id) == 0;
+  }
+
+  template <typename Fn>
+  void for_each_unvisited_in_component(size_t comp_id, Fn &&fn) const {
+    if (components.is_root(comp_id)) {
+      unvisited.for_each_in_component(comp_id, fn);
     }
-    size_t total = get_component_size(comp_id);
-    size_t visited = get_visited_count_in_component(comp_id);
-    return total > 0 && visited == total;
   }
 
   std::vector<size_t> get_unvisited_in_component(size_t comp_id) const {
-    std::vector<size_t> unvisited;
-    if (comp_id >= components.size()) {
-      return unvisited;
-    }
-    for (size_t seg_idx : components[comp_id]) {
-      if (!is_visited(seg_idx)) {
-        unvisited.push_back(seg_idx);
-      }
-    }
-    return unvisited;
+    std::vector<size_t> result;
+    result.reserve(get_unvisited_count_in_component(comp_id));
+    for_each_unvisited_in_component(
+        comp_id, [&](size_t seg_idx) { result.push_back(seg_idx); });
+    return result;
   }
 };
 
+// Owns the background chunk streamer; see systems/StreamRoadChunks.h
+struct RoadChunkStreaming : afterhours::BaseComponent {
+  std::shared_ptr<RoadChunkStreamer> streamer;
+  // Segment storage the streamer was attached to, to notice reloads
+  const RoadSegment *attached_segments{nullptr};
+  std::vector<uint32_t> wanted;
+
+  RoadChunkStreaming() = default;
+};
+
 struct FogOfWar : afterhours::BaseComponent {
-  std::bitset<game_constants::GRID_SIZE> revealed_cells;
-  std::bitset<game_constants::GRID_SIZE> reachable_cells;
+  FogCells revealed_cells;
+  FogCells reachable_cells;
   float reveal_radius{50.0f};
   bool is_dirty{false};
   bool reachable_computed{false};
@@ -618,7 +854,7 @@ struct FogOfWar : afterhours::BaseComponent {
         grid_y >= game_constants::GRID_HEIGHT) {
       return false;
     }
-    return revealed_cells[grid_y * game_constants::GRID_WIDTH + grid_x];
+    return revealed_cells.test(grid_x, grid_y);
   }
 
   void set_revealed(int grid_x, int grid_y) {
@@ -626,19 +862,31 @@ struct FogOfWar : afterhours::BaseComponent {
         grid_y >= game_constants::GRID_HEIGHT) {
       return;
     }
-    int idx = grid_y * game_constants::GRID_WIDTH + grid_x;
-    if (!revealed_cells[idx]) {
-      revealed_cells[idx] = true;
+    if (revealed_cells.set(grid_x, grid_y)) {
       is_dirty = true;
     }
   }
 
+  // Reveals cells x0..x1 of row y, a word at a time, calling
+  // on_fresh(word, bits) with the bits of each word that were still hidden
+  template <typename Fn>
+  void reveal_span(int grid_y, int x0, int x1, Fn &&on_fresh) {
+    auto reveal_word = [&](size_t word, uint64_t bits) {
+      uint64_t fresh = revealed_cells.set_bits(word, bits);
+      if (fresh != 0) {
+        is_dirty = true;
+        on_fresh(word, fresh);
+      }
+    };
+    FogCells::for_each_span_word(grid_y, x0, x1, reveal_word);
+  }
+
   bool is_reachable(int grid_x, int grid_y) const {
     if (grid_x < 0 || grid_x >= game_constants::GRID_WIDTH || grid_y < 0 ||
         grid_y >= game_constants::GRID_HEIGHT) {
       return false;
     }
-    return reachable_cells[grid_y * game_constants::GRID_WIDTH + grid_x];
+    return reachable_cells.test(grid_x, grid_y);
   }
 
   void set_reachable(int grid_x, int grid_y) {
@@ -646,13 +894,12 @@ struct FogOfWar : afterhours::BaseComponent {
         grid_y >= game_constants::GRID_HEIGHT) {
       return;
     }
-    int idx = grid_y * game_constants::GRID_WIDTH + grid_x;
-    reachable_cells[idx] = true;
+    reachable_cells.set(grid_x, grid_y);
   }
 
   bool are_all_reachable_revealed() const {
-    for (int i = 0; i < game_constants::GRID_SIZE; ++i) {
-      if (reachable_cells[i] && !revealed_cells[i]) {
+    for (size_t word = 0; word < reachable_cells.words.size(); ++word) {
+      if ((reachable_cells.words[word] & ~revealed_cells.words[word]) != 0) {
         return false;
       }
     }
@@ -660,28 +907,68 @@ struct FogOfWar : afterhours::BaseComponent {
   }
 
   void reveal_all_unreachable() {
-    for (int i = 0; i < game_constants::GRID_SIZE; ++i) {
-      if (!reachable_cells[i] && !revealed_cells[i]) {
-        revealed_cells[i] = true;
-        is_dirty = true;
-      }
+    for (int grid_y = 0; grid_y < game_constants::GRID_HEIGHT; ++grid_y) {
+      FogCells::for_each_span_word(
+          grid_y, 0, game_constants::GRID_WIDTH - 1,
+          [&](size_t word, uint64_t bits) {
+            if (revealed_cells.set_bits(
+                    word, bits & ~reachable_cells.words[word]) != 0) {
+              is_dirty = true;
+            }
+          });
     }
   }
 
+  // Read every tick, and the count is kept as cells are revealed
   float get_reveal_percentage() const {
-    int revealed_count = 0;
-    for (int i = 0; i < game_constants::GRID_SIZE; ++i) {
-      if (revealed_cells[i]) {
-        revealed_count++;
-      }
-    }
-    return (static_cast<float>(revealed_count) /
+    return (static_cast<float>(revealed_cells.count()) /
             static_cast<float>(game_constants::GRID_SIZE)) *
            100.0f;
   }
 };
 
-struct RoadFollowing : afterhours::BaseComponent {
+// Last few segments a car drove, oldest first, stored inline so recording
+// one never allocates. Full rings overwrite their oldest entry.
+template <size_t Capacity> struct SegmentRing {
+  std::array<size_t, Capacity> items{};
+  // Oldest entry; only moves once the ring is full
+  size_t head{0};
+  size_t count{0};
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  size_t operator[](size_t i) const { return items[(head + i) % Capacity]; }
+
+  void push(size_t segment) {
+    if (count < Capacity) {
+      items[count++] = segment;
+      return;
+    }
+    items[head] = segment;
+    head = (head + 1) % Capacity;
+  }
+
+  // Order doesn't matter here, and items[0, count) are always the live ones
+  bool contains(size_t segment) const {
+    for (size_t i = 0; i < count; ++i) {
+      if (items[i] == segment) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void clear() {
+    head = 0;
+    count = 0;
+  }
+};
+
+// Everything a car needs to drive the road network under its traversal
+// policy. Kept apart from the component so CarPool can hold one per car as
+// plain data.
+struct RoadFollowingState {
   size_t current_segment_index{0};
   float progress_along_segment{0.0f};
   float speed{100.0f};
@@ -694,11 +981,17 @@ struct RoadFollowing : afterhours::BaseComponent {
   vec2 forced_direction{0.0f, 0.0f}; // Direction to maintain during forced mode
   size_t forced_direction_attempts{
       0}; // Count how many times we've tried forced direction
+  bool seeking_frontier{false}; // Drive to the nearest unvisited road
+  // This car's id in RoadNetwork::claims and the chain it holds there
+  uint32_t agent_id{FrontierClaims::FREE};
+  uint32_t claimed_chain{RoadGraph::INVALID};
   MazeAlgorithm current_algorithm{MazeAlgorithm::WallFollower};
+  // Slot in ExplorationPool holding this car's algorithm state
+  uint32_t exploration_slot{UINT32_MAX};
 
-  std::vector<size_t>
-      segment_history; // Track last 10 segments for loop detection
   static constexpr size_t MAX_HISTORY_SIZE = 10;
+  SegmentRing<MAX_HISTORY_SIZE>
+      segment_history; // Track last 10 segments for loop detection
 
   static constexpr size_t LOOP_DETECTION_THRESHOLD =
       10; // Consecutive visited segments before loop detected (increased)
@@ -708,8 +1001,232 @@ struct RoadFollowing : afterhours::BaseComponent {
       5; // Max forced direction attempts before jumping to unvisited segment
          // (increased)
 
+  RoadFollowingState() = default;
+  RoadFollowingState(float speed_in) : speed(speed_in) {}
+};
+
+struct RoadFollowing : afterhours::BaseComponent, RoadFollowingState {
   RoadFollowing() = default;
-  RoadFollowing(float speed_in) : speed(speed_in) {}
+  RoadFollowing(float speed_in) : RoadFollowingState(speed_in) {}
+};
+
+// The autonomous cars, as parallel arrays rather than entities so the
+// per-tick systems walk them in order. Each field touched every tick gets
+// its own array; what a car only needs at a junction lives in `cold`, whose
+// own segment, progress, speed and direction are stale except while
+// MazeTraversal has the car at a junction (see load() and store()).
+struct CarPool : afterhours::BaseComponent {
+  std::vector<uint32_t> segment;
+  std::vector<float> progress;
+  std::vector<float> speed;
+  std::vector<uint8_t> reverse;
+  std::vector<int> damage;
+  std::vector<vec2> position;
+
+  std::vector<float> radius;
+  std::vector<RoadFollowingState> cold;
+
+  size_t size() const { return segment.size(); }
+  bool empty() const { return segment.empty(); }
+
+  size_t add(vec2 position_in, float radius_in, float speed_in,
+             int damage_in) {
+    segment.push_back(0);
+    progress.push_back(0.0f);
+    speed.push_back(speed_in);
+    reverse.push_back(0);
+    damage.push_back(damage_in);
+    position.push_back(position_in);
+    radius.push_back(radius_in);
+    cold.emplace_back(speed_in);
+    return size() - 1;
+  }
+
+  // The car's full state, with the hot fields brought up to date
+  RoadFollowingState &load(size_t car) {
+    RoadFollowingState &state = cold[car];
+    state.current_segment_index = segment[car];
+    state.progress_along_segment = progress[car];
+    state.speed = speed[car];
+    state.reverse_direction = reverse[car] != 0;
+    return state;
+  }
+
+  // Writes the hot fields of a loaded car back to their arrays
+  void store(size_t car) {
+    const RoadFollowingState &state = cold[car];
+    segment[car] = static_cast<uint32_t>(state.current_segment_index);
+    progress[car] = state.progress_along_segment;
+    speed[car] = state.speed;
+    reverse[car] = state.reverse_direction ? 1 : 0;
+  }
+
+  void clear() {
+    segment.clear();
+    progress.clear();
+    speed.clear();
+    reverse.clear();
+    damage.clear();
+    position.clear();
+    radius.clear();
+    cold.clear();
+  }
+
+  CarPool() = default;
+};
+
+// Threads the passes over pooled cars are spread across; see
+// worker_pool.h. Without a pool, or with too few cars, every pass runs
+// serially on the calling thread.
+struct SimulationWorkers : afterhours::BaseComponent {
+  // Below this many cars, handing out slices costs more than it saves
+  static constexpr size_t MIN_PARALLEL_CARS = 2048;
+
+  std::shared_ptr<WorkerPool> pool;
+  // What each lane's slice of a parallel pass leaves for the serial pass
+  // after it, kept between ticks so steady state allocates nothing
+  std::vector<std::vector<uint32_t>> deferred;
+
+  // 0 lanes means one per core; a single lane keeps everything serial
+  void start(unsigned lane_count) {
+    pool = std::make_shared<WorkerPool>(lane_count);
+    deferred.resize(pool->lanes());
+  }
+
+  bool runs_parallel(size_t car_count) const {
+    return pool && pool->lanes() > 1 && car_count >= MIN_PARALLEL_CARS;
+  }
+
+  // Calls fn(begin, end, deferred) on the workers for each lane's slice of
+  // [0, count), with that lane's deferred list emptied first. Reading the
+  // lists back lane by lane afterwards visits what was deferred in order.
+  template <typename Fn> void for_each_slice(size_t count, Fn &&fn) {
+    size_t lanes = pool->lanes();
+    pool->run([&](size_t lane) {
+      std::vector<uint32_t> &out = deferred[lane];
+      out.clear();
+      fn(WorkerPool::slice_begin(count, lane, lanes),
+         WorkerPool::slice_begin(count, lane + 1, lanes), out);
+    });
+  }
+
+  SimulationWorkers() = default;
+};
+
+// Per-car exploration state for the Tremaux, DFS and A* policies, plus the
+// search buffers they share. Slots are handed out on first use and reused
+// after release, and a slot's buffers are sized for the car's algorithm
+// at its first junction on it, so steady-state traversal allocates
+// nothing.
+struct ExplorationPool : afterhours::BaseComponent {
+  std::vector<ExplorationState> slots;
+  std::vector<uint32_t> free_slots;
+  ExplorationScratch scratch;
+
+  ExplorationState &state_for(RoadFollowingState &road_following) {
+    if (road_following.exploration_slot >= slots.size()) {
+      if (free_slots.empty()) {
+        road_following.exploration_slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+      } else {
+        road_following.exploration_slot = free_slots.back();
+        free_slots.pop_back();
+      }
+    }
+    ExplorationState &state = slots[road_following.exploration_slot];
+    switch (road_following.current_algorithm) {
+    case MazeAlgorithm::Tremaux:
+      state.marks.reserve();
+      break;
+    case MazeAlgorithm::DFS:
+      state.stack.reserve(ExplorationState::MAX_DFS_DEPTH);
+      break;
+    case MazeAlgorithm::AStar:
+    case MazeAlgorithm::Route:
+      state.plan.reserve(ExplorationState::MAX_PLAN);
+      break;
+    case MazeAlgorithm::WallFollower:
+      break;
+    }
+    return state;
+  }
+
+  void release(RoadFollowingState &road_following) {
+    if (road_following.exploration_slot < slots.size()) {
+      slots[road_following.exploration_slot].clear();
+      free_slots.push_back(road_following.exploration_slot);
+    }
+    road_following.exploration_slot = UINT32_MAX;
+  }
+
+  ExplorationPool() = default;
+};
+
+// Coverage tours for MazeAlgorithm::Route, one per component a car has
+// asked about; see coverage_planner.h. Tours are planned on the planner's
+// thread and picked up by MazeTraversal once they are ready.
+struct CoverageRouting : afterhours::BaseComponent {
+  std::shared_ptr<CoveragePlanner> planner;
+  std::vector<std::shared_ptr<const CoverageRoute>> routes;
+  // Components asked for and not yet delivered
+  std::vector<size_t> requested;
+  // Network the tours were planned over, to notice reloads
+  const RoadSegment *planned_segments{nullptr};
+  size_t planned_segment_count{0};
+  uint64_t epoch{0};
+  // Deterministic runs wait for every tour asked for, so each one lands on
+  // the tick after it was requested rather than whenever the thread ends
+  bool wait_for_plans{false};
+
+  const CoverageRoute *route_for(size_t component) const {
+    for (const std::shared_ptr<const CoverageRoute> &route : routes) {
+      if (route->component == component) {
+        return route.get();
+      }
+    }
+    return nullptr;
+  }
+
+  void request(const RoadNetwork &road_network, size_t component) {
+    if (std::find(requested.begin(), requested.end(), component) !=
+        requested.end()) {
+      return;
+    }
+    if (!planner) {
+      planner = std::make_shared<CoveragePlanner>();
+    }
+    requested.push_back(component);
+    planner->request(road_network, component, epoch);
+  }
+
+  // Takes delivered tours, dropping everything planned over an older
+  // network
+  void collect(const RoadNetwork &road_network) {
+    if (planned_segments != road_network.segments.data() ||
+        planned_segment_count != road_network.segments.size()) {
+      planned_segments = road_network.segments.data();
+      planned_segment_count = road_network.segments.size();
+      routes.clear();
+      requested.clear();
+      epoch++;
+    }
+    if (!planner || requested.empty()) {
+      return;
+    }
+    if (wait_for_plans) {
+      planner->wait_idle();
+    }
+    for (std::shared_ptr<const CoverageRoute> &route :
+         planner->take_finished()) {
+      if (route->epoch != epoch) {
+        continue;
+      }
+      std::erase(requested, route->component);
+      routes.push_back(std::move(route));
+    }
+  }
+
+  CoverageRouting() = default;
 };
 
 enum class POIType { Landmark, City, Area };
@@ -724,3 +1241,15 @@ struct PointOfInterest : afterhours::BaseComponent {
   PointOfInterest(vec2 pos, POIType type, int reward)
       : position(pos), poi_type(type), reward_amount(reward) {}
 };
+
+// Hash of the simulation state after the latest fixed tick. Kept only in
+// deterministic runs, where two runs with the same seed must match tick for
+// tick.
+struct SimulationChecksum : afterhours::BaseComponent {
+  uint64_t tick{0};
+  uint64_t value{0};
+  // Log every tick's checksum, to find the first tick two runs diverge
+  bool log_each_tick{false};
+
+  SimulationChecksum() = default;
+};
@@ -0,0 +1,438 @@
+#include "coverage_planner.h"
+
+#include "components.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+constexpr uint32_t NONE = CoverageRoute::INVALID;
+// Repeated laps of the same road sit further apart than this
+constexpr uint32_t LOCATE_WINDOW = 512;
+
+// Junctions with the members meeting at each, a self-loop listed once
+struct JunctionEdges {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> edges;
+
+  void build(const CoverageProblem &problem,
+             const std::vector<uint32_t> &members) {
+    offsets.assign(problem.junction_count + 1, 0);
+    for (uint32_t member : members) {
+      offsets[problem.start_junction[member] + 1]++;
+      if (problem.end_junction[member] != problem.start_junction[member]) {
+        offsets[problem.end_junction[member] + 1]++;
+      }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    edges.resize(offsets.back());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t e = 0; e < members.size(); ++e) {
+      uint32_t member = members[e];
+      edges[fill[problem.start_junction[member]]++] = e;
+      if (problem.end_junction[member] != problem.start_junction[member]) {
+        edges[fill[problem.end_junction[member]]++] = e;
+      }
+    }
+  }
+};
+
+uint32_t other_end(const CoverageProblem &problem, uint32_t member,
+                   uint32_t junction) {
+  return problem.start_junction[member] == junction
+             ? problem.end_junction[member]
+             : problem.start_junction[member];
+}
+
+} // namespace
+
+CoverageProblem CoverageProblem::gather(const RoadNetwork &road_network,
+                                        size_t component) {
+  CoverageProblem problem;
+  problem.component = component;
+  const RoadGraph &graph = road_network.graph;
+  const RoadChains &chains = road_network.chains;
+  if (graph.segment_count() != road_network.segments.size()) {
+    return problem; // Segments streamed in since the graph was built
+  }
+  road_network.components.for_each_member(component, [&](size_t seg) {
+    const RoadSegment &s = road_network.segments[seg];
+    if (std::hypot(s.end.x - s.start.x, s.end.y - s.start.y) >= 0.001f) {
+      problem.segments.push_back(static_cast<uint32_t>(seg));
+    }
+  });
+  std::sort(problem.segments.begin(), problem.segments.end());
+  size_t member_count = problem.segments.size();
+  problem.length.resize(member_count);
+  for (size_t i = 0; i < member_count; ++i) {
+    const RoadSegment &s = road_network.segments[problem.segments[i]];
+    problem.length[i] = std::hypot(s.end.x - s.start.x, s.end.y - s.start.y);
+  }
+
+  // Member i's ports are 2i and 2i + 1 here
+  auto local_port = [&](uint32_t port) {
+    auto it = std::lower_bound(problem.segments.begin(),
+                               problem.segments.end(),
+                               static_cast<uint32_t>(port / 2));
+    if (it == problem.segments.end() || *it != port / 2) {
+      return NONE;
+    }
+    return static_cast<uint32_t>((it - problem.segments.begin()) * 2 +
+                                 (port & 1u));
+  };
+  std::vector<uint32_t> parent(member_count * 2);
+  std::iota(parent.begin(), parent.end(), 0u);
+  auto find = [&](uint32_t port) {
+    while (parent[port] != port) {
+      parent[port] = parent[parent[port]];
+      port = parent[port];
+    }
+    return port;
+  };
+  auto unite = [&](uint32_t a, uint32_t b) {
+    if (a != NONE && b != NONE) {
+      parent[find(a)] = find(b);
+    }
+  };
+  problem.move_offsets.assign(1, 0);
+  problem.welded.assign(member_count * 2, 0);
+  for (size_t i = 0; i < member_count; ++i) {
+    for (uint32_t end : {0u, 1u}) {
+      uint32_t port = RoadGraph::make_port(problem.segments[i], end);
+      uint32_t local = static_cast<uint32_t>(i * 2 + end);
+      uint32_t through = chains.continue_link(port);
+      if (through != RoadChains::INVALID) {
+        uint32_t next = local_port(through);
+        unite(local, next);
+        problem.welded[local] = 1;
+        if (next != NONE) {
+          problem.moves.push_back(next);
+        }
+      } else {
+        for (uint32_t linked : graph.port_links(port)) {
+          uint32_t next = local_port(linked);
+          if (next == NONE) {
+            continue;
+          }
+          problem.moves.push_back(next);
+          if (chains.continue_link(linked) == RoadChains::INVALID) {
+            unite(local, next);
+          }
+        }
+      }
+      problem.move_offsets.push_back(
+          static_cast<uint32_t>(problem.moves.size()));
+    }
+  }
+
+  std::vector<uint32_t> junction_of(member_count * 2, NONE);
+  problem.start_junction.resize(member_count);
+  problem.end_junction.resize(member_count);
+  auto junction = [&](uint32_t port) {
+    uint32_t &id = junction_of[find(port)];
+    if (id == NONE) {
+      id = problem.junction_count++;
+    }
+    return id;
+  };
+  for (uint32_t i = 0; i < member_count; ++i) {
+    problem.start_junction[i] = junction(i * 2);
+    problem.end_junction[i] = junction(i * 2 + 1);
+  }
+  return problem;
+}
+
+bool CoverageProblem::can_move(uint32_t arrival, uint32_t entry) const {
+  if (entry == arrival) {
+    return !welded[arrival];
+  }
+  for (uint32_t i = move_offsets[arrival]; i < move_offsets[arrival + 1];
+       ++i) {
+    if (moves[i] == entry) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t CoverageRoute::position_of(uint32_t link, uint32_t from) const {
+  auto it = std::lower_bound(positions.begin(), positions.end(),
+                             std::make_pair(link, from));
+  if (it == positions.end() || it->first != link) {
+    it = std::lower_bound(positions.begin(), positions.end(),
+                          std::make_pair(link, 0u));
+  }
+  return it != positions.end() && it->first == link ? it->second : INVALID;
+}
+
+uint32_t CoverageRoute::locate(uint32_t link, uint32_t hint) const {
+  size_t count = links.size();
+  if (hint < count) {
+    for (uint32_t step = 0; step < std::min<size_t>(LOCATE_WINDOW, count);
+         ++step) {
+      uint32_t at = static_cast<uint32_t>((hint + step) % count);
+      if (links[at] == link) {
+        return at;
+      }
+    }
+  }
+  return position_of(link, hint < count ? hint : 0);
+}
+
+void CoverageRoute::index() {
+  positions.resize(links.size());
+  for (uint32_t i = 0; i < links.size(); ++i) {
+    positions[i] = {links[i], i};
+  }
+  std::sort(positions.begin(), positions.end());
+}
+
+CoverageRoute CoveragePlanner::plan(const CoverageProblem &problem) {
+  CoverageRoute route;
+  route.component = problem.component;
+  route.epoch = problem.epoch;
+  uint32_t member_count = static_cast<uint32_t>(problem.segments.size());
+  uint32_t junction_count = problem.junction_count;
+  if (member_count == 0) {
+    return route;
+  }
+
+  std::vector<uint32_t> members(member_count);
+  std::iota(members.begin(), members.end(), 0u);
+  JunctionEdges adjacency;
+  adjacency.build(problem, members);
+
+  std::vector<uint8_t> odd(junction_count, 0);
+  for (uint32_t m = 0; m < member_count; ++m) {
+    if (problem.start_junction[m] != problem.end_junction[m]) {
+      odd[problem.start_junction[m]] ^= 1;
+      odd[problem.end_junction[m]] ^= 1;
+    }
+  }
+
+  // Pair each odd junction with the nearest one still unpaired and drive
+  // the path between them twice. Searches stop at the first unpaired odd
+  // junction they settle, so most stay within a few blocks.
+  constexpr float FAR = std::numeric_limits<float>::infinity();
+  std::vector<float> distance(junction_count, FAR);
+  std::vector<uint32_t> via(junction_count, NONE);
+  std::vector<uint32_t> touched;
+  std::vector<std::pair<float, uint32_t>> heap;
+  auto farther = [](const std::pair<float, uint32_t> &a,
+                    const std::pair<float, uint32_t> &b) {
+    return a.first > b.first;
+  };
+  for (uint32_t source = 0; source < junction_count; ++source) {
+    if (!odd[source]) {
+      continue;
+    }
+    for (uint32_t j : touched) {
+      distance[j] = FAR;
+      via[j] = NONE;
+    }
+    touched.clear();
+    heap.clear();
+    distance[source] = 0.0f;
+    touched.push_back(source);
+    heap.emplace_back(0.0f, source);
+    uint32_t partner = NONE;
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), farther);
+      auto [d, j] = heap.back();
+      heap.pop_back();
+      if (d > distance[j]) {
+        continue;
+      }
+      if (j != source && odd[j]) {
+        partner = j;
+        break;
+      }
+      for (uint32_t i = adjacency.offsets[j]; i < adjacency.offsets[j + 1];
+           ++i) {
+        uint32_t m = adjacency.edges[i];
+        uint32_t k = other_end(problem, m, j);
+        float nd = d + problem.length[m];
+        if (nd < distance[k]) {
+          if (distance[k] == FAR) {
+            touched.push_back(k);
+          }
+          distance[k] = nd;
+          via[k] = m;
+          heap.emplace_back(nd, k);
+          std::push_heap(heap.begin(), heap.end(), farther);
+        }
+      }
+    }
+    if (partner == NONE) {
+      continue; // Only possible on a piece the tour won't reach anyway
+    }
+    odd[source] = 0;
+    odd[partner] = 0;
+    for (uint32_t j = partner; j != source;) {
+      uint32_t m = via[j];
+      members.push_back(m);
+      route.repeated_length += problem.length[m];
+      j = other_end(problem, m, j);
+    }
+  }
+
+  // Start the circuit on the piece holding the most road, should the
+  // junction graph have come apart from the component's tolerance links
+  std::vector<uint32_t> piece(junction_count, NONE);
+  std::vector<float> piece_length;
+  std::vector<uint32_t> queue;
+  for (uint32_t seed = 0; seed < junction_count; ++seed) {
+    if (piece[seed] != NONE) {
+      continue;
+    }
+    uint32_t id = static_cast<uint32_t>(piece_length.size());
+    piece_length.push_back(0.0f);
+    piece[seed] = id;
+    queue.assign(1, seed);
+    while (!queue.empty()) {
+      uint32_t j = queue.back();
+      queue.pop_back();
+      for (uint32_t i = adjacency.offsets[j]; i < adjacency.offsets[j + 1];
+           ++i) {
+        uint32_t m = adjacency.edges[i];
+        uint32_t k = other_end(problem, m, j);
+        if (j <= k) {
+          piece_length[id] += problem.length[m];
+        }
+        if (piece[k] == NONE) {
+          piece[k] = id;
+          queue.push_back(k);
+        }
+      }
+    }
+  }
+  uint32_t largest = static_cast<uint32_t>(
+      std::max_element(piece_length.begin(), piece_length.end()) -
+      piece_length.begin());
+  uint32_t start = static_cast<uint32_t>(
+      std::find(piece.begin(), piece.end(), largest) - piece.begin());
+
+  // Hierholzer over the members plus their repeats
+  adjacency.build(problem, members);
+  std::vector<uint8_t> used(members.size(), 0);
+  std::vector<uint32_t> cursor(adjacency.offsets.begin(),
+                               adjacency.offsets.end() - 1);
+  // (junction, edge driven to reach it)
+  std::vector<std::pair<uint32_t, uint32_t>> stack;
+  std::vector<std::pair<uint32_t, uint32_t>> circuit;
+  stack.reserve(members.size() + 1);
+  circuit.reserve(members.size());
+  // Port a member is entered through when driven away from junction j,
+  // and the one it is left through when driven into j
+  auto entry_port = [&](uint32_t m, uint32_t j) {
+    return problem.start_junction[m] == j ? m * 2 : m * 2 + 1;
+  };
+  auto arrival_port = [&](uint32_t m, uint32_t j) {
+    return problem.start_junction[m] == other_end(problem, m, j) ? m * 2 + 1
+                                                                  : m * 2;
+  };
+  stack.emplace_back(start, NONE);
+  while (!stack.empty()) {
+    auto [j, arrived_by] = stack.back();
+    uint32_t &first_unused = cursor[j];
+    while (first_unused < adjacency.offsets[j + 1] &&
+           used[adjacency.edges[first_unused]]) {
+      first_unused++;
+    }
+    if (first_unused < adjacency.offsets[j + 1]) {
+      // Prefer a road the car can actually turn onto from the one it
+      // came in on
+      uint32_t e = adjacency.edges[first_unused];
+      if (arrived_by != NONE) {
+        uint32_t arrival = arrival_port(members[arrived_by], j);
+        for (uint32_t i = first_unused; i < adjacency.offsets[j + 1]; ++i) {
+          uint32_t candidate = adjacency.edges[i];
+          if (!used[candidate] &&
+              problem.can_move(arrival,
+                               entry_port(members[candidate], j))) {
+            e = candidate;
+            break;
+          }
+        }
+      }
+      used[e] = 1;
+      stack.emplace_back(other_end(problem, members[e], j), e);
+      continue;
+    }
+    if (stack.back().second != NONE) {
+      circuit.push_back(stack.back());
+    }
+    stack.pop_back();
+  }
+
+  // Popped last edge first; replay forwards as links
+  route.links.reserve(circuit.size());
+  for (auto it = circuit.rbegin(); it != circuit.rend(); ++it) {
+    uint32_t m = members[it->second];
+    uint32_t from = other_end(problem, m, it->first);
+    bool reverse = problem.start_junction[m] != from;
+    route.links.push_back(RoadGraph::make_link(problem.segments[m], reverse));
+    route.length += problem.length[m];
+  }
+  for (uint32_t m = 0; m < member_count; ++m) {
+    route.unreached_segments += used[m] ? 0 : 1;
+  }
+  route.index();
+  return route;
+}
+
+CoveragePlanner::CoveragePlanner() : worker([this]() { run(); }) {}
+
+CoveragePlanner::~CoveragePlanner() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  worker.join();
+}
+
+void CoveragePlanner::request(const RoadNetwork &road_network,
+                              size_t component, uint64_t epoch) {
+  CoverageProblem problem = CoverageProblem::gather(road_network, component);
+  problem.epoch = epoch;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(std::move(problem));
+  }
+  wake.notify_one();
+}
+
+std::vector<std::shared_ptr<const CoverageRoute>>
+CoveragePlanner::take_finished() {
+  std::vector<std::shared_ptr<const CoverageRoute>> routes;
+  std::lock_guard<std::mutex> lock(mutex);
+  routes.swap(finished);
+  return routes;
+}
+
+void CoveragePlanner::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this]() { return !busy && pending.empty(); });
+}
+
+void CoveragePlanner::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+    if (stopping) {
+      return;
+    }
+    CoverageProblem problem = std::move(pending.front());
+    pending.pop_front();
+    busy = true;
+    lock.unlock();
+    auto route = std::make_shared<const CoverageRoute>(plan(problem));
+    lock.lock();
+    finished.push_back(std::move(route));
+    busy = false;
+    idle.notify_all();
+  }
+}
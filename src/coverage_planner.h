@@ -0,0 +1,107 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct RoadNetwork;
+
+// One component's roads as the planner sees them: every drivable segment
+// as an edge between two junctions. Gathered on the game thread so the
+// planner never reads the live network.
+struct CoverageProblem {
+  size_t component{SIZE_MAX};
+  // Bumped by CoverageRouting on reload, so stale plans can be dropped
+  uint64_t epoch{0};
+  // Member segments, sorted, with their lengths and end junctions
+  std::vector<uint32_t> segments;
+  std::vector<float> length;
+  std::vector<uint32_t> start_junction;
+  std::vector<uint32_t> end_junction;
+  uint32_t junction_count{0};
+  // Per member port (member * 2 + end): the member ports a car arriving
+  // there can drive on through, and whether a degree-2 weld forbids the
+  // U-turn there. Junctions lump linked ports together, so not every pair
+  // of roads meeting at one is a move a car can make.
+  std::vector<uint32_t> move_offsets;
+  std::vector<uint32_t> moves;
+  std::vector<uint8_t> welded;
+
+  bool can_move(uint32_t arrival, uint32_t entry) const;
+
+  // Ports linked to each other share a junction, except that a degree-2
+  // weld stays its own junction, since cars only drive straight through it
+  static CoverageProblem gather(const RoadNetwork &road_network,
+                                size_t component);
+};
+
+// A closed drive over every segment of a component, as the links to take
+// in order. After the last link the tour starts again from the first.
+struct CoverageRoute {
+  static constexpr uint32_t INVALID = UINT32_MAX;
+
+  size_t component{SIZE_MAX};
+  uint64_t epoch{0};
+  std::vector<uint32_t> links;
+  // Total driving distance, and the part of it spent on repeated roads
+  float length{0.0f};
+  float repeated_length{0.0f};
+  // Segments left out because no junction path reaches them from the tour
+  size_t unreached_segments{0};
+
+  // First place at or after `from` that drives link, wrapping round to
+  // the start of the tour, or INVALID when the tour never drives it
+  uint32_t position_of(uint32_t link, uint32_t from = 0) const;
+
+  // Where a car that just drove `link` is on the tour, looking a little
+  // past `hint` first so repeated roads resolve to the right pass
+  uint32_t locate(uint32_t link, uint32_t hint) const;
+
+  void index();
+
+private:
+  // (link, position) for every step, sorted
+  std::vector<std::pair<uint32_t, uint32_t>> positions;
+};
+
+// Approximate route inspection (Chinese postman) over a component's
+// junction graph: odd junctions are paired greedily with their nearest
+// unpaired odd neighbour, the shortest paths between pairs are driven
+// twice, and Hierholzer's algorithm walks the now even graph as one circuit.
+// Plans run one at a time on a background thread.
+class CoveragePlanner {
+public:
+  CoveragePlanner();
+  ~CoveragePlanner();
+
+  CoveragePlanner(const CoveragePlanner &) = delete;
+  void operator=(const CoveragePlanner &) = delete;
+
+  // Snapshots the component here and plans it on the worker
+  void request(const RoadNetwork &road_network, size_t component,
+               uint64_t epoch);
+  // Routes finished since the last call, oldest first
+  std::vector<std::shared_ptr<const CoverageRoute>> take_finished();
+  // Blocks until every request so far has been planned
+  void wait_idle();
+
+  static CoverageRoute plan(const CoverageProblem &problem);
+
+private:
+  void run();
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::deque<CoverageProblem> pending;
+  std::vector<std::shared_ptr<const CoverageRoute>> finished;
+  bool busy{false};
+  bool stopping{false};
+  std::thread worker;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "rl.h"
+#include "std_include.h"
+#include <cstdint>
+
+// Uniform grid over a fixed set of points, bucketed with a counting sort so
+// every 3x3 neighbourhood query touches three contiguous ranges.
+struct EndpointGrid {
+  vec2 origin{0.0f, 0.0f};
+  float cell_size{1.0f};
+  int columns{0};
+  int rows{0};
+  std::vector<uint32_t> cell_start;
+  std::vector<uint32_t> items;
+
+  void build(const std::vector<vec2> &points, float min_cell_size) {
+    cell_start.clear();
+    items.clear();
+    columns = 0;
+    rows = 0;
+    if (points.empty()) {
+      return;
+    }
+
+    vec2 min_pos = points[0];
+    vec2 max_pos = points[0];
+    for (const vec2 &point : points) {
+      min_pos.x = std::min(min_pos.x, point.x);
+      min_pos.y = std::min(min_pos.y, point.y);
+      max_pos.x = std::max(max_pos.x, point.x);
+      max_pos.y = std::max(max_pos.y, point.y);
+    }
+
+    float extent_x = max_pos.x - min_pos.x;
+    float extent_y = max_pos.y - min_pos.y;
+
+    // Sparse data spread over a huge area would otherwise allocate far more
+    // cells than points, so grow the cells until there are ~4 per point.
+    float max_cells =
+        std::max(1024.0f, 4.0f * static_cast<float>(points.size()));
+    cell_size = std::max(min_cell_size, 0.001f);
+    float area_cells = ((extent_x / cell_size) + 1.0f) *
+                       ((extent_y / cell_size) + 1.0f);
+    if (area_cells > max_cells) {
+      cell_size = std::max(cell_size,
+                           std::sqrt((extent_x + cell_size) *
+                                     (extent_y + cell_size) / max_cells));
+    }
+
+    origin = min_pos;
+    columns = static_cast<int>(extent_x / cell_size) + 1;
+    rows = static_cast<int>(extent_y / cell_size) + 1;
+
+    size_t cell_count =
+        static_cast<size_t>(columns) * static_cast<size_t>(rows);
+    cell_start.assign(cell_count + 1, 0);
+
+    std::vector<uint32_t> point_cell(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+      point_cell[i] = static_cast<uint32_t>(cell_index(points[i]));
+      cell_start[point_cell[i] + 1]++;
+    }
+    for (size_t c = 0; c < cell_count; ++c) {
+      cell_start[c + 1] += cell_start[c];
+    }
+
+    items.resize(points.size());
+    std::vector<uint32_t> cursor(cell_start.begin(), cell_start.end() - 1);
+    for (size_t i = 0; i < points.size(); ++i) {
+      items[cursor[point_cell[i]]++] = static_cast<uint32_t>(i);
+    }
+  }
+
+  template <typename Fn> void for_each_near(vec2 position, Fn &&fn) const {
+    if (items.empty()) {
+      return;
+    }
+    int cx = column_of(position.x);
+    int cy = row_of(position.y);
+    int x0 = std::max(0, cx - 1);
+    int x1 = std::min(columns - 1, cx + 1);
+    if (x0 > x1) {
+      return;
+    }
+    for (int y = std::max(0, cy - 1); y <= std::min(rows - 1, cy + 1); ++y) {
+      size_t row_base = static_cast<size_t>(y) * static_cast<size_t>(columns);
+      uint32_t begin = cell_start[row_base + static_cast<size_t>(x0)];
+      uint32_t end = cell_start[row_base + static_cast<size_t>(x1) + 1];
+      for (uint32_t i = begin; i < end; ++i) {
+        fn(items[i]);
+      }
+    }
+  }
+
+private:
+  int column_of(float x) const {
+    float cell = std::floor((x - origin.x) / cell_size);
+    return static_cast<int>(
+        std::clamp(cell, -1.0f, static_cast<float>(columns)));
+  }
+
+  int row_of(float y) const {
+    float cell = std::floor((y - origin.y) / cell_size);
+    return static_cast<int>(std::clamp(cell, -1.0f, static_cast<float>(rows)));
+  }
+
+  size_t cell_index(vec2 position) const {
+    int cx = std::clamp(column_of(position.x), 0, columns - 1);
+    int cy = std::clamp(row_of(position.y), 0, rows - 1);
+    return static_cast<size_t>(cy) * static_cast<size_t>(columns) +
+           static_cast<size_t>(cx);
+  }
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Tremaux passage marks for one car: how many times it has entered each
+// chain. Open addressing over two small fixed tables, so a car's memory
+// never grows with the map. New marks go in the recent table; once that is
+// half full the older table is emptied and the two swap places, so only
+// passages not entered since the swap before last are forgotten. A mark
+// found only in the older table moves up when it is bumped. The tables
+// are allocated by reserve(), so cars on other algorithms pay nothing.
+struct PassageMarks {
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+  static constexpr size_t CAPACITY = 1024; // per table, power of two
+
+  // Both tables back to back; the recent one starts at `recent`
+  std::vector<uint32_t> keys;
+  std::vector<uint8_t> counts;
+  size_t recent{0};
+  size_t used{0};
+
+  uint8_t get(uint32_t passage) const {
+    if (keys.empty()) {
+      return 0;
+    }
+    size_t slot = find(recent, passage);
+    if (keys[slot] == passage) {
+      return counts[slot];
+    }
+    slot = find(older(), passage);
+    return keys[slot] == passage ? counts[slot] : 0;
+  }
+
+  void reserve() {
+    if (keys.empty()) {
+      keys.assign(CAPACITY * 2, EMPTY);
+      counts.assign(CAPACITY * 2, 0);
+    }
+  }
+
+  void bump(uint32_t passage) {
+    reserve();
+    size_t slot = find(recent, passage);
+    if (keys[slot] == passage) {
+      if (counts[slot] < UINT8_MAX) {
+        counts[slot]++;
+      }
+      return;
+    }
+    uint8_t count = 1;
+    size_t old_slot = find(older(), passage);
+    if (keys[old_slot] == passage && counts[old_slot] < UINT8_MAX) {
+      count = static_cast<uint8_t>(counts[old_slot] + 1);
+    }
+    if (used >= CAPACITY / 2) {
+      // The oldest marks go; whatever this passage had is carried in count
+      clear_table(older());
+      recent = older();
+      used = 0;
+      slot = find(recent, passage);
+    }
+    keys[slot] = passage;
+    counts[slot] = count;
+    used++;
+  }
+
+  void clear() {
+    std::fill(keys.begin(), keys.end(), EMPTY);
+    std::fill(counts.begin(), counts.end(), 0);
+    used = 0;
+  }
+
+private:
+  size_t older() const { return CAPACITY - recent; }
+
+  // Slot holding passage in the table at `base`, or the empty one where it
+  // would go
+  size_t find(size_t base, uint32_t passage) const {
+    for (size_t i = slot_of(passage);; i = (i + 1) & (CAPACITY - 1)) {
+      if (keys[base + i] == passage || keys[base + i] == EMPTY) {
+        return base + i;
+      }
+    }
+  }
+
+  void clear_table(size_t base) {
+    std::fill(keys.begin() + base, keys.begin() + base + CAPACITY, EMPTY);
+    std::fill(counts.begin() + base, counts.begin() + base + CAPACITY, 0);
+  }
+
+  // Fibonacci hashing keeps the product's top bits, which depend on every
+  // bit of the passage
+  static size_t slot_of(uint32_t passage) {
+    return (passage * 2654435761u) >> (32 - std::countr_zero(CAPACITY));
+  }
+};
+
+// Search buffers shared by every car's A* runs. Searches run one at a time
+// on the traversal thread, so a generation stamp per link stands in for
+// clearing the arrays between them.
+struct ExplorationScratch {
+  static constexpr size_t MAX_EXPANSIONS = 2048;
+
+  std::vector<uint32_t> stamp;
+  std::vector<float> cost;
+  std::vector<uint32_t> parent;
+  // Min-heap on estimated total cost
+  std::vector<std::pair<float, uint32_t>> open;
+  uint32_t generation{0};
+
+  void begin(size_t link_count) {
+    if (stamp.size() < link_count) {
+      stamp.assign(link_count, 0);
+      cost.resize(link_count);
+      parent.resize(link_count);
+      open.reserve(MAX_EXPANSIONS * 4);
+      generation = 0;
+    }
+    open.clear();
+    if (++generation == 0) {
+      std::fill(stamp.begin(), stamp.end(), 0);
+      generation = 1;
+    }
+  }
+
+  bool seen(uint32_t link) const { return stamp[link] == generation; }
+
+  void reach(uint32_t link, float g, uint32_t from) {
+    stamp[link] = generation;
+    cost[link] = g;
+    parent[link] = from;
+  }
+};
+
+// Everything one car remembers between junctions. Lives in a pool slot and
+// is cleared, not freed, when the car changes algorithm or teleports. Each
+// buffer is sized by ExplorationPool::state_for once a car on the
+// algorithm using it reaches a junction, so a slot only holds memory for
+// the algorithms its car has run.
+struct ExplorationState {
+  // DFS never holds more than this many junctions; the oldest half is
+  // dropped when it would. A backtrack that long is cut short by the
+  // frontier field well before the stack runs out.
+  static constexpr size_t MAX_DFS_DEPTH = 256;
+  // Junctions an A* plan holds at most; see AStarPolicy::record_plan
+  static constexpr size_t MAX_PLAN = 256;
+
+  PassageMarks marks;          // Tremaux
+  std::vector<uint32_t> stack; // DFS: way back out of each open junction
+  std::vector<uint32_t> plan;  // A*: junction links still to take, next last
+  uint32_t route_cursor{UINT32_MAX}; // Route: place on the coverage tour
+
+  void push_way_back(uint32_t link) {
+    if (stack.size() >= MAX_DFS_DEPTH) {
+      stack.erase(stack.begin(), stack.begin() + MAX_DFS_DEPTH / 2);
+    }
+    stack.push_back(link);
+  }
+
+  void clear() {
+    marks.clear();
+    stack.clear();
+    plan.clear();
+    route_cursor = UINT32_MAX;
+  }
+};
@@ -0,0 +1,412 @@
+#pragma once
+
+#include "components.h"
+#include <climits>
+#include <cmath>
+#include <span>
+
+// What an exploration policy sees at a junction. Policies are plain structs
+// with a static choose(), picked by MazeTraversal through a template so a
+// decision costs no virtual call. choose() returns the link to drive next,
+// or RoadGraph::INVALID when the policy has nothing left to explore from
+// here.
+struct ExplorationContext {
+  const RoadFollowingState &road_following;
+  const RoadNetwork &road_network;
+  ExplorationState &state;
+  ExplorationScratch &scratch;
+  // Ways on from this junction, in wall-follower order
+  std::span<const RoadTurn> turns;
+  // Back down the segment just driven
+  uint32_t u_turn{RoadGraph::INVALID};
+  // The component's coverage tour, for RoutePolicy once it is planned
+  const CoverageRoute *route{nullptr};
+
+  // Unvisited and not being driven by another car
+  bool is_open(uint32_t link) const {
+    return road_network.is_open_for(RoadGraph::link_segment(link),
+                                    road_following.agent_id);
+  }
+
+  bool can_take(uint32_t link) const {
+    if (link == u_turn) {
+      return true;
+    }
+    for (const RoadTurn &turn : turns) {
+      if (turn.link == link) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Backtracking that has gone this long without new road is cheaper
+  // replaced by a jump, as the wall follower's loop breaking does
+  bool backtracked_too_long() const {
+    return road_following.segments_without_reveal >=
+           RoadFollowing::LOOP_DETECTION_THRESHOLD;
+  }
+};
+
+// Tremaux: count how often each passage (a junction-to-junction chain) has
+// been entered. Never enter one a third time and turn back when a fresh
+// passage led to a junction already seen. Open road (unvisited, and no
+// other car on it) beats both rules, since covering it is the point.
+struct TremauxPolicy {
+  static uint32_t passage_of(const RoadNetwork &road_network, uint32_t link) {
+    size_t seg = RoadGraph::link_segment(link);
+    uint32_t chain = road_network.chains.chain_of(seg);
+    return chain != RoadChains::INVALID ? chain : static_cast<uint32_t>(seg);
+  }
+
+  static uint32_t choose(ExplorationContext &ctx) {
+    PassageMarks &marks = ctx.state.marks;
+    uint32_t arrival = passage_of(ctx.road_network, ctx.u_turn);
+    if (marks.get(arrival) == 0) {
+      // Started mid-passage rather than entering it at a junction
+      marks.bump(arrival);
+    }
+
+    const RoadTurn *best = nullptr;
+    int best_score = INT_MAX;
+    bool junction_seen = false;
+    for (const RoadTurn &turn : ctx.turns) {
+      uint32_t passage = passage_of(ctx.road_network, turn.link);
+      if (passage == arrival) {
+        continue;
+      }
+      uint8_t count = marks.get(passage);
+      junction_seen = junction_seen || count > 0;
+      if (count >= 2) {
+        continue;
+      }
+      int score = (ctx.is_open(turn.link) ? 0 : 2) + count;
+      if (score < best_score) {
+        best = &turn;
+        best_score = score;
+      }
+    }
+
+    uint32_t next = RoadGraph::INVALID;
+    if (best && best_score < 2) {
+      next = best->link;
+    } else if (ctx.backtracked_too_long()) {
+      return RoadGraph::INVALID;
+    } else if (marks.get(arrival) == 1 && junction_seen) {
+      next = ctx.u_turn;
+    } else if (best) {
+      next = best->link;
+    } else if (marks.get(arrival) < 2) {
+      next = ctx.u_turn;
+    }
+    if (next != RoadGraph::INVALID) {
+      marks.bump(passage_of(ctx.road_network, next));
+    }
+    return next;
+  }
+};
+
+// Depth-first search: go down the first open way on, remembering the way
+// back out of each junction left by an open road, and when a junction has
+// nothing new drive back the way the car came to the junction before it.
+// A dead end is left by the way the car came in; a junction the car has
+// come back to is left by the way back it remembered, so backtracking
+// climbs the tree one junction at a time.
+struct DfsPolicy {
+  static uint32_t choose(ExplorationContext &ctx) {
+    std::vector<uint32_t> &stack = ctx.state.stack;
+    bool remembered = !stack.empty() && same_junction(ctx, stack.back());
+    for (const RoadTurn &turn : ctx.turns) {
+      if (!ctx.is_open(turn.link)) {
+        continue;
+      }
+      if (!remembered) {
+        ctx.state.push_way_back(ctx.u_turn);
+      }
+      return turn.link;
+    }
+    if (stack.empty() || ctx.backtracked_too_long()) {
+      return RoadGraph::INVALID;
+    }
+    if (!remembered) {
+      return ctx.u_turn;
+    }
+    uint32_t back = stack.back();
+    stack.pop_back();
+    return back;
+  }
+
+private:
+  // Whether `link` sets off from the junction the car is at
+  static bool same_junction(const ExplorationContext &ctx, uint32_t link) {
+    const RoadGraph &graph = ctx.road_network.graph;
+    return graph.port_node[link] == graph.port_node[ctx.u_turn];
+  }
+};
+
+// A*: take an open way on when there is one; otherwise plan the shortest
+// drive to the nearest open segment, steering the search toward a sampled
+// unvisited segment in the same component, and follow that plan junction
+// by junction. Each search expands at most MAX_EXPANSIONS links and gives
+// up, rather than plan from a partial search, once that or the open
+// heap's room runs out; choose() then returns INVALID and MazeTraversal
+// heads down the frontier field instead, until the car finds new road.
+struct AStarPolicy {
+  static constexpr int TARGET_SAMPLES = 8;
+
+  static uint32_t choose(ExplorationContext &ctx) {
+    std::vector<uint32_t> &plan = ctx.state.plan;
+    for (const RoadTurn &turn : ctx.turns) {
+      if (ctx.is_open(turn.link)) {
+        plan.clear();
+        return turn.link;
+      }
+    }
+    if (!plan.empty()) {
+      uint32_t next = plan.back();
+      plan.pop_back();
+      if (ctx.can_take(next)) {
+        return next;
+      }
+      plan.clear();
+    }
+    if (!search(ctx)) {
+      return RoadGraph::INVALID;
+    }
+    uint32_t next = plan.back();
+    plan.pop_back();
+    return next;
+  }
+
+private:
+  static float length_of(const RoadNetwork &road_network, uint32_t link) {
+    const RoadSegment &seg =
+        road_network.segments[RoadGraph::link_segment(link)];
+    return std::hypot(seg.end.x - seg.start.x, seg.end.y - seg.start.y);
+  }
+
+  static vec2 far_end(const RoadNetwork &road_network, uint32_t link) {
+    const RoadSegment &seg =
+        road_network.segments[RoadGraph::link_segment(link)];
+    return RoadGraph::link_reverse(link) ? seg.start : seg.end;
+  }
+
+  // Closest of a few random unvisited segments sharing the car's component
+  static bool pick_target(const ExplorationContext &ctx, vec2 from,
+                          vec2 &target) {
+    SimRandom::Engine &rng = SimRandom::engine();
+    const RoadNetwork &road_network = ctx.road_network;
+    size_t component = road_network.get_component_id(
+        RoadGraph::link_segment(ctx.u_turn));
+    float best = -1.0f;
+    for (int i = 0; i < TARGET_SAMPLES; ++i) {
+      size_t seg = road_network.unvisited.sample(rng);
+      if (seg == SIZE_MAX) {
+        return false;
+      }
+      if (road_network.get_component_id(seg) != component) {
+        continue;
+      }
+      const RoadSegment &candidate = road_network.segments[seg];
+      vec2 mid{(candidate.start.x + candidate.end.x) * 0.5f,
+               (candidate.start.y + candidate.end.y) * 0.5f};
+      float d = std::hypot(mid.x - from.x, mid.y - from.y);
+      if (best < 0.0f || d < best) {
+        best = d;
+        target = mid;
+      }
+    }
+    return best >= 0.0f;
+  }
+
+  // Plans the shortest drive to the nearest open segment
+  static bool search(ExplorationContext &ctx) {
+    vec2 here = far_end(ctx.road_network, ctx.u_turn ^ 1u);
+    vec2 target{0.0f, 0.0f};
+    bool has_target = pick_target(ctx, here, target);
+    return search_toward(ctx, has_target, target,
+                         [&](uint32_t link) { return ctx.is_open(link); });
+  }
+
+public:
+  // Plans the shortest drive that ends by entering `goal`, into the same
+  // plan choose() follows; false when the search ran out first
+  static bool plan_to(ExplorationContext &ctx, uint32_t goal) {
+    return search_toward(ctx, true, far_end(ctx.road_network, goal),
+                         [&](uint32_t link) { return link == goal; });
+  }
+
+private:
+  template <typename Goal>
+  static bool search_toward(ExplorationContext &ctx, bool has_target,
+                            vec2 target, Goal &&is_goal) {
+    const RoadNetwork &road_network = ctx.road_network;
+    ExplorationScratch &scratch = ctx.scratch;
+    scratch.begin(road_network.graph.segment_count() * 2);
+
+    auto estimate = [&](uint32_t link) {
+      if (!has_target) {
+        return 0.0f;
+      }
+      vec2 end = far_end(road_network, link);
+      return std::hypot(target.x - end.x, target.y - end.y);
+    };
+    auto cheaper = [](const std::pair<float, uint32_t> &a,
+                      const std::pair<float, uint32_t> &b) {
+      return a.first > b.first;
+    };
+    // Set when a push finds the heap full; a dropped link could be the
+    // one the shortest plan goes through
+    bool overflowed = false;
+    auto push = [&](uint32_t link, float g, uint32_t from) {
+      if (scratch.seen(link) && scratch.cost[link] <= g) {
+        return;
+      }
+      if (scratch.open.size() == scratch.open.capacity()) {
+        overflowed = true;
+        return;
+      }
+      scratch.reach(link, g, from);
+      scratch.open.emplace_back(g + estimate(link), link);
+      std::push_heap(scratch.open.begin(), scratch.open.end(), cheaper);
+    };
+
+    push(ctx.u_turn, length_of(road_network, ctx.u_turn), RoadGraph::INVALID);
+    for (const RoadTurn &turn : ctx.turns) {
+      push(turn.link, length_of(road_network, turn.link), RoadGraph::INVALID);
+    }
+
+    size_t expansions = 0;
+    while (!scratch.open.empty() && !overflowed &&
+           expansions < ExplorationScratch::MAX_EXPANSIONS) {
+      std::pop_heap(scratch.open.begin(), scratch.open.end(), cheaper);
+      auto [f, link] = scratch.open.back();
+      scratch.open.pop_back();
+      if (f > scratch.cost[link] + estimate(link) + 0.001f) {
+        continue; // Superseded by a cheaper route
+      }
+      if (is_goal(link)) {
+        record_plan(ctx, link);
+        return true;
+      }
+      expansions++;
+      uint32_t exit = link ^ 1u;
+      float g = scratch.cost[link];
+      // A degree-2 weld only goes on along its chain
+      uint32_t chained = road_network.chains.continue_link(exit);
+      if (chained != RoadChains::INVALID) {
+        push(chained, g + length_of(road_network, chained), link);
+        continue;
+      }
+      for (const RoadTurn &turn : road_network.turns.at(exit)) {
+        push(turn.link, g + length_of(road_network, turn.link), link);
+      }
+    }
+    return false;
+  }
+
+  // Keeps only the links chosen at junctions; chains drive themselves. A
+  // plan longer than MAX_PLAN keeps its nearest junctions, and the car
+  // searches again from where they run out.
+  static void record_plan(ExplorationContext &ctx, uint32_t goal) {
+    const ExplorationScratch &scratch = ctx.scratch;
+    auto is_junction = [&](uint32_t link, uint32_t from) {
+      return from == RoadGraph::INVALID ||
+             ctx.road_network.chains.continue_link(from ^ 1u) != link;
+    };
+    size_t junctions = 0;
+    for (uint32_t link = goal; link != RoadGraph::INVALID;) {
+      uint32_t from = scratch.parent[link];
+      junctions += is_junction(link, from) ? 1 : 0;
+      link = from;
+    }
+    size_t skip = junctions > ExplorationState::MAX_PLAN
+                      ? junctions - ExplorationState::MAX_PLAN
+                      : 0;
+
+    std::vector<uint32_t> &plan = ctx.state.plan;
+    plan.clear();
+    for (uint32_t link = goal; link != RoadGraph::INVALID;) {
+      uint32_t from = scratch.parent[link];
+      if (is_junction(link, from)) {
+        if (skip > 0) {
+          --skip;
+        } else {
+          plan.push_back(link);
+        }
+      }
+      link = from;
+    }
+  }
+};
+
+// Route inspection: drive the component's precomputed coverage tour, which
+// covers every segment with little repetition. The car joins the tour
+// wherever it already is and skips stretches already driven. Where the
+// tour asks for a move this junction can't make, it drives round to the
+// tour's next road with A*. Plain A* stands in until the planner delivers
+// and whenever the tour ahead is all driven, and the car moves on once its
+// component has nothing left to visit.
+struct RoutePolicy {
+  // Furthest along the tour a car looks for open road
+  static constexpr size_t SKIP_WINDOW = 32;
+
+  static uint32_t choose(ExplorationContext &ctx) {
+    const CoverageRoute *route = ctx.route;
+    if (route == nullptr || route->links.empty()) {
+      return AStarPolicy::choose(ctx);
+    }
+    if (ctx.road_network.unvisited.count_in_component(route->component) ==
+        0) {
+      return RoadGraph::INVALID;
+    }
+
+    // Still driving round to where the tour goes on
+    std::vector<uint32_t> &plan = ctx.state.plan;
+    if (!plan.empty()) {
+      uint32_t next = plan.back();
+      plan.pop_back();
+      if (ctx.can_take(next)) {
+        return next;
+      }
+      plan.clear();
+    }
+
+    uint32_t &cursor = ctx.state.route_cursor;
+    uint32_t at = route->locate(ctx.u_turn ^ 1u, cursor);
+    if (at == CoverageRoute::INVALID) {
+      // On tour road driving the other way; turn round onto it
+      uint32_t back = route->position_of(ctx.u_turn, cursor);
+      if (back == CoverageRoute::INVALID) {
+        return AStarPolicy::choose(ctx);
+      }
+      cursor = back;
+      return ctx.u_turn;
+    }
+    // Tour road already driven, by this car or another, is skipped
+    size_t count = route->links.size();
+    cursor = CoverageRoute::INVALID;
+    for (size_t step = 0; step < std::min(SKIP_WINDOW, count); ++step) {
+      uint32_t ahead = static_cast<uint32_t>((at + 1 + step) % count);
+      if (ctx.is_open(route->links[ahead])) {
+        cursor = ahead;
+        break;
+      }
+    }
+    if (cursor == CoverageRoute::INVALID) {
+      // Nothing open for a while along the tour; find open road nearby
+      cursor = at;
+      return AStarPolicy::choose(ctx);
+    }
+    uint32_t next = route->links[cursor];
+    if (ctx.can_take(next)) {
+      return next;
+    }
+    if (!AStarPolicy::plan_to(ctx, next)) {
+      return AStarPolicy::choose(ctx);
+    }
+    next = plan.back();
+    plan.pop_back();
+    return next;
+  }
+};
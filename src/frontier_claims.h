@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Which car is currently driving each chain, so cars arriving at the same
+// junction fan out over different unexplored roads instead of trailing
+// each other. One atomic owner per chain, taken and dropped with
+// compare-exchange, so traversal can run on worker threads without a lock.
+// A car holds at most one claim: the chain it is driving.
+struct FrontierClaims {
+  static constexpr uint32_t FREE = 0;
+
+  FrontierClaims() = default;
+  FrontierClaims(const FrontierClaims &other) { *this = other; }
+  FrontierClaims &operator=(const FrontierClaims &other) {
+    owners = std::vector<std::atomic<uint32_t>>(other.owners.size());
+    for (size_t i = 0; i < owners.size(); ++i) {
+      owners[i].store(other.owners[i].load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    }
+    next_agent.store(other.next_agent.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    return *this;
+  }
+
+  void build(size_t chain_count) {
+    owners = std::vector<std::atomic<uint32_t>>(chain_count);
+  }
+
+  // Ids start at 1; FREE never names a car
+  uint32_t new_agent() {
+    return next_agent.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool is_claimed_by_other(uint32_t chain, uint32_t agent) const {
+    if (chain >= owners.size()) {
+      return false;
+    }
+    uint32_t owner = owners[chain].load(std::memory_order_relaxed);
+    return owner != FREE && owner != agent;
+  }
+
+  bool try_claim(uint32_t chain, uint32_t agent) {
+    if (chain >= owners.size()) {
+      return false;
+    }
+    uint32_t expected = FREE;
+    return owners[chain].compare_exchange_strong(expected, agent,
+                                                 std::memory_order_acq_rel) ||
+           expected == agent;
+  }
+
+  // Only the owner can let go, so a late release never drops a claim
+  // another car has since taken
+  void release(uint32_t chain, uint32_t agent) {
+    if (chain >= owners.size()) {
+      return;
+    }
+    uint32_t expected = agent;
+    owners[chain].compare_exchange_strong(expected, FREE,
+                                          std::memory_order_acq_rel);
+  }
+
+  void clear() { owners.clear(); }
+
+  size_t memory_bytes() const {
+    return owners.capacity() * sizeof(std::atomic<uint32_t>);
+  }
+
+private:
+  std::vector<std::atomic<uint32_t>> owners;
+  std::atomic<uint32_t> next_agent{1};
+};
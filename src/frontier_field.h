@@ -0,0 +1,242 @@
+#pragma once
+
+#include "road_chains.h"
+#include "road_graph.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Driving distance from every link to the nearest unvisited segment, with
+// the link to take next on that route. Built once by a multi-source
+// Dijkstra run backwards from every unvisited segment, then repaired as
+// segments are visited: only links whose route ran through a newly visited
+// segment are reset and re-settled from their neighbours. A car that wants
+// new road reads next_link() at each junction and drives downhill.
+//
+// Moves follow MazeTraversal: a degree-2 weld only continues along its
+// chain, anywhere else a car may take any linked segment or turn back.
+struct FrontierField {
+  static constexpr uint32_t INVALID = RoadGraph::INVALID;
+  static constexpr float UNREACHABLE = std::numeric_limits<float>::infinity();
+
+  // Per link: distance from entering it to reaching unvisited road, and the
+  // link to drive after it (INVALID when the link is itself unvisited)
+  std::vector<float> distance;
+  std::vector<uint32_t> next;
+  // Per segment; degenerate ones are never routed over
+  std::vector<float> length;
+
+  // Segments visited since the last refresh
+  std::vector<uint32_t> pending;
+
+  template <typename Segments, typename Visited>
+  void build(const RoadGraph &graph, const RoadChains &chains,
+             const Segments &segments, const Visited &visited) {
+    size_t segment_count = graph.segment_count();
+    length.resize(segment_count);
+    for (size_t seg = 0; seg < segment_count; ++seg) {
+      const auto &s = segments[seg];
+      length[seg] = std::hypot(s.end.x - s.start.x, s.end.y - s.start.y);
+    }
+    distance.assign(segment_count * 2, UNREACHABLE);
+    next.assign(segment_count * 2, INVALID);
+    affected.assign(segment_count * 2, 0);
+    pending.clear();
+    pending.reserve(PENDING_RESERVE);
+    // A repair can touch every link; the initial settle below already
+    // grows the heap about that far
+    dirty.clear();
+    dirty.reserve(segment_count * 2);
+    heap.clear();
+    for (size_t seg = 0; seg < segment_count; ++seg) {
+      if (seg < visited.size() && visited[seg]) {
+        continue;
+      }
+      if (!drivable(seg)) {
+        continue;
+      }
+      for (bool reverse : {false, true}) {
+        uint32_t link = RoadGraph::make_link(seg, reverse);
+        distance[link] = 0.0f;
+        heap.emplace_back(0.0f, link);
+      }
+    }
+    std::make_heap(heap.begin(), heap.end(), farther);
+    settle(graph, chains);
+    built = true;
+  }
+
+  // False until the first build and again after clear()
+  bool is_built() const { return built; }
+
+  void on_visited(size_t segment) {
+    if (segment < length.size()) {
+      pending.push_back(static_cast<uint32_t>(segment));
+    }
+  }
+
+  // Applies every visit since the last call
+  void refresh(const RoadGraph &graph, const RoadChains &chains) {
+    if (pending.empty()) {
+      return;
+    }
+    // Everything whose downhill route ends in a newly visited segment
+    dirty.clear();
+    for (uint32_t seg : pending) {
+      for (bool reverse : {false, true}) {
+        uint32_t link = RoadGraph::make_link(seg, reverse);
+        if (distance[link] == 0.0f && !affected[link]) {
+          affected[link] = 1;
+          dirty.push_back(link);
+        }
+      }
+    }
+    pending.clear();
+    for (size_t i = 0; i < dirty.size(); ++i) {
+      uint32_t link = dirty[i];
+      for_each_predecessor(graph, chains, link, [&](uint32_t prev) {
+        if (next[prev] == link && !affected[prev]) {
+          affected[prev] = 1;
+          dirty.push_back(prev);
+        }
+      });
+    }
+    for (uint32_t link : dirty) {
+      distance[link] = UNREACHABLE;
+      next[link] = INVALID;
+    }
+
+    // Re-seed each from the best neighbour the visits left untouched
+    heap.clear();
+    for (uint32_t link : dirty) {
+      size_t seg = RoadGraph::link_segment(link);
+      if (!drivable(seg)) {
+        continue;
+      }
+      for_each_successor(graph, chains, link, [&](uint32_t after) {
+        if (affected[after] || distance[after] == UNREACHABLE) {
+          return;
+        }
+        float d = length[seg] + distance[after];
+        if (d < distance[link]) {
+          distance[link] = d;
+          next[link] = after;
+        }
+      });
+      if (distance[link] != UNREACHABLE) {
+        heap.emplace_back(distance[link], link);
+      }
+    }
+    for (uint32_t link : dirty) {
+      affected[link] = 0;
+    }
+    std::make_heap(heap.begin(), heap.end(), farther);
+    settle(graph, chains);
+  }
+
+  // Link to take after driving `link` to head for unvisited road
+  uint32_t next_link(uint32_t link) const {
+    return link < next.size() ? next[link] : INVALID;
+  }
+
+  float distance_from(uint32_t link) const {
+    return link < distance.size() ? distance[link] : UNREACHABLE;
+  }
+
+  void clear() {
+    built = false;
+    distance.clear();
+    next.clear();
+    length.clear();
+    pending.clear();
+    affected.clear();
+    dirty.clear();
+    heap.clear();
+  }
+
+  size_t memory_bytes() const {
+    return distance.capacity() * sizeof(float) +
+           next.capacity() * sizeof(uint32_t) +
+           length.capacity() * sizeof(float) +
+           pending.capacity() * sizeof(uint32_t) +
+           affected.capacity() * sizeof(uint8_t) +
+           dirty.capacity() * sizeof(uint32_t) +
+           heap.capacity() * sizeof(std::pair<float, uint32_t>);
+  }
+
+private:
+  static constexpr size_t PENDING_RESERVE = 4096;
+
+  bool built{false};
+  std::vector<uint8_t> affected;
+  std::vector<uint32_t> dirty;
+  std::vector<std::pair<float, uint32_t>> heap;
+
+  static bool farther(const std::pair<float, uint32_t> &a,
+                      const std::pair<float, uint32_t> &b) {
+    return a.first > b.first;
+  }
+
+  bool drivable(size_t seg) const { return length[seg] >= 0.001f; }
+
+  // Links a car may drive straight after `link`
+  template <typename Fn>
+  static void for_each_successor(const RoadGraph &graph,
+                                 const RoadChains &chains, uint32_t link,
+                                 Fn &&fn) {
+    uint32_t exit = link ^ 1u;
+    uint32_t chained = chains.continue_link(exit);
+    if (chained != INVALID) {
+      fn(chained);
+      return;
+    }
+    for (uint32_t after : graph.port_links(exit)) {
+      fn(after);
+    }
+    fn(exit); // Turning back drives the same segment the other way
+  }
+
+  // Links that can be followed by `link`; ports link symmetrically, so
+  // these are read off link's own entry port
+  template <typename Fn>
+  static void for_each_predecessor(const RoadGraph &graph,
+                                   const RoadChains &chains, uint32_t link,
+                                   Fn &&fn) {
+    for (uint32_t port : graph.port_links(link)) {
+      uint32_t chained = chains.continue_link(port);
+      if (chained == INVALID || chained == link) {
+        fn(port ^ 1u);
+      }
+    }
+    if (chains.continue_link(link) == INVALID) {
+      fn(link ^ 1u);
+    }
+  }
+
+  void settle(const RoadGraph &graph, const RoadChains &chains) {
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), farther);
+      auto [d, link] = heap.back();
+      heap.pop_back();
+      if (d > distance[link]) {
+        continue;
+      }
+      for_each_predecessor(graph, chains, link, [&](uint32_t prev) {
+        size_t seg = RoadGraph::link_segment(prev);
+        if (!drivable(seg)) {
+          return;
+        }
+        float nd = length[seg] + d;
+        if (nd < distance[prev]) {
+          distance[prev] = nd;
+          next[prev] = link;
+          heap.emplace_back(nd, prev);
+          std::push_heap(heap.begin(), heap.end(), farther);
+        }
+      });
+    }
+  }
+};
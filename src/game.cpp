@@ -13,9 +13,11 @@
 #include "systems/DiscoverySystem.h"
 #include "systems/HandleCameraControls.h"
 #include "systems/HandleCollisions.h"
+#include "systems/HandleComponentCompletion.h"
 #include "systems/HandleShopInput.h"
 #include "systems/LoopDetection.h"
 #include "systems/MazeTraversal.h"
+#include "systems/OfflineProgress.h"
 #include "systems/RebuildPhotoReveal.h"
 #include "systems/RenderBrick.h"
 #include "systems/RenderCar.h"
@@ -31,7 +33,9 @@
 #include "systems/RenderSystemHelpers.h"
 #include "systems/RevealFogOfWar.h"
 #include "systems/SpawnNewCars.h"
+#include "systems/StreamRoadChunks.h"
 #include "systems/TestSystem.h"
+#include "systems/TrackSimulationChecksum.h"
 #include "systems/UpdateCarUpgrades.h"
 #include "testing/test_app.h"
 #include "testing/test_input.h"
@@ -49,7 +53,53 @@ raylib::RenderTexture2D mainRT;
 raylib::RenderTexture2D screenRT;
 raylib::Font uiFont;
 
-void game() {
+// Everything that moves the world forward and nothing that reads input or
+// draws, so the same set can run with or without a window
+static void register_simulation_systems(afterhours::SystemManager &systems,
+                                        const SimulationOptions &options) {
+  systems.register_fixed_update_system(std::make_unique<CarPhysics>());
+  systems.register_fixed_update_system(std::make_unique<MazeTraversal>());
+  systems.register_fixed_update_system(std::make_unique<LoopDetection>());
+  systems.register_fixed_update_system(std::make_unique<HandleCollisions>());
+  systems.register_fixed_update_system(std::make_unique<RebuildPhotoReveal>());
+  if (options.deterministic) {
+    systems.register_fixed_update_system(
+        std::make_unique<TrackSimulationChecksum>());
+  }
+
+  systems.register_update_system(std::make_unique<SpawnNewCars>());
+  systems.register_update_system(std::make_unique<UpdateCarUpgrades>());
+  systems.register_update_system(std::make_unique<RevealFogOfWar>());
+  systems.register_update_system(std::make_unique<AutoRevealUnreachableFog>());
+  systems.register_update_system(std::make_unique<DiscoverySystem>());
+  systems.register_update_system(
+      std::make_unique<HandleComponentCompletion>());
+  systems.register_update_system(std::make_unique<StreamRoadChunks>());
+}
+
+// Applies the options that act on the freshly set up world
+static void start_simulation(const SimulationOptions &options) {
+  CoverageRouting *routing =
+      afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>();
+  if (routing) {
+    routing->wait_for_plans = options.deterministic;
+  }
+  SimulationChecksum *checksum =
+      afterhours::EntityHelper::get_singleton_cmp<SimulationChecksum>();
+  if (checksum) {
+    checksum->log_each_tick = options.log_checksums;
+  }
+  SimulationWorkers *workers =
+      afterhours::EntityHelper::get_singleton_cmp<SimulationWorkers>();
+  if (workers) {
+    workers->start(options.worker_threads);
+  }
+  if (options.catch_up_seconds > 0.0f) {
+    OfflineProgress::catch_up(options.catch_up_seconds);
+  }
+}
+
+void game(const SimulationOptions &options) {
   mainRT =
       raylib::LoadRenderTexture(static_cast<int>(game_constants::WORLD_WIDTH),
                                 static_cast<int>(game_constants::WORLD_HEIGHT));
@@ -75,21 +125,9 @@ void game() {
     afterhours::input::register_update_systems(systems);
     afterhours::window_manager::register_update_systems(systems);
 
-    systems.register_fixed_update_system(std::make_unique<CarPhysics>());
-    systems.register_fixed_update_system(std::make_unique<MazeTraversal>());
-    systems.register_fixed_update_system(std::make_unique<LoopDetection>());
-    systems.register_fixed_update_system(std::make_unique<HandleCollisions>());
-    systems.register_fixed_update_system(
-        std::make_unique<RebuildPhotoReveal>());
-
     systems.register_update_system(std::make_unique<HandleCameraControls>());
     systems.register_update_system(std::make_unique<HandleShopInput>());
-    systems.register_update_system(std::make_unique<SpawnNewCars>());
-    systems.register_update_system(std::make_unique<UpdateCarUpgrades>());
-    systems.register_update_system(std::make_unique<RevealFogOfWar>());
-    systems.register_update_system(
-        std::make_unique<AutoRevealUnreachableFog>());
-    systems.register_update_system(std::make_unique<DiscoverySystem>());
+    register_simulation_systems(systems, options);
 
     auto test_system = std::make_unique<TestSystem>();
     test_system_ptr = test_system.get();
@@ -121,12 +159,14 @@ void game() {
   }
 
   setup_game();
+  start_simulation(options);
 
   while (running && !raylib::WindowShouldClose()) {
     if (raylib::IsKeyPressed(raylib::KEY_ESCAPE)) {
       running = false;
     }
-    float dt = raylib::GetFrameTime();
+    float dt = options.deterministic ? game_constants::FIXED_TICK_SECONDS
+                                     : raylib::GetFrameTime();
     systems.run(dt);
 
     if (test_system_ptr && test_system_ptr->is_complete()) {
@@ -224,3 +264,48 @@ void run_test(const std::string &test_name, bool slow_mode) {
     }
   }
 }
+
+int run_headless(size_t ticks, const SimulationOptions &options) {
+  afterhours::SystemManager systems;
+  register_simulation_systems(systems, options);
+  setup_simulation();
+  start_simulation(options);
+
+  auto start = std::chrono::steady_clock::now();
+  // One fixed tick per run(), so headless runs keep the window's schedule
+  for (size_t tick = 0; tick < ticks; ++tick) {
+    systems.run(game_constants::FIXED_TICK_SECONDS);
+  }
+  double wall_seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  double sim_seconds =
+      static_cast<double>(ticks) * game_constants::FIXED_TICK_SECONDS;
+
+  RoadNetwork *road_network =
+      afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
+  FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
+  IsShopManager *shop =
+      afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
+  size_t segment_count = road_network ? road_network->segments.size() : 0;
+  size_t visited =
+      road_network ? segment_count - road_network->get_unvisited_count() : 0;
+
+  std::cout << fmt::format(
+      "Simulated {} ticks ({:.1f} s) in {:.3f} s wall: {:.1f} sim-s/s\n",
+      ticks, sim_seconds, wall_seconds,
+      wall_seconds > 0.0 ? sim_seconds / wall_seconds : 0.0);
+  std::cout << fmt::format(
+      "  {} cars, {}/{} segments visited, {} fog cells revealed, "
+      "{} pixels\n",
+      shop ? shop->car_count : 0, visited, segment_count,
+      fog ? fog->revealed_cells.count() : 0,
+      shop ? shop->pixels_collected : 0);
+  SimulationChecksum *checksum =
+      afterhours::EntityHelper::get_singleton_cmp<SimulationChecksum>();
+  if (options.deterministic && checksum) {
+    std::cout << fmt::format("  checksum after tick {}: {:016x}\n",
+                             checksum->tick, checksum->value);
+  }
+  return 0;
+}
@@ -3,5 +3,20 @@
 #include "external.h"
 #include "rl.h"
 
-void game();
+struct SimulationOptions {
+  // Offline progress applied once the world is set up
+  float catch_up_seconds{0.0f};
+  // Step exactly one fixed tick per frame, wait for background planning,
+  // and checksum the state every tick
+  bool deterministic{false};
+  bool log_checksums{false};
+  // Lanes the pooled car passes are spread over; 0 means one per core and
+  // 1 runs them serially. Results are the same either way.
+  unsigned worker_threads{0};
+};
+
+void game(const SimulationOptions &options = {});
 void run_test(const std::string &test_name, bool slow_mode = false);
+// Steps the simulation `ticks` fixed updates with no window and reports
+// how far ahead of real time it ran
+int run_headless(size_t ticks, const SimulationOptions &options = {});
@@ -16,6 +16,12 @@ constexpr int GRID_SIZE = GRID_WIDTH * GRID_HEIGHT;
 constexpr float WORLD_WIDTH = BRICK_START_X + (GRID_WIDTH * BRICK_CELL_SIZE);
 constexpr float WORLD_HEIGHT = BRICK_START_Y + (GRID_HEIGHT * BRICK_CELL_SIZE);
 
+// Road endpoints closer than this connect (square size is 12)
+constexpr float ROAD_CONNECTION_TOLERANCE = 15.0f;
+
+// afterhours steps fixed-update systems at 120 Hz
+constexpr float FIXED_TICK_SECONDS = 1.0f / 120.0f;
+
 inline int world_to_grid_x(float world_x) {
   return static_cast<int>((world_x - BRICK_START_X) / BRICK_CELL_SIZE);
 }
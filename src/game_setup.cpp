@@ -3,7 +3,9 @@
 #include "components.h"
 #include "eq.h"
 #include "game_constants.h"
+#include "mapped_file.h"
 #include "render_backend.h"
+#include "road_cache.h"
 #include "settings.h"
 #include <afterhours/ah.h>
 #include <afterhours/src/plugins/autolayout.h>
@@ -13,6 +15,7 @@
 #include <cmath>
 #include <limits>
 #include <nlohmann/json.hpp>
+#include <string_view>
 #include <unordered_map>
 
 template <typename Component, typename... Args>
@@ -33,14 +36,9 @@ static afterhours::Entity &get_sophie() {
   return sophie;
 }
 
-afterhours::Entity &make_car(vec2 position, vec2 velocity, float radius,
-                             int damage) {
-  afterhours::Entity &car = afterhours::EntityHelper::createEntity();
-  car.addComponent<Transform>(position, velocity,
-                              vec2{radius * 2.0f, radius * 2.0f});
-  car.enableTag(ColliderTag::Circle);
-  car.addComponent<CanDamage>(car.id, damage);
-
+size_t make_car(vec2 position, float radius, int damage) {
+  CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+  invariant(cars, "CarPool singleton not found");
   RoadNetwork *road_network =
       afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
   IsShopManager *shop =
@@ -50,57 +48,26 @@ afterhours::Entity &make_car(vec2 position, vec2 velocity, float radius,
   float speed = 250.0f;
   speed *= shop->get_car_speed_multiplier();
 
-  RoadFollowing &road_following = car.addComponent<RoadFollowing>(speed);
+  size_t car = cars->add(position, radius, speed, damage);
+  RoadFollowingState &road_following = cars->load(car);
 
   if (!road_network || !road_network->is_loaded ||
       road_network->segments.empty()) {
     road_following.current_segment_index = 0;
     road_following.progress_along_segment = 0.0f;
+    cars->store(car);
     return car;
   }
-  size_t nearest_segment = 0;
-  float min_dist_sq = std::numeric_limits<float>::max();
-
-  for (size_t i = 0; i < road_network->segments.size(); ++i) {
-    const RoadSegment &seg = road_network->segments[i];
-    vec2 seg_start = seg.start;
-    vec2 seg_end = seg.end;
-    vec2 seg_dir = {seg_end.x - seg_start.x, seg_end.y - seg_start.y};
-    float seg_len_sq = seg_dir.x * seg_dir.x + seg_dir.y * seg_dir.y;
-
-    if (seg_len_sq < 0.001f) {
-      float dist_sq = (position.x - seg_start.x) * (position.x - seg_start.x) +
-                      (position.y - seg_start.y) * (position.y - seg_start.y);
-      if (dist_sq < min_dist_sq) {
-        min_dist_sq = dist_sq;
-        nearest_segment = i;
-      }
-      continue;
-    }
-
-    float t =
-        std::max(0.0f, std::min(1.0f, ((position.x - seg_start.x) * seg_dir.x +
-                                       (position.y - seg_start.y) * seg_dir.y) /
-                                          seg_len_sq));
-
-    vec2 closest_point = {seg_start.x + t * seg_dir.x,
-                          seg_start.y + t * seg_dir.y};
-    float dist_sq =
-        (position.x - closest_point.x) * (position.x - closest_point.x) +
-        (position.y - closest_point.y) * (position.y - closest_point.y);
-
-    if (dist_sq < min_dist_sq) {
-      min_dist_sq = dist_sq;
-      nearest_segment = i;
-
-      vec2 seg_to_pos = {position.x - seg_start.x, position.y - seg_start.y};
-      float dot = seg_dir.x * seg_to_pos.x + seg_dir.y * seg_to_pos.y;
-      road_following.reverse_direction = (dot < 0.0f);
-    }
-  }
-
+  size_t nearest_segment = road_network->find_nearest_segment(position);
   road_following.current_segment_index = nearest_segment;
 
+  const RoadSegment &nearest = road_network->segments[nearest_segment];
+  float along = (nearest.end.x - nearest.start.x) *
+                    (position.x - nearest.start.x) +
+                (nearest.end.y - nearest.start.y) *
+                    (position.y - nearest.start.y);
+  road_following.reverse_direction = along < 0.0f;
+
   const RoadSegment &seg = road_network->segments[nearest_segment];
   vec2 seg_start = road_following.reverse_direction ? seg.end : seg.start;
   vec2 seg_end = road_following.reverse_direction ? seg.start : seg.end;
@@ -116,6 +83,7 @@ afterhours::Entity &make_car(vec2 position, vec2 velocity, float radius,
     road_following.progress_along_segment = 0.0f;
   }
 
+  cars->store(car);
   return car;
 }
 
@@ -129,9 +97,21 @@ afterhours::Entity &make_square(vec2 position, float size, float speed,
   return square;
 }
 
-static bool
-load_road_network_from_json(RoadNetwork &road_network,
-                            const std::filesystem::path &json_path) {
+static RoadType road_type_from_string(std::string_view road_type_str) {
+  if (road_type_str == "highway") {
+    return RoadType::Highway;
+  }
+  if (road_type_str == "primary") {
+    return RoadType::Primary;
+  }
+  if (road_type_str == "secondary") {
+    return RoadType::Secondary;
+  }
+  return RoadType::Residential;
+}
+
+static bool load_road_network_from_json_dom(
+    RoadNetwork &road_network, const std::filesystem::path &json_path) {
   std::ifstream ifs(json_path);
   if (!ifs.is_open()) {
     return false;
@@ -165,16 +145,8 @@ load_road_network_from_json(RoadNetwork &road_network,
       }
 
       if (seg_json.contains("road_type")) {
-        std::string road_type_str = seg_json["road_type"].get<std::string>();
-        if (road_type_str == "highway") {
-          segment.road_type = RoadType::Highway;
-        } else if (road_type_str == "primary") {
-          segment.road_type = RoadType::Primary;
-        } else if (road_type_str == "secondary") {
-          segment.road_type = RoadType::Secondary;
-        } else {
-          segment.road_type = RoadType::Residential;
-        }
+        segment.road_type =
+            road_type_from_string(seg_json["road_type"].get<std::string>());
       } else {
         segment.road_type = RoadType::Residential;
       }
@@ -191,6 +163,219 @@ load_road_network_from_json(RoadNetwork &road_network,
   }
 }
 
+// Tracks where the parser is in {"segments": [{"start": {"x", "y"}, ...}]}
+// and writes each finished segment straight into the output
+struct RoadJsonSaxHandler : nlohmann::json_sax<nlohmann::json> {
+  enum class Field { Other, Segments, Start, End, Width, RoadType, X, Y };
+
+  MappedArray<RoadSegment> &segments;
+  int depth{0};
+  bool found_segments{false};
+  bool in_segments{false};
+  Field root_field{Field::Other};
+  Field segment_field{Field::Other};
+  Field point_field{Field::Other};
+  RoadSegment segment;
+  int start_fields{0};
+  int end_fields{0};
+  std::string error;
+
+  explicit RoadJsonSaxHandler(MappedArray<RoadSegment> &out) : segments(out) {}
+
+  bool number(double value) {
+    if (!in_segments) {
+      return true;
+    }
+    if (depth == 3 && segment_field == Field::Width) {
+      segment.width = static_cast<float>(value);
+      return true;
+    }
+    if (depth != 4 || (point_field != Field::X && point_field != Field::Y)) {
+      return true;
+    }
+    int bit = point_field == Field::X ? 1 : 2;
+    if (segment_field == Field::Start) {
+      (point_field == Field::X ? segment.start.x : segment.start.y) =
+          static_cast<float>(value);
+      start_fields |= bit;
+    } else if (segment_field == Field::End) {
+      (point_field == Field::X ? segment.end.x : segment.end.y) =
+          static_cast<float>(value);
+      end_fields |= bit;
+    }
+    return true;
+  }
+
+  bool null() override { return true; }
+  bool boolean(bool) override { return true; }
+  bool number_integer(number_integer_t val) override {
+    return number(static_cast<double>(val));
+  }
+  bool number_unsigned(number_unsigned_t val) override {
+    return number(static_cast<double>(val));
+  }
+  bool number_float(number_float_t val, const string_t &) override {
+    return number(val);
+  }
+  bool binary(binary_t &) override { return true; }
+
+  bool string(string_t &val) override {
+    if (in_segments && depth == 3 && segment_field == Field::RoadType) {
+      segment.road_type = road_type_from_string(val);
+    }
+    return true;
+  }
+
+  bool key(string_t &val) override {
+    if (depth == 1) {
+      root_field = val == "segments" ? Field::Segments : Field::Other;
+    } else if (in_segments && depth == 3) {
+      segment_field = segment_field_for(val);
+    } else if (in_segments && depth == 4) {
+      point_field = point_field_for(val);
+    }
+    return true;
+  }
+
+  static Field segment_field_for(std::string_view key) {
+    if (key == "start") {
+      return Field::Start;
+    }
+    if (key == "end") {
+      return Field::End;
+    }
+    if (key == "width") {
+      return Field::Width;
+    }
+    if (key == "road_type") {
+      return Field::RoadType;
+    }
+    return Field::Other;
+  }
+
+  static Field point_field_for(std::string_view key) {
+    if (key == "x") {
+      return Field::X;
+    }
+    if (key == "y") {
+      return Field::Y;
+    }
+    return Field::Other;
+  }
+
+  bool start_object(std::size_t) override {
+    depth++;
+    if (in_segments && depth == 3) {
+      segment = RoadSegment{};
+      segment_field = Field::Other;
+      start_fields = 0;
+      end_fields = 0;
+    } else if (in_segments && depth == 4) {
+      point_field = Field::Other;
+    }
+    return true;
+  }
+
+  bool end_object() override {
+    if (in_segments && depth == 3 && start_fields == 3 && end_fields == 3) {
+      segments.push_back(segment);
+    }
+    depth--;
+    return true;
+  }
+
+  bool start_array(std::size_t) override {
+    depth++;
+    if (depth == 2 && root_field == Field::Segments) {
+      found_segments = true;
+      in_segments = true;
+    }
+    return true;
+  }
+
+  bool end_array() override {
+    if (depth == 2) {
+      in_segments = false;
+    }
+    depth--;
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &ex) override {
+    error = ex.what();
+    return false;
+  }
+};
+
+bool load_road_network_from_json(RoadNetwork &road_network,
+                                 const std::filesystem::path &json_path,
+                                 RoadJsonLoadMode mode) {
+  if (mode == RoadJsonLoadMode::Dom) {
+    return load_road_network_from_json_dom(road_network, json_path);
+  }
+
+  MappedFile file;
+  if (!file.open(json_path)) {
+    return false;
+  }
+  std::string_view text(reinterpret_cast<const char *>(file.data()),
+                        file.size());
+
+  // Every segment has exactly one "start" key, so counting them first lets
+  // the output be allocated once at its final size
+  size_t expected_segments = 0;
+  for (size_t pos = text.find("\"start\""); pos != std::string_view::npos;
+       pos = text.find("\"start\"", pos + 7)) {
+    expected_segments++;
+  }
+
+  road_network.segments.clear();
+  road_network.segments.reserve(expected_segments);
+  RoadJsonSaxHandler handler(road_network.segments);
+  bool parsed =
+      nlohmann::json::sax_parse(text.data(), text.data() + text.size(),
+                                &handler);
+  if (!parsed || !handler.found_segments) {
+    if (!parsed) {
+      log_warn("Failed to parse road network JSON {}: {}", json_path.string(),
+               handler.error);
+    }
+    road_network.segments.clear();
+    return false;
+  }
+
+  road_network.visited_segments.assign(road_network.segments.size(), false);
+  road_network.is_loaded = true;
+  return true;
+}
+
+std::filesystem::path road_cache_path(const std::filesystem::path &json_path) {
+  return afterhours::files::get_save_path() / "road_cache" /
+         (json_path.stem().string() + ".roads");
+}
+
+bool load_road_network(RoadNetwork &road_network,
+                       const std::filesystem::path &json_path,
+                       float connection_tolerance) {
+  std::filesystem::path cache_path = road_cache_path(json_path);
+  if (road_cache::load(road_network, cache_path, json_path,
+                       connection_tolerance)) {
+    log_info("Mapped road cache {}", cache_path.string());
+    return true;
+  }
+  if (!load_road_network_from_json(road_network, json_path)) {
+    return false;
+  }
+  road_network.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+  road_network.build_connected_components(connection_tolerance);
+  if (road_cache::write(road_network, cache_path, json_path,
+                        connection_tolerance)) {
+    log_info("Wrote road cache {}", cache_path.string());
+  }
+  return true;
+}
+
 static void create_simple_road_network(RoadNetwork &road_network) {
   road_network.segments.clear();
 
@@ -323,55 +508,20 @@ static void spawn_pois(RoadNetwork *road_network) {
            landmark_count, city_count);
 }
 
-void setup_game() {
+void setup_simulation() {
   afterhours::Entity &sophie = get_sophie();
 
   addIfMissing<IsShopManager>(sophie, 100, 1, 100);
   addIfMissing<IsPhotoReveal>(sophie, game_constants::BRICK_CELL_SIZE);
   addIfMissing<BrickGrid>(sophie);
   addIfMissing<RoadNetwork>(sophie);
+  addIfMissing<CarPool>(sophie);
+  addIfMissing<SimulationWorkers>(sophie);
+  addIfMissing<ExplorationPool>(sophie);
+  addIfMissing<CoverageRouting>(sophie);
+  addIfMissing<RoadChunkStreaming>(sophie);
   addIfMissing<FogOfWar>(sophie);
-  addIfMissing<afterhours::camera::HasCamera>(sophie);
-
-  afterhours::camera::HasCamera *camera =
-      afterhours::EntityHelper::get_singleton_cmp<
-          afterhours::camera::HasCamera>();
-  invariant(camera, "HasCamera singleton not found");
-  camera->set_position({game_constants::WORLD_WIDTH * 0.5f,
-                        game_constants::WORLD_HEIGHT * 0.5f});
-  camera->set_offset({game_constants::WORLD_WIDTH * 0.5f,
-                      game_constants::WORLD_HEIGHT * 0.5f});
-  camera->set_zoom(0.75f);
-
-  IsPhotoReveal *photo_reveal =
-      afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
-  invariant(photo_reveal, "IsPhotoReveal singleton not found");
-  if (photo_reveal->is_loaded) {
-    return;
-  }
-  std::filesystem::path photo_path = afterhours::files::get_resource_path(
-      "images/photos", "test_photo_500x500.png");
-  photo_reveal->photo_texture =
-      render_backend::LoadTexture(photo_path.string().c_str());
-  render_backend::SetTextureFilter(photo_reveal->photo_texture,
-                                   raylib::TEXTURE_FILTER_POINT);
-
-  std::filesystem::path vs_path = afterhours::files::get_resource_path(
-      "shaders", "photo_reveal_vertex.glsl");
-  std::filesystem::path fs_path = afterhours::files::get_resource_path(
-      "shaders", "photo_reveal_fragment.glsl");
-  photo_reveal->mask_shader = render_backend::LoadShader(
-      vs_path.string().c_str(), fs_path.string().c_str());
-
-  if (photo_reveal->mask_shader.id != 0) {
-    photo_reveal->mask_shader_mask_loc = render_backend::GetShaderLocation(
-        photo_reveal->mask_shader, "maskTexture");
-    photo_reveal->mask_shader_mask_scale_loc =
-        render_backend::GetShaderLocation(photo_reveal->mask_shader,
-                                          "maskScale");
-  }
-
-  photo_reveal->is_loaded = true;
+  addIfMissing<SimulationChecksum>(sophie);
 
   RoadNetwork *road_network =
       afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
@@ -381,23 +531,20 @@ void setup_game() {
   }
   std::filesystem::path nyc_roads_path =
       afterhours::files::get_resource_path("", "nyc_roads.json");
-  if (!load_road_network_from_json(*road_network, nyc_roads_path)) {
+  // Use tolerance matching road width (square size = 12.0, so ~15.0 for
+  // connections)
+  float connection_tolerance = game_constants::ROAD_CONNECTION_TOLERANCE;
+  if (!load_road_network(*road_network, nyc_roads_path,
+                         connection_tolerance)) {
     log_info("NYC roads not found, using procedural road network");
     create_simple_road_network(*road_network);
+    road_network->build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+    road_network->build_connected_components(connection_tolerance);
   } else {
     log_info("Loaded NYC road network with {} segments",
              road_network->segments.size());
   }
 
-  // Build connected components
-  // Use tolerance matching road width (square size = 12.0, so ~15.0 for
-  // connections)
-  if (road_network->segments.empty()) {
-    spawn_pois(road_network);
-    return;
-  }
-
-  road_network->build_connected_components(15.0f);
   if (road_network->segments.empty()) {
     spawn_pois(road_network);
     return;
@@ -405,7 +552,7 @@ void setup_game() {
 
   road_network->current_component_id = road_network->get_component_id(0);
   log_info("Built {} connected components, starting in component {}",
-           road_network->components.size(), road_network->current_component_id);
+           road_network->component_count(), road_network->current_component_id);
 
   spawn_pois(road_network);
 
@@ -437,3 +584,50 @@ void setup_game() {
   make_square(square_start_position, square_size, square_speed,
               initial_segment_index);
 }
+
+void setup_game() {
+  setup_simulation();
+
+  afterhours::Entity &sophie = get_sophie();
+  addIfMissing<afterhours::camera::HasCamera>(sophie);
+
+  afterhours::camera::HasCamera *camera =
+      afterhours::EntityHelper::get_singleton_cmp<
+          afterhours::camera::HasCamera>();
+  invariant(camera, "HasCamera singleton not found");
+  camera->set_position({game_constants::WORLD_WIDTH * 0.5f,
+                        game_constants::WORLD_HEIGHT * 0.5f});
+  camera->set_offset({game_constants::WORLD_WIDTH * 0.5f,
+                      game_constants::WORLD_HEIGHT * 0.5f});
+  camera->set_zoom(0.75f);
+
+  IsPhotoReveal *photo_reveal =
+      afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
+  invariant(photo_reveal, "IsPhotoReveal singleton not found");
+  if (photo_reveal->is_loaded) {
+    return;
+  }
+  std::filesystem::path photo_path = afterhours::files::get_resource_path(
+      "images/photos", "test_photo_500x500.png");
+  photo_reveal->photo_texture =
+      render_backend::LoadTexture(photo_path.string().c_str());
+  render_backend::SetTextureFilter(photo_reveal->photo_texture,
+                                   raylib::TEXTURE_FILTER_POINT);
+
+  std::filesystem::path vs_path = afterhours::files::get_resource_path(
+      "shaders", "photo_reveal_vertex.glsl");
+  std::filesystem::path fs_path = afterhours::files::get_resource_path(
+      "shaders", "photo_reveal_fragment.glsl");
+  photo_reveal->mask_shader = render_backend::LoadShader(
+      vs_path.string().c_str(), fs_path.string().c_str());
+
+  if (photo_reveal->mask_shader.id != 0) {
+    photo_reveal->mask_shader_mask_loc = render_backend::GetShaderLocation(
+        photo_reveal->mask_shader, "maskTexture");
+    photo_reveal->mask_shader_mask_scale_loc =
+        render_backend::GetShaderLocation(photo_reveal->mask_shader,
+                                          "maskScale");
+  }
+
+  photo_reveal->is_loaded = true;
+}
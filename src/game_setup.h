@@ -3,10 +3,28 @@
 #include "components.h"
 #include <afterhours/ah.h>
 
-afterhours::Entity &make_car(vec2 position, vec2 velocity, float radius,
-                             int damage);
+// Adds a car to the CarPool on the road nearest position; returns its index
+size_t make_car(vec2 position, float radius, int damage);
 
 afterhours::Entity &make_square(vec2 position, float size, float speed,
                                 size_t initial_segment_index = 0);
 
+// Streaming builds segments from parser events without a DOM; Dom is the
+// original loader, kept for comparison
+enum class RoadJsonLoadMode { Streaming, Dom };
+
+bool load_road_network_from_json(
+    RoadNetwork &road_network, const std::filesystem::path &json_path,
+    RoadJsonLoadMode mode = RoadJsonLoadMode::Streaming);
+
+std::filesystem::path road_cache_path(const std::filesystem::path &json_path);
+
+// Maps the binary cache when it matches json_path, otherwise parses the JSON,
+// builds the graph and components, and refreshes the cache
+bool load_road_network(RoadNetwork &road_network,
+                       const std::filesystem::path &json_path,
+                       float connection_tolerance);
+
+// Singletons, roads and the first car; loads nothing that needs a window
+void setup_simulation();
 void setup_game();
@@ -7,14 +7,78 @@ backward::SignalHandling sh;
 
 #include "argh.h"
 #include "game.h"
+#include "game_setup.h"
+#include "osm_import.h"
 #include "preload.h"
+#include "rl.h"
+#include "road_cache.h"
 #include "settings.h"
+#include "sim_random.h"
+#include "testing/bench_macros.h"
+#include "testing/benchmarks/all_benchmarks.h"
 #include "testing/test_macros.h"
 #include "testing/tests/all_tests.h"
+#include <cmath>
 #include <iostream>
 
 using namespace afterhours;
 
+static int import_osm(argh::parser &cmdl, const std::string &pbf_path) {
+  std::string output_path;
+  if (!(cmdl({"--output"}) >> output_path)) {
+    std::cout << "--import-osm needs --output <roads.json>\n";
+    return 1;
+  }
+
+  OsmImportOptions options;
+  if (cmdl["--all-highways"]) {
+    options.filter = OsmHighwayFilter::All;
+  }
+  cmdl({"--threads"}, 0u) >> options.thread_count;
+  std::string bbox;
+  if (cmdl({"--bbox"}) >> bbox) {
+    GeoBounds crop;
+    if (std::sscanf(bbox.c_str(), "%lf,%lf,%lf,%lf", &crop.min_lat,
+                    &crop.min_lon, &crop.max_lat, &crop.max_lon) != 4) {
+      std::cout << "--bbox expects min_lat,min_lon,max_lat,max_lon\n";
+      return 1;
+    }
+    options.crop = crop;
+  }
+
+  // raylib logs every inflated block at info level
+  raylib::SetTraceLogLevel(raylib::LOG_WARNING);
+  Preload::get().init_headless();
+
+  auto start = std::chrono::steady_clock::now();
+  RoadNetwork road_network;
+  OsmImportStats stats;
+  if (!import_osm_pbf(road_network, pbf_path, options, &stats)) {
+    return 1;
+  }
+  double import_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  std::cout << fmt::format("Imported {} segments from {} ways ({} nodes, {} "
+                           "blocks) in {:.0f} ms\n",
+                           road_network.segments.size(), stats.ways,
+                           stats.nodes, stats.blocks, import_ms);
+
+  if (!write_road_network_json(road_network, stats.bounds, output_path)) {
+    return 1;
+  }
+
+  // Prime the binary cache so the first launch maps it straight away
+  float connection_tolerance = game_constants::ROAD_CONNECTION_TOLERANCE;
+  road_network.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+  road_network.build_connected_components(connection_tolerance);
+  road_cache::write(road_network, road_cache_path(output_path), output_path,
+                    connection_tolerance);
+  std::cout << fmt::format("Wrote {} ({} components)\n", output_path,
+                           road_network.component_count());
+  return 0;
+}
+
 int main(int argc, char *argv[]) {
   argh::parser cmdl(argc, argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
 
@@ -31,9 +95,88 @@ int main(int argc, char *argv[]) {
     std::cout << "  --run-test <name>            Run a specific test\n";
     std::cout
         << "  --slow-test                  Run test in slow mode (visible)\n";
+    std::cout
+        << "  --list-benchmarks            List all available benchmarks\n";
+    std::cout << "  --run-benchmark <name>       Run a benchmark without a "
+                 "window\n";
+    std::cout << "  --catch-up <seconds>         Apply this much offline "
+                 "progress on start\n";
+    std::cout << "  --seed <n>                   Seed every random choice and "
+                 "run deterministically\n";
+    std::cout << "  --fixed-dt                   Step one fixed tick per frame "
+                 "and checksum each\n";
+    std::cout << "  --log-checksums              Log the state checksum every "
+                 "fixed tick\n";
+    std::cout << "  --workers <n>                Simulation threads (default: "
+                 "all cores, 1 is serial)\n";
+    std::cout << "  --headless                   Run the simulation without a "
+                 "window\n";
+    std::cout << "    --ticks <n>                Fixed updates to run\n";
+    std::cout << "    --sim-seconds <s>          Or simulated seconds to run\n";
+    std::cout << "  --import-osm <file.osm.pbf>  Convert an OSM extract to a "
+                 "road json\n";
+    std::cout << "    --output <roads.json>      Where to write it\n";
+    std::cout << "    --bbox <s,w,n,e>           Only keep roads inside these "
+                 "lat/lon bounds\n";
+    std::cout << "    --all-highways             Keep every highway=* way, "
+                 "not just drivable ones\n";
+    std::cout << "    --threads <n>              Decoder threads (default: "
+                 "all cores)\n";
     return 0;
   }
 
+  if (cmdl["--list-benchmarks"]) {
+    BenchmarkRegistry &registry = BenchmarkRegistry::get();
+    std::cout << "Available benchmarks:\n";
+    for (const auto &[name, func] : registry.benchmarks) {
+      std::cout << "  - " << name << "\n";
+    }
+    return 0;
+  }
+
+  std::string pbf_path;
+  if (cmdl({"--import-osm"}) >> pbf_path) {
+    return import_osm(cmdl, pbf_path);
+  }
+
+  // Seeded before anything draws from the engine, benchmarks included
+  SimulationOptions options;
+  uint32_t seed = 0;
+  if (cmdl({"--seed"}) >> seed) {
+    SimRandom::seed(seed);
+    options.deterministic = true;
+  }
+  options.deterministic = options.deterministic || cmdl["--fixed-dt"];
+  options.log_checksums = cmdl["--log-checksums"];
+  cmdl({"--catch-up"}, 0.0f) >> options.catch_up_seconds;
+  cmdl({"--workers"}, 0u) >> options.worker_threads;
+
+  std::string benchmark_name;
+  if (cmdl({"--run-benchmark"}) >> benchmark_name) {
+    BenchmarkRegistry &registry = BenchmarkRegistry::get();
+    auto it = registry.benchmarks.find(benchmark_name);
+    if (it == registry.benchmarks.end()) {
+      std::cout << "Benchmark '" << benchmark_name << "' not found\n";
+      return 1;
+    }
+    Preload::get().init_headless();
+    return it->second();
+  }
+
+  if (cmdl["--headless"]) {
+    size_t ticks = 0;
+    double sim_seconds = 0.0;
+    if (cmdl({"--sim-seconds"}) >> sim_seconds) {
+      ticks = static_cast<size_t>(
+          std::ceil(sim_seconds / game_constants::FIXED_TICK_SECONDS));
+    } else if (!(cmdl({"--ticks"}) >> ticks)) {
+      std::cout << "--headless needs --ticks <n> or --sim-seconds <s>\n";
+      return 1;
+    }
+    Preload::get().init_headless();
+    return run_headless(ticks, options);
+  }
+
   if (cmdl["--list-tests"]) {
     TestRegistry &registry = TestRegistry::get();
     std::cout << "Available tests:\n";
@@ -76,7 +219,7 @@ int main(int argc, char *argv[]) {
       .make_singleton();
   Settings::get().refresh_settings();
 
-  game();
+  game(options);
 
   Settings::get().write_save_file();
 
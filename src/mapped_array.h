@@ -0,0 +1,113 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Vector-like array that either owns its elements or views a range of a
+// MappedFile. Views are zero-copy; anything that changes the size first
+// copies the range into owned storage.
+template <typename T> struct MappedArray {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "MappedArray elements are read straight from disk");
+
+  MappedArray() = default;
+  MappedArray(std::initializer_list<T> values) : owned(values) {}
+
+  static MappedArray view(std::shared_ptr<MappedFile> file, T *first,
+                          size_t count) {
+    MappedArray array;
+    array.file = std::move(file);
+    array.view_data = first;
+    array.view_size = count;
+    return array;
+  }
+
+  bool is_view() const { return file != nullptr; }
+  // File backing a view, null for owned storage
+  const std::shared_ptr<MappedFile> &mapping() const { return file; }
+
+  T *data() { return is_view() ? view_data : owned.data(); }
+  const T *data() const { return is_view() ? view_data : owned.data(); }
+  size_t size() const { return is_view() ? view_size : owned.size(); }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return is_view() ? view_size : owned.capacity(); }
+
+  T &operator[](size_t i) { return data()[i]; }
+  const T &operator[](size_t i) const { return data()[i]; }
+  T &front() { return data()[0]; }
+  const T &front() const { return data()[0]; }
+  T &back() { return data()[size() - 1]; }
+  const T &back() const { return data()[size() - 1]; }
+
+  T *begin() { return data(); }
+  T *end() { return data() + size(); }
+  const T *begin() const { return data(); }
+  const T *end() const { return data() + size(); }
+
+  void push_back(const T &value) {
+    detach();
+    owned.push_back(value);
+  }
+
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    detach();
+    return owned.emplace_back(std::forward<Args>(args)...);
+  }
+
+  void resize(size_t count) {
+    detach();
+    owned.resize(count);
+  }
+
+  void resize(size_t count, const T &value) {
+    detach();
+    owned.resize(count, value);
+  }
+
+  void assign(size_t count, const T &value) {
+    release();
+    owned.assign(count, value);
+  }
+
+  void reserve(size_t count) {
+    detach();
+    owned.reserve(count);
+  }
+
+  void shrink_to_fit() {
+    if (!is_view()) {
+      owned.shrink_to_fit();
+    }
+  }
+
+  void clear() {
+    release();
+    owned.clear();
+  }
+
+  // Copies a view into owned storage so writes cannot be lost when the
+  // mapping's pages are released
+  void make_owned() { detach(); }
+
+private:
+  void release() {
+    file.reset();
+    view_data = nullptr;
+    view_size = 0;
+  }
+
+  void detach() {
+    if (!is_view()) {
+      return;
+    }
+    owned.assign(view_data, view_data + view_size);
+    release();
+  }
+
+  std::vector<T> owned;
+  std::shared_ptr<MappedFile> file;
+  T *view_data{nullptr};
+  size_t view_size{0};
+};
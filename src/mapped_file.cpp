@@ -0,0 +1,169 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+
+// Kept out of the header so windows.h never meets raylib
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+// Whole pages covering [offset, offset + length)
+static bool page_range(size_t file_size, size_t page, size_t offset,
+                       size_t length, size_t &first, size_t &last) {
+  size_t end = std::min(file_size, offset + length);
+  if (offset >= end) {
+    return false;
+  }
+  first = offset / page * page;
+  last = std::min(file_size, (end + page - 1) / page * page);
+  return true;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::filesystem::path &path) {
+  close();
+  HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+  void *view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  file_handle = file;
+  mapping_handle = mapping;
+  bytes = static_cast<std::byte *>(view);
+  byte_count = static_cast<size_t>(file_size.QuadPart);
+  return true;
+}
+
+void MappedFile::close() {
+  if (bytes != nullptr) {
+    UnmapViewOfFile(bytes);
+  }
+  if (mapping_handle != nullptr) {
+    CloseHandle(mapping_handle);
+  }
+  if (file_handle != nullptr) {
+    CloseHandle(file_handle);
+  }
+  bytes = nullptr;
+  byte_count = 0;
+  file_handle = nullptr;
+  mapping_handle = nullptr;
+}
+
+size_t MappedFile::page_size() {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return static_cast<size_t>(info.dwPageSize);
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const {
+  size_t first = 0;
+  size_t last = 0;
+  if (!is_open() ||
+      !page_range(byte_count, page_size(), offset, length, first, last)) {
+    return;
+  }
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = bytes + first;
+  range.NumberOfBytes = last - first;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+  size_t first = 0;
+  size_t last = 0;
+  if (!is_open() ||
+      !page_range(byte_count, page_size(), offset, length, first, last)) {
+    return;
+  }
+  // Unlocking pages that were never locked trims them from the working set
+  VirtualUnlock(bytes + first, last - first);
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+  size_t length = static_cast<size_t>(info.st_size);
+  void *view =
+      mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+  bytes = static_cast<std::byte *>(view);
+  byte_count = length;
+  return true;
+}
+
+void MappedFile::close() {
+  if (bytes != nullptr) {
+    munmap(bytes, byte_count);
+  }
+  bytes = nullptr;
+  byte_count = 0;
+}
+
+size_t MappedFile::page_size() {
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const {
+  size_t first = 0;
+  size_t last = 0;
+  if (!is_open() ||
+      !page_range(byte_count, page_size(), offset, length, first, last)) {
+    return;
+  }
+  madvise(bytes + first, last - first, MADV_WILLNEED);
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+  size_t first = 0;
+  size_t last = 0;
+  if (!is_open() ||
+      !page_range(byte_count, page_size(), offset, length, first, last)) {
+    return;
+  }
+  madvise(bytes + first, last - first, MADV_DONTNEED);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+// Whole file mapped copy-on-write: reads come straight from the page cache
+// and writes stay private to this process.
+struct MappedFile {
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  void operator=(const MappedFile &) = delete;
+
+  bool open(const std::filesystem::path &path);
+  void close();
+
+  bool is_open() const { return bytes != nullptr; }
+  std::byte *data() const { return bytes; }
+  size_t size() const { return byte_count; }
+
+  // Paging hints for the pages covering [offset, offset + length). prefetch
+  // asks the OS to read them in ahead of use; release unmaps them, and they
+  // fault back in from the file on the next read (private writes are lost).
+  void prefetch(size_t offset, size_t length) const;
+  void release(size_t offset, size_t length) const;
+
+  static size_t page_size();
+
+private:
+  std::byte *bytes{nullptr};
+  size_t byte_count{0};
+#if defined(_WIN32)
+  void *file_handle{nullptr};
+  void *mapping_handle{nullptr};
+#endif
+};
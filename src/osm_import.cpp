@@ -0,0 +1,824 @@
+#include "osm_import.h"
+
+#include "log.h"
+#include "mapped_file.h"
+#include "rl.h"
+#include <atomic>
+#include <fmt/format.h>
+#include <thread>
+#include <unordered_set>
+
+// Minimal reader for the OSM PBF format
+// (https://wiki.openstreetmap.org/wiki/PBF_Format). Only the messages and
+// fields needed for road geometry are decoded; everything else is skipped.
+namespace osm_pbf {
+
+struct Reader {
+  const uint8_t *pos{nullptr};
+  const uint8_t *end{nullptr};
+  bool ok{true};
+
+  explicit Reader(std::string_view bytes)
+      : pos(reinterpret_cast<const uint8_t *>(bytes.data())),
+        end(reinterpret_cast<const uint8_t *>(bytes.data()) + bytes.size()) {}
+
+  bool at_end() const { return !ok || pos >= end; }
+
+  uint64_t varint() {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos >= end) {
+        ok = false;
+        return 0;
+      }
+      uint8_t byte = *pos++;
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return result;
+      }
+    }
+    ok = false;
+    return 0;
+  }
+
+  int64_t svarint() {
+    uint64_t value = varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  std::string_view bytes() {
+    uint64_t length = varint();
+    if (!ok || length > static_cast<uint64_t>(end - pos)) {
+      ok = false;
+      return {};
+    }
+    std::string_view view(reinterpret_cast<const char *>(pos),
+                          static_cast<size_t>(length));
+    pos += length;
+    return view;
+  }
+
+  // Reads the next field key; false once the message is used up
+  bool next(uint32_t &field, uint32_t &wire_type) {
+    if (at_end()) {
+      return false;
+    }
+    uint64_t key = varint();
+    field = static_cast<uint32_t>(key >> 3);
+    wire_type = static_cast<uint32_t>(key & 7);
+    return ok;
+  }
+
+  void skip(uint32_t wire_type) {
+    switch (wire_type) {
+    case 0:
+      varint();
+      break;
+    case 1:
+      advance(8);
+      break;
+    case 2:
+      bytes();
+      break;
+    case 5:
+      advance(4);
+      break;
+    default:
+      ok = false;
+      break;
+    }
+  }
+
+private:
+  void advance(size_t count) {
+    if (count > static_cast<size_t>(end - pos)) {
+      ok = false;
+      return;
+    }
+    pos += count;
+  }
+};
+
+template <typename Fn>
+static bool for_each_varint(std::string_view packed, Fn &&fn) {
+  Reader reader(packed);
+  while (!reader.at_end()) {
+    uint64_t value = reader.varint();
+    if (!reader.ok) {
+      return false;
+    }
+    fn(value);
+  }
+  return reader.ok;
+}
+
+template <typename Fn>
+static bool for_each_svarint(std::string_view packed, Fn &&fn) {
+  return for_each_varint(packed, [&fn](uint64_t value) {
+    fn(static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1));
+  });
+}
+
+using RaylibBuffer = std::unique_ptr<unsigned char, void (*)(void *)>;
+
+// Uncompressed contents of one blob; owns the buffer when it was inflated
+struct Block {
+  RaylibBuffer inflated{nullptr, raylib::MemFree};
+  std::string_view data;
+};
+
+static bool read_blob(std::string_view blob, Block &block, std::string &error) {
+  Reader reader(blob);
+  std::string_view zlib_data;
+  uint64_t raw_size = 0;
+  bool has_raw = false;
+  uint32_t field = 0;
+  uint32_t wire_type = 0;
+  while (reader.next(field, wire_type)) {
+    if (field == 1 && wire_type == 2) {
+      block.data = reader.bytes();
+      has_raw = true;
+    } else if (field == 2 && wire_type == 0) {
+      raw_size = reader.varint();
+    } else if (field == 3 && wire_type == 2) {
+      zlib_data = reader.bytes();
+    } else if (field >= 4 && field <= 7) {
+      error = "unsupported blob compression (only zlib and raw are handled)";
+      return false;
+    } else {
+      reader.skip(wire_type);
+    }
+  }
+  if (!reader.ok) {
+    error = "truncated blob";
+    return false;
+  }
+  if (has_raw) {
+    return true;
+  }
+  // raylib inflates raw deflate streams, so step over the two byte zlib
+  // header; the trailing checksum is never read
+  if (zlib_data.size() < 2) {
+    error = "blob has no data";
+    return false;
+  }
+  int inflated_size = 0;
+  block.inflated.reset(raylib::DecompressData(
+      reinterpret_cast<const unsigned char *>(zlib_data.data()) + 2,
+      static_cast<int>(zlib_data.size() - 2), &inflated_size));
+  if (!block.inflated || static_cast<uint64_t>(inflated_size) != raw_size) {
+    error = fmt::format("failed to inflate blob ({} of {} bytes)",
+                        inflated_size, raw_size);
+    return false;
+  }
+  block.data = std::string_view(
+      reinterpret_cast<const char *>(block.inflated.get()),
+      static_cast<size_t>(inflated_size));
+  return true;
+}
+
+struct PrimitiveBlock {
+  std::vector<std::string_view> strings;
+  std::vector<std::string_view> groups;
+  int64_t granularity{100};
+  int64_t lat_offset{0};
+  int64_t lon_offset{0};
+
+  double lat(int64_t value) const {
+    return 1e-9 * static_cast<double>(lat_offset + granularity * value);
+  }
+  double lon(int64_t value) const {
+    return 1e-9 * static_cast<double>(lon_offset + granularity * value);
+  }
+};
+
+static bool read_primitive_block(std::string_view data, PrimitiveBlock &out) {
+  Reader reader(data);
+  uint32_t field = 0;
+  uint32_t wire_type = 0;
+  while (reader.next(field, wire_type)) {
+    if (field == 1 && wire_type == 2) {
+      Reader table(reader.bytes());
+      while (table.next(field, wire_type)) {
+        if (field == 1 && wire_type == 2) {
+          out.strings.push_back(table.bytes());
+        } else {
+          table.skip(wire_type);
+        }
+      }
+      if (!table.ok) {
+        return false;
+      }
+    } else if (field == 2 && wire_type == 2) {
+      out.groups.push_back(reader.bytes());
+    } else if (field == 17 && wire_type == 0) {
+      out.granularity = static_cast<int64_t>(reader.varint());
+    } else if (field == 19 && wire_type == 0) {
+      out.lat_offset = static_cast<int64_t>(reader.varint());
+    } else if (field == 20 && wire_type == 0) {
+      out.lon_offset = static_cast<int64_t>(reader.varint());
+    } else {
+      reader.skip(wire_type);
+    }
+  }
+  return reader.ok;
+}
+
+struct HighwayStyle {
+  float base_width;
+  RoadType road_type;
+};
+
+// Widths from scripts/download_nyc_roads.py
+static HighwayStyle style_for(std::string_view highway) {
+  static const std::unordered_map<std::string_view, HighwayStyle> styles = {
+      {"motorway", {4.0f, RoadType::Highway}},
+      {"motorway_link", {3.5f, RoadType::Highway}},
+      {"trunk", {4.0f, RoadType::Highway}},
+      {"trunk_link", {3.5f, RoadType::Highway}},
+      {"primary", {3.5f, RoadType::Primary}},
+      {"primary_link", {3.0f, RoadType::Primary}},
+      {"secondary", {3.0f, RoadType::Secondary}},
+      {"secondary_link", {2.5f, RoadType::Secondary}},
+      {"tertiary", {2.5f, RoadType::Secondary}},
+      {"tertiary_link", {2.0f, RoadType::Secondary}},
+      {"residential", {2.0f, RoadType::Residential}},
+      {"unclassified", {2.0f, RoadType::Residential}},
+      {"service", {1.5f, RoadType::Residential}},
+  };
+  auto it = styles.find(highway);
+  if (it == styles.end()) {
+    return {2.0f, RoadType::Residential};
+  }
+  return it->second;
+}
+
+// osmnx's 'drive' filter: everything tagged highway except these, minus
+// areas and ways closed to cars
+static bool is_drivable(std::string_view highway, std::string_view area,
+                        std::string_view access,
+                        std::string_view motor_vehicle,
+                        std::string_view motorcar, std::string_view service) {
+  static const std::unordered_set<std::string_view> excluded_highways = {
+      "abandoned", "bridleway", "bus_guideway", "construction", "corridor",
+      "cycleway",  "elevator",  "escalator",    "footway",      "no",
+      "path",      "pedestrian", "planned",     "platform",     "proposed",
+      "raceway",   "razed",     "service",      "steps",        "track"};
+  static const std::unordered_set<std::string_view> excluded_services = {
+      "alley",   "driveway",      "emergency_access",
+      "parking", "parking_aisle", "private"};
+  return !excluded_highways.contains(highway) && area != "yes" &&
+         access != "private" && motor_vehicle != "no" && motorcar != "no" &&
+         !excluded_services.contains(service);
+}
+
+struct Way {
+  float width;
+  RoadType road_type;
+  uint32_t first_ref;
+  uint32_t ref_count;
+};
+
+struct BlockWays {
+  std::vector<Way> ways;
+  std::vector<int64_t> refs;
+  bool has_nodes{false};
+  std::string error;
+};
+
+static bool read_way(std::string_view message, const PrimitiveBlock &block,
+                     OsmHighwayFilter filter, BlockWays &out,
+                     std::vector<uint32_t> &keys,
+                     std::vector<uint32_t> &values) {
+  Reader reader(message);
+  std::string_view packed_refs;
+  keys.clear();
+  values.clear();
+  uint32_t field = 0;
+  uint32_t wire_type = 0;
+  while (reader.next(field, wire_type)) {
+    if (field == 2 && wire_type == 2) {
+      for_each_varint(reader.bytes(), [&keys](uint64_t value) {
+        keys.push_back(static_cast<uint32_t>(value));
+      });
+    } else if (field == 3 && wire_type == 2) {
+      for_each_varint(reader.bytes(), [&values](uint64_t value) {
+        values.push_back(static_cast<uint32_t>(value));
+      });
+    } else if (field == 8 && wire_type == 2) {
+      packed_refs = reader.bytes();
+    } else {
+      reader.skip(wire_type);
+    }
+  }
+  if (!reader.ok || keys.size() != values.size()) {
+    return false;
+  }
+
+  std::string_view highway, area, access, motor_vehicle, motorcar, service;
+  bool has_highway = false;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] >= block.strings.size() || values[i] >= block.strings.size()) {
+      return false;
+    }
+    std::string_view key = block.strings[keys[i]];
+    std::string_view value = block.strings[values[i]];
+    if (key == "highway") {
+      highway = value;
+      has_highway = true;
+    } else if (key == "area") {
+      area = value;
+    } else if (key == "access") {
+      access = value;
+    } else if (key == "motor_vehicle") {
+      motor_vehicle = value;
+    } else if (key == "motorcar") {
+      motorcar = value;
+    } else if (key == "service") {
+      service = value;
+    }
+  }
+  if (!has_highway) {
+    return true;
+  }
+  if (filter == OsmHighwayFilter::Drive &&
+      !is_drivable(highway, area, access, motor_vehicle, motorcar, service)) {
+    return true;
+  }
+
+  HighwayStyle style = style_for(highway);
+  Way way;
+  way.width = style.base_width * (12.0f / 1.5f);
+  way.road_type = style.road_type;
+  way.first_ref = static_cast<uint32_t>(out.refs.size());
+  int64_t ref = 0;
+  bool refs_ok = for_each_svarint(packed_refs, [&](int64_t delta) {
+    ref += delta;
+    out.refs.push_back(ref);
+  });
+  way.ref_count = static_cast<uint32_t>(out.refs.size() - way.first_ref);
+  if (!refs_ok) {
+    return false;
+  }
+  if (way.ref_count >= 2) {
+    out.ways.push_back(way);
+  } else {
+    out.refs.resize(way.first_ref);
+  }
+  return true;
+}
+
+static void collect_ways(std::string_view blob, OsmHighwayFilter filter,
+                         BlockWays &out) {
+  Block block;
+  PrimitiveBlock primitive;
+  if (!read_blob(blob, block, out.error)) {
+    return;
+  }
+  if (!read_primitive_block(block.data, primitive)) {
+    out.error = "malformed primitive block";
+    return;
+  }
+  std::vector<uint32_t> keys;
+  std::vector<uint32_t> values;
+  for (std::string_view group : primitive.groups) {
+    Reader reader(group);
+    uint32_t field = 0;
+    uint32_t wire_type = 0;
+    while (reader.next(field, wire_type)) {
+      if ((field == 1 || field == 2) && wire_type == 2) {
+        out.has_nodes = true;
+        reader.skip(wire_type);
+      } else if (field == 3 && wire_type == 2) {
+        if (!read_way(reader.bytes(), primitive, filter, out, keys, values)) {
+          out.error = "malformed way";
+          return;
+        }
+      } else {
+        reader.skip(wire_type);
+      }
+    }
+    if (!reader.ok) {
+      out.error = "malformed primitive group";
+      return;
+    }
+  }
+}
+
+// Node ids the ways refer to, sorted, with a coordinate slot for each
+struct NeededNodes {
+  std::vector<int64_t> ids;
+  std::vector<double> lat;
+  std::vector<double> lon;
+  std::vector<uint8_t> found;
+
+  size_t index_of(int64_t id, size_t &hint) const {
+    // Ids inside a block are usually ascending, so search forward from the
+    // previous hit before falling back to the whole range
+    auto first = ids.begin();
+    if (hint < ids.size() && ids[hint] <= id) {
+      first += static_cast<std::ptrdiff_t>(hint);
+    }
+    auto it = std::lower_bound(first, ids.end(), id);
+    if (it == ids.end() || *it != id) {
+      return SIZE_MAX;
+    }
+    hint = static_cast<size_t>(it - ids.begin());
+    return hint;
+  }
+
+  void store(int64_t id, double node_lat, double node_lon, size_t &hint) {
+    size_t index = index_of(id, hint);
+    if (index == SIZE_MAX) {
+      return;
+    }
+    // Every id occurs once in a file, so threads never share a slot
+    lat[index] = node_lat;
+    lon[index] = node_lon;
+    found[index] = 1;
+  }
+};
+
+static bool read_dense_nodes(std::string_view message,
+                             const PrimitiveBlock &block, NeededNodes &needed,
+                             size_t &hint) {
+  Reader reader(message);
+  std::string_view packed_ids, packed_lats, packed_lons;
+  uint32_t field = 0;
+  uint32_t wire_type = 0;
+  while (reader.next(field, wire_type)) {
+    if (field == 1 && wire_type == 2) {
+      packed_ids = reader.bytes();
+    } else if (field == 8 && wire_type == 2) {
+      packed_lats = reader.bytes();
+    } else if (field == 9 && wire_type == 2) {
+      packed_lons = reader.bytes();
+    } else {
+      reader.skip(wire_type);
+    }
+  }
+  if (!reader.ok) {
+    return false;
+  }
+
+  Reader ids(packed_ids);
+  Reader lats(packed_lats);
+  Reader lons(packed_lons);
+  int64_t id = 0;
+  int64_t lat = 0;
+  int64_t lon = 0;
+  while (!ids.at_end()) {
+    id += ids.svarint();
+    lat += lats.svarint();
+    lon += lons.svarint();
+    if (!ids.ok || !lats.ok || !lons.ok) {
+      return false;
+    }
+    needed.store(id, block.lat(lat), block.lon(lon), hint);
+  }
+  return true;
+}
+
+static bool read_node(std::string_view message, const PrimitiveBlock &block,
+                      NeededNodes &needed, size_t &hint) {
+  Reader reader(message);
+  int64_t id = 0;
+  int64_t lat = 0;
+  int64_t lon = 0;
+  uint32_t field = 0;
+  uint32_t wire_type = 0;
+  while (reader.next(field, wire_type)) {
+    if (field == 1 && wire_type == 0) {
+      id = reader.svarint();
+    } else if (field == 8 && wire_type == 0) {
+      lat = reader.svarint();
+    } else if (field == 9 && wire_type == 0) {
+      lon = reader.svarint();
+    } else {
+      reader.skip(wire_type);
+    }
+  }
+  if (!reader.ok) {
+    return false;
+  }
+  needed.store(id, block.lat(lat), block.lon(lon), hint);
+  return true;
+}
+
+static void collect_nodes(std::string_view blob, NeededNodes &needed,
+                          std::string &error) {
+  Block block;
+  PrimitiveBlock primitive;
+  if (!read_blob(blob, block, error)) {
+    return;
+  }
+  if (!read_primitive_block(block.data, primitive)) {
+    error = "malformed primitive block";
+    return;
+  }
+  size_t hint = 0;
+  for (std::string_view group : primitive.groups) {
+    Reader reader(group);
+    uint32_t field = 0;
+    uint32_t wire_type = 0;
+    while (reader.next(field, wire_type)) {
+      bool node_ok = true;
+      if (field == 1 && wire_type == 2) {
+        node_ok = read_node(reader.bytes(), primitive, needed, hint);
+      } else if (field == 2 && wire_type == 2) {
+        node_ok = read_dense_nodes(reader.bytes(), primitive, needed, hint);
+      } else {
+        reader.skip(wire_type);
+      }
+      if (!node_ok) {
+        error = "malformed node";
+        return;
+      }
+    }
+    if (!reader.ok) {
+      error = "malformed primitive group";
+      return;
+    }
+  }
+}
+
+static bool check_header_block(std::string_view blob, std::string &error) {
+  Block block;
+  if (!read_blob(blob, block, error)) {
+    return false;
+  }
+  Reader reader(block.data);
+  uint32_t field = 0;
+  uint32_t wire_type = 0;
+  while (reader.next(field, wire_type)) {
+    if (field == 4 && wire_type == 2) {
+      std::string_view feature = reader.bytes();
+      if (feature != "OsmSchema-V0.6" && feature != "DenseNodes") {
+        error = fmt::format("unsupported required feature '{}'", feature);
+        return false;
+      }
+    } else {
+      reader.skip(wire_type);
+    }
+  }
+  if (!reader.ok) {
+    error = "malformed header block";
+    return false;
+  }
+  return true;
+}
+
+// Splits the file into OSMData blobs without inflating anything
+static bool split_blobs(std::string_view file,
+                        std::vector<std::string_view> &data_blobs,
+                        std::string &error) {
+  size_t pos = 0;
+  bool seen_header = false;
+  while (pos < file.size()) {
+    if (file.size() - pos < 4) {
+      error = "truncated blob header length";
+      return false;
+    }
+    const uint8_t *length_bytes =
+        reinterpret_cast<const uint8_t *>(file.data() + pos);
+    size_t header_length = (static_cast<size_t>(length_bytes[0]) << 24) |
+                           (static_cast<size_t>(length_bytes[1]) << 16) |
+                           (static_cast<size_t>(length_bytes[2]) << 8) |
+                           static_cast<size_t>(length_bytes[3]);
+    pos += 4;
+    if (header_length > file.size() - pos) {
+      error = "truncated blob header";
+      return false;
+    }
+
+    Reader header(file.substr(pos, header_length));
+    pos += header_length;
+    std::string_view type;
+    uint64_t data_size = 0;
+    uint32_t field = 0;
+    uint32_t wire_type = 0;
+    while (header.next(field, wire_type)) {
+      if (field == 1 && wire_type == 2) {
+        type = header.bytes();
+      } else if (field == 3 && wire_type == 0) {
+        data_size = header.varint();
+      } else {
+        header.skip(wire_type);
+      }
+    }
+    if (!header.ok || data_size > file.size() - pos) {
+      error = "truncated blob";
+      return false;
+    }
+
+    std::string_view blob = file.substr(pos, static_cast<size_t>(data_size));
+    pos += static_cast<size_t>(data_size);
+    if (type == "OSMHeader") {
+      if (!check_header_block(blob, error)) {
+        return false;
+      }
+      seen_header = true;
+    } else if (type == "OSMData") {
+      data_blobs.push_back(blob);
+    }
+  }
+  if (!seen_header) {
+    error = "missing OSMHeader block";
+    return false;
+  }
+  return true;
+}
+
+template <typename Fn>
+static void parallel_for(size_t count, unsigned thread_count, Fn &&fn) {
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < thread_count && t < count; ++t) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+}
+
+} // namespace osm_pbf
+
+bool import_osm_pbf(RoadNetwork &road_network,
+                    const std::filesystem::path &pbf_path,
+                    const OsmImportOptions &options, OsmImportStats *stats) {
+  using namespace osm_pbf;
+
+  MappedFile file;
+  if (!file.open(pbf_path)) {
+    log_warn("Could not open OSM extract {}", pbf_path.string());
+    return false;
+  }
+  std::string_view bytes(reinterpret_cast<const char *>(file.data()),
+                         file.size());
+
+  std::string error;
+  std::vector<std::string_view> blobs;
+  if (!split_blobs(bytes, blobs, error)) {
+    log_warn("{}: {}", pbf_path.string(), error);
+    return false;
+  }
+
+  unsigned thread_count = options.thread_count;
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Pass 1: highway ways and the node ids they use
+  std::vector<BlockWays> block_ways(blobs.size());
+  parallel_for(blobs.size(), thread_count, [&](size_t i) {
+    collect_ways(blobs[i], options.filter, block_ways[i]);
+  });
+
+  NeededNodes needed;
+  size_t way_count = 0;
+  for (const BlockWays &block : block_ways) {
+    if (!block.error.empty()) {
+      log_warn("{}: {}", pbf_path.string(), block.error);
+      return false;
+    }
+    way_count += block.ways.size();
+    needed.ids.insert(needed.ids.end(), block.refs.begin(), block.refs.end());
+  }
+  std::sort(needed.ids.begin(), needed.ids.end());
+  needed.ids.erase(std::unique(needed.ids.begin(), needed.ids.end()),
+                   needed.ids.end());
+  needed.lat.assign(needed.ids.size(), 0.0);
+  needed.lon.assign(needed.ids.size(), 0.0);
+  needed.found.assign(needed.ids.size(), 0);
+
+  // Pass 2: coordinates, re-reading only the blocks that held nodes
+  std::vector<size_t> node_blocks;
+  for (size_t i = 0; i < blobs.size(); ++i) {
+    if (block_ways[i].has_nodes) {
+      node_blocks.push_back(i);
+    }
+  }
+  std::vector<std::string> node_errors(node_blocks.size());
+  parallel_for(node_blocks.size(), thread_count, [&](size_t i) {
+    collect_nodes(blobs[node_blocks[i]], needed, node_errors[i]);
+  });
+  for (const std::string &node_error : node_errors) {
+    if (!node_error.empty()) {
+      log_warn("{}: {}", pbf_path.string(), node_error);
+      return false;
+    }
+  }
+
+  // Keep the node pairs that resolved (extracts clip ways at the border)
+  // and fit the crop, then project them over their own bounds
+  struct Pair {
+    uint32_t a;
+    uint32_t b;
+    float width;
+    RoadType road_type;
+  };
+  std::vector<Pair> pairs;
+  GeoBounds bounds{std::numeric_limits<double>::max(),
+                   std::numeric_limits<double>::lowest(),
+                   std::numeric_limits<double>::max(),
+                   std::numeric_limits<double>::lowest()};
+  auto include = [&](uint32_t index) {
+    bounds.min_lat = std::min(bounds.min_lat, needed.lat[index]);
+    bounds.max_lat = std::max(bounds.max_lat, needed.lat[index]);
+    bounds.min_lon = std::min(bounds.min_lon, needed.lon[index]);
+    bounds.max_lon = std::max(bounds.max_lon, needed.lon[index]);
+  };
+  auto usable = [&](size_t index) {
+    return index != SIZE_MAX && needed.found[index] &&
+           (!options.crop ||
+            options.crop->contains(needed.lat[index], needed.lon[index]));
+  };
+  for (const BlockWays &block : block_ways) {
+    size_t hint = 0;
+    for (const Way &way : block.ways) {
+      size_t previous = needed.index_of(block.refs[way.first_ref], hint);
+      for (uint32_t r = 1; r < way.ref_count; ++r) {
+        size_t current = needed.index_of(block.refs[way.first_ref + r], hint);
+        if (usable(previous) && usable(current) && previous != current) {
+          pairs.push_back({static_cast<uint32_t>(previous),
+                           static_cast<uint32_t>(current), way.width,
+                           way.road_type});
+          include(static_cast<uint32_t>(previous));
+          include(static_cast<uint32_t>(current));
+        }
+        previous = current;
+      }
+    }
+  }
+  if (pairs.empty()) {
+    log_warn("{}: no roads matched the filter", pbf_path.string());
+    return false;
+  }
+
+  road_network.segments.clear();
+  road_network.segments.reserve(pairs.size());
+  for (const Pair &pair : pairs) {
+    RoadSegment segment;
+    segment.start =
+        lat_lon_to_game_coords(needed.lat[pair.a], needed.lon[pair.a], bounds);
+    segment.end =
+        lat_lon_to_game_coords(needed.lat[pair.b], needed.lon[pair.b], bounds);
+    segment.width = pair.width;
+    segment.road_type = pair.road_type;
+    road_network.segments.push_back(segment);
+  }
+  road_network.visited_segments.assign(road_network.segments.size(), false);
+  road_network.is_loaded = true;
+
+  if (stats) {
+    stats->blocks = blobs.size();
+    stats->ways = way_count;
+    stats->nodes = needed.ids.size();
+    stats->bounds = bounds;
+  }
+  return true;
+}
+
+static std::string_view road_type_name(RoadType road_type) {
+  switch (road_type) {
+  case RoadType::Highway:
+    return "highway";
+  case RoadType::Primary:
+    return "primary";
+  case RoadType::Secondary:
+    return "secondary";
+  case RoadType::Residential:
+  default:
+    return "residential";
+  }
+}
+
+bool write_road_network_json(const RoadNetwork &road_network,
+                             const GeoBounds &bounds,
+                             const std::filesystem::path &json_path) {
+  std::ofstream out(json_path, std::ios::trunc);
+  if (!out.is_open()) {
+    log_warn("Could not write {}", json_path.string());
+    return false;
+  }
+  out << "{\n  \"segments\": [\n";
+  for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    const RoadSegment &seg = road_network.segments[i];
+    out << fmt::format("    {{\"start\": {{\"x\": {}, \"y\": {}}}, \"end\": "
+                       "{{\"x\": {}, \"y\": {}}}, \"width\": {}, "
+                       "\"road_type\": \"{}\"}}{}\n",
+                       seg.start.x, seg.start.y, seg.end.x, seg.end.y,
+                       seg.width, road_type_name(seg.road_type),
+                       i + 1 < road_network.segments.size() ? "," : "");
+  }
+  out << fmt::format("  ],\n  \"bounds\": [{}, {}, {}, {}]\n}}\n",
+                     bounds.min_lat, bounds.max_lat, bounds.min_lon,
+                     bounds.max_lon);
+  return out.good();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "components.h"
+#include <filesystem>
+#include <optional>
+
+struct GeoBounds {
+  double min_lat{0.0};
+  double max_lat{0.0};
+  double min_lon{0.0};
+  double max_lon{0.0};
+
+  bool contains(double lat, double lon) const {
+    return lat >= min_lat && lat <= max_lat && lon >= min_lon &&
+           lon <= max_lon;
+  }
+};
+
+// Same projection as scripts/download_nyc_roads.py: the bounds are
+// stretched over the whole world rect with north at the top
+inline vec2 lat_lon_to_game_coords(double lat, double lon,
+                                   const GeoBounds &bounds) {
+  double lat_range = bounds.max_lat - bounds.min_lat;
+  double lon_range = bounds.max_lon - bounds.min_lon;
+  double normalized_lat =
+      lat_range > 0.0 ? (lat - bounds.min_lat) / lat_range : 0.0;
+  double normalized_lon =
+      lon_range > 0.0 ? (lon - bounds.min_lon) / lon_range : 0.0;
+  return {static_cast<float>(normalized_lon * game_constants::WORLD_WIDTH),
+          static_cast<float>((1.0 - normalized_lat) *
+                             game_constants::WORLD_HEIGHT)};
+}
+
+enum class OsmHighwayFilter {
+  // Roads a car may use, close to osmnx's network_type='drive'
+  Drive,
+  // Every way with a highway tag
+  All,
+};
+
+struct OsmImportOptions {
+  OsmHighwayFilter filter{OsmHighwayFilter::Drive};
+  // Only keep segments with both ends inside these bounds
+  std::optional<GeoBounds> crop;
+  // 0 = one per hardware thread
+  unsigned thread_count{0};
+};
+
+struct OsmImportStats {
+  size_t blocks{0};
+  size_t ways{0};
+  size_t nodes{0};
+  GeoBounds bounds;
+};
+
+// Reads highway ways from a local .osm.pbf extract into road_network.
+// Returns false (after a log_warn) when the file is missing or malformed.
+bool import_osm_pbf(RoadNetwork &road_network,
+                    const std::filesystem::path &pbf_path,
+                    const OsmImportOptions &options,
+                    OsmImportStats *stats = nullptr);
+
+// Writes segments in the nyc_roads.json layout
+bool write_road_network_json(const RoadNetwork &road_network,
+                             const GeoBounds &bounds,
+                             const std::filesystem::path &json_path);
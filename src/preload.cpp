@@ -30,7 +30,7 @@ static void load_gamepad_mappings() {
 Preload::Preload() {}
 
 Preload &Preload::init(const char *title) {
-  files::init("Prime Pressure", "resources");
+  init_headless();
 
   int width = Settings::get().get_screen_width();
   int height = Settings::get().get_screen_height();
@@ -57,6 +57,11 @@ Preload &Preload::init(const char *title) {
   return *this;
 }
 
+Preload &Preload::init_headless() {
+  files::init("Prime Pressure", "resources");
+  return *this;
+}
+
 Preload &Preload::make_singleton() {
   auto &sophie = EntityHelper::createEntity();
   {
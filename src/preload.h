@@ -16,5 +16,6 @@ struct Preload {
   void operator=(const Preload &) = delete;
 
   Preload &init(const char *title);
+  Preload &init_headless();
   Preload &make_singleton();
 };
@@ -0,0 +1,408 @@
+#include "road_cache.h"
+
+#include "log.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace road_cache {
+
+static constexpr char MAGIC[8] = {'B', 'R', 'R', 'O', 'A', 'D', 'S', '\0'};
+static constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+enum Section : uint32_t {
+  Segments,
+  PortOffsets,
+  Links,
+  PortNode,
+  Nodes,
+  NodePorts,
+  ComponentParent,
+  ComponentNext,
+  ComponentSize,
+  ChunkOffsets,
+  ChunkBounds,
+  ChainPassThrough,
+  ChainOffsets,
+  ChainLinks,
+  SegmentChain,
+  TurnOffsets,
+  Turns,
+  SectionCount,
+};
+
+struct SectionRange {
+  uint64_t offset;
+  uint64_t count;
+};
+
+// Element sizes guard against loading a cache written by a build whose
+// RoadSegment, RoadNode or RoadTurn layout differs
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t segment_size;
+  uint32_t node_size;
+  uint32_t turn_size;
+  float connection_tolerance;
+  uint64_t source_size;
+  uint64_t source_hash;
+  RoadChunkLayout chunk_layout;
+  uint64_t component_count;
+  SectionRange sections[SectionCount];
+};
+
+static bool stat_source(const std::filesystem::path &path, uint64_t &size) {
+  std::error_code ec;
+  uintmax_t bytes = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return false;
+  }
+  size = static_cast<uint64_t>(bytes);
+  return true;
+}
+
+static uint64_t align_up(uint64_t offset) {
+  return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT *
+         SECTION_ALIGNMENT;
+}
+
+template <typename T>
+static bool view_section(const std::shared_ptr<MappedFile> &file,
+                         const Header &header, Section section,
+                         MappedArray<T> &out) {
+  const SectionRange &range = header.sections[section];
+  if (range.offset % alignof(T) != 0 || range.offset > file->size() ||
+      range.count > (file->size() - range.offset) / sizeof(T)) {
+    return false;
+  }
+  T *first = reinterpret_cast<T *>(file->data() + range.offset);
+  out = MappedArray<T>::view(file, first, static_cast<size_t>(range.count));
+  return true;
+}
+
+template <typename T>
+static void write_section(std::ofstream &out, uint64_t &written,
+                          const SectionRange &range,
+                          const MappedArray<T> &values) {
+  static const char padding[SECTION_ALIGNMENT] = {};
+  out.write(padding, static_cast<std::streamsize>(range.offset - written));
+  out.write(reinterpret_cast<const char *>(values.data()),
+            static_cast<std::streamsize>(values.size() * sizeof(T)));
+  written = range.offset + values.size() * sizeof(T);
+}
+
+// Every value below limit, so it can index an array of that size
+template <typename T>
+static bool all_below(const MappedArray<T> &values, uint64_t limit) {
+  return std::all_of(values.begin(), values.end(),
+                     [&](T value) { return value < limit; });
+}
+
+// A CSR offset table over `rows` rows ending at `total`, never decreasing
+static bool is_offset_table(const MappedArray<uint32_t> &offsets, size_t rows,
+                            size_t total) {
+  return offsets.size() == rows + 1 && offsets.front() == 0 &&
+         offsets.back() == total &&
+         std::is_sorted(offsets.begin(), offsets.end());
+}
+
+// Sizes can line up while the values inside are garbage; anything that is
+// later used as an index is checked against what it indexes
+static bool values_in_range(const RoadGraph &graph,
+                            const RoadComponents &components,
+                            const RoadChunkGrid &chunks,
+                            size_t segment_count) {
+  size_t port_count = segment_count * 2;
+  bool graph_ok =
+      is_offset_table(graph.port_offsets, port_count, graph.links.size()) &&
+      all_below(graph.links, port_count) &&
+      all_below(graph.port_node, graph.nodes.size()) &&
+      all_below(graph.node_ports, port_count) &&
+      std::all_of(graph.nodes.begin(), graph.nodes.end(),
+                  [&](const RoadNode &node) {
+                    return static_cast<uint64_t>(node.first_port) +
+                               node.port_count <=
+                           graph.node_ports.size();
+                  });
+  if (!graph_ok) {
+    return false;
+  }
+
+  // Components are saved flattened, so every parent is a root; that also
+  // rules out a cycle that would leave find() spinning
+  if (!all_below(components.parent, segment_count) ||
+      !all_below(components.next_member, segment_count)) {
+    return false;
+  }
+  size_t roots = 0;
+  for (size_t i = 0; i < segment_count; ++i) {
+    uint32_t root = components.parent[i];
+    if (components.parent[root] != root) {
+      return false;
+    }
+    roots += root == i ? 1 : 0;
+  }
+  if (roots != components.count()) {
+    return false;
+  }
+
+  return chunks.empty() || is_offset_table(chunks.segment_offsets,
+                                           chunks.chunk_count(),
+                                           segment_count);
+}
+
+static bool derived_in_range(const RoadChains &chains, const RoadTurns &turns,
+                             size_t segment_count) {
+  size_t port_count = segment_count * 2;
+  bool chains_ok =
+      chains.pass_through.size() == port_count &&
+      std::all_of(chains.pass_through.begin(), chains.pass_through.end(),
+                  [&](uint32_t link) {
+                    return link == RoadChains::INVALID || link < port_count;
+                  }) &&
+      !chains.chain_offsets.empty() &&
+      is_offset_table(chains.chain_offsets, chains.chain_count(),
+                      chains.chain_links.size()) &&
+      all_below(chains.chain_links, port_count) &&
+      chains.segment_chain.size() == segment_count &&
+      all_below(chains.segment_chain, chains.chain_count());
+  return chains_ok &&
+         is_offset_table(turns.offsets, port_count, turns.turns.size()) &&
+         std::all_of(turns.turns.begin(), turns.turns.end(),
+                     [&](const RoadTurn &turn) {
+                       return turn.link < port_count;
+                     });
+}
+
+uint64_t hash_bytes(const std::byte *data, size_t size) {
+  // FNV-1a over 8-byte words, folding the high bits back down after each
+  // multiply; one multiply per word keeps hashing on every load cheap
+  uint64_t hash = 14695981039346656037ull;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; ++i) {
+    hash ^= static_cast<uint64_t>(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+uint64_t hash_file(const std::filesystem::path &path) {
+  MappedFile file;
+  if (!file.open(path)) {
+    return 0;
+  }
+  return hash_bytes(file.data(), file.size());
+}
+
+bool load(RoadNetwork &road_network, const std::filesystem::path &cache_path,
+          const std::filesystem::path &source_path,
+          float connection_tolerance) {
+  uint64_t source_size = 0;
+  if (!stat_source(source_path, source_size)) {
+    return false;
+  }
+
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+  if (!file->open(cache_path) || file->size() < sizeof(Header)) {
+    return false;
+  }
+
+  Header header;
+  std::memcpy(&header, file->data(), sizeof(Header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION ||
+      header.segment_size != sizeof(RoadSegment) ||
+      header.node_size != sizeof(RoadNode) ||
+      header.turn_size != sizeof(RoadTurn) ||
+      header.connection_tolerance != connection_tolerance) {
+    log_info("Road cache {} was written by a different build, rebuilding",
+             cache_path.string());
+    return false;
+  }
+
+  // Timestamps are not trusted (copies and checkouts keep or reset them at
+  // will), so every load hashes the source; a size change skips the hash
+  if (header.source_size != source_size ||
+      hash_file(source_path) != header.source_hash) {
+    log_info("Road cache {} is stale, rebuilding", cache_path.string());
+    return false;
+  }
+
+  MappedArray<RoadSegment> segments;
+  RoadGraph graph;
+  RoadComponents components;
+  components.live_count = static_cast<size_t>(header.component_count);
+  RoadChunkGrid chunks;
+  chunks.layout = header.chunk_layout;
+  RoadChains chains;
+  RoadTurns turns;
+  bool in_bounds =
+      view_section(file, header, Segments, segments) &&
+      view_section(file, header, PortOffsets, graph.port_offsets) &&
+      view_section(file, header, Links, graph.links) &&
+      view_section(file, header, PortNode, graph.port_node) &&
+      view_section(file, header, Nodes, graph.nodes) &&
+      view_section(file, header, NodePorts, graph.node_ports) &&
+      view_section(file, header, ComponentParent, components.parent) &&
+      view_section(file, header, ComponentNext, components.next_member) &&
+      view_section(file, header, ComponentSize, components.size) &&
+      view_section(file, header, ChunkOffsets, chunks.segment_offsets) &&
+      view_section(file, header, ChunkBounds, chunks.bounds) &&
+      view_section(file, header, ChainPassThrough, chains.pass_through) &&
+      view_section(file, header, ChainOffsets, chains.chain_offsets) &&
+      view_section(file, header, ChainLinks, chains.chain_links) &&
+      view_section(file, header, SegmentChain, chains.segment_chain) &&
+      view_section(file, header, TurnOffsets, turns.offsets) &&
+      view_section(file, header, Turns, turns.turns);
+
+  size_t port_count = segments.size() * 2;
+  bool consistent = in_bounds && graph.port_offsets.size() == port_count + 1 &&
+                    graph.port_node.size() == port_count &&
+                    graph.node_ports.size() == port_count &&
+                    components.parent.size() == segments.size() &&
+                    components.next_member.size() == segments.size() &&
+                    components.size.size() == segments.size() &&
+                    components.count() <= segments.size() &&
+                    chunks.bounds.size() == chunks.chunk_count() &&
+                    (chunks.empty() ? chunks.segment_offsets.empty()
+                                    : chunks.segment_offsets.size() ==
+                                          chunks.chunk_count() + 1) &&
+                    values_in_range(graph, components, chunks,
+                                    segments.size()) &&
+                    derived_in_range(chains, turns, segments.size());
+  if (!consistent) {
+    log_warn("Road cache {} is corrupt, rebuilding", cache_path.string());
+    return false;
+  }
+
+  road_network.segments = std::move(segments);
+  road_network.graph = std::move(graph);
+  road_network.chains = std::move(chains);
+  road_network.claims.build(road_network.chains.chain_count());
+  road_network.turns = std::move(turns);
+  road_network.components = std::move(components);
+  road_network.chunks = std::move(chunks);
+  road_network.visited_segments.assign(road_network.segments.size(), false);
+  road_network.rebuild_visit_tracking();
+  road_network.is_loaded = true;
+  return true;
+}
+
+bool write(const RoadNetwork &road_network,
+           const std::filesystem::path &cache_path,
+           const std::filesystem::path &source_path,
+           float connection_tolerance) {
+  uint64_t source_size = 0;
+  if (!stat_source(source_path, source_size)) {
+    return false;
+  }
+
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.segment_size = sizeof(RoadSegment);
+  header.node_size = sizeof(RoadNode);
+  header.turn_size = sizeof(RoadTurn);
+  header.connection_tolerance = connection_tolerance;
+  header.source_size = source_size;
+  header.source_hash = hash_file(source_path);
+  header.chunk_layout = road_network.chunks.layout;
+  header.component_count = road_network.components.count();
+
+  const RoadGraph &graph = road_network.graph;
+  uint64_t offset = align_up(sizeof(Header));
+  auto place = [&](Section section, size_t count, size_t element_size) {
+    header.sections[section] = {offset, count};
+    offset = align_up(offset + count * element_size);
+  };
+  place(Segments, road_network.segments.size(), sizeof(RoadSegment));
+  place(PortOffsets, graph.port_offsets.size(), sizeof(uint32_t));
+  place(Links, graph.links.size(), sizeof(uint32_t));
+  place(PortNode, graph.port_node.size(), sizeof(uint32_t));
+  place(Nodes, graph.nodes.size(), sizeof(RoadNode));
+  place(NodePorts, graph.node_ports.size(), sizeof(uint32_t));
+  const RoadComponents &components = road_network.components;
+  place(ComponentParent, components.parent.size(), sizeof(uint32_t));
+  place(ComponentNext, components.next_member.size(), sizeof(uint32_t));
+  place(ComponentSize, components.size.size(), sizeof(uint32_t));
+  place(ChunkOffsets, road_network.chunks.segment_offsets.size(),
+        sizeof(uint32_t));
+  place(ChunkBounds, road_network.chunks.bounds.size(),
+        sizeof(RoadChunkBounds));
+  const RoadChains &chains = road_network.chains;
+  place(ChainPassThrough, chains.pass_through.size(), sizeof(uint32_t));
+  place(ChainOffsets, chains.chain_offsets.size(), sizeof(uint32_t));
+  place(ChainLinks, chains.chain_links.size(), sizeof(uint32_t));
+  place(SegmentChain, chains.segment_chain.size(), sizeof(uint32_t));
+  const RoadTurns &turns = road_network.turns;
+  place(TurnOffsets, turns.offsets.size(), sizeof(uint32_t));
+  place(Turns, turns.turns.size(), sizeof(RoadTurn));
+
+  std::error_code ec;
+  std::filesystem::create_directories(cache_path.parent_path(), ec);
+
+  // Write beside the cache and rename so a crash never leaves half a file
+  std::filesystem::path temp_path = cache_path;
+  temp_path += ".tmp";
+  std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    log_warn("Could not write road cache {}", temp_path.string());
+    return false;
+  }
+
+  out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+  uint64_t written = sizeof(Header);
+  write_section(out, written, header.sections[Segments],
+                road_network.segments);
+  write_section(out, written, header.sections[PortOffsets],
+                graph.port_offsets);
+  write_section(out, written, header.sections[Links], graph.links);
+  write_section(out, written, header.sections[PortNode], graph.port_node);
+  write_section(out, written, header.sections[Nodes], graph.nodes);
+  write_section(out, written, header.sections[NodePorts], graph.node_ports);
+  write_section(out, written, header.sections[ComponentParent],
+                components.parent);
+  write_section(out, written, header.sections[ComponentNext],
+                components.next_member);
+  write_section(out, written, header.sections[ComponentSize],
+                components.size);
+  write_section(out, written, header.sections[ChunkOffsets],
+                road_network.chunks.segment_offsets);
+  write_section(out, written, header.sections[ChunkBounds],
+                road_network.chunks.bounds);
+  write_section(out, written, header.sections[ChainPassThrough],
+                chains.pass_through);
+  write_section(out, written, header.sections[ChainOffsets],
+                chains.chain_offsets);
+  write_section(out, written, header.sections[ChainLinks],
+                chains.chain_links);
+  write_section(out, written, header.sections[SegmentChain],
+                chains.segment_chain);
+  write_section(out, written, header.sections[TurnOffsets], turns.offsets);
+  write_section(out, written, header.sections[Turns], turns.turns);
+  out.close();
+  if (out.fail()) {
+    log_warn("Could not write road cache {}", temp_path.string());
+    std::filesystem::remove(temp_path, ec);
+    return false;
+  }
+
+  std::filesystem::rename(temp_path, cache_path, ec);
+  if (ec) {
+    log_warn("Could not replace road cache {}: {}", cache_path.string(),
+             ec.message());
+    std::filesystem::remove(temp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace road_cache
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "components.h"
+#include <cstdint>
+#include <filesystem>
+
+// Binary snapshot of a fully built RoadNetwork (segments, junction graph,
+// chains, turn tables, components and chunks) that is mmapped back in
+// without parsing or copying. Only per-session visit state (claims, the
+// unvisited index and the per-type counters) is rebuilt on load. Each cache
+// remembers the source file it was built from and is rejected once that
+// file's contents change.
+namespace road_cache {
+
+constexpr uint32_t VERSION = 5;
+
+uint64_t hash_bytes(const std::byte *data, size_t size);
+uint64_t hash_file(const std::filesystem::path &path);
+
+bool load(RoadNetwork &road_network, const std::filesystem::path &cache_path,
+          const std::filesystem::path &source_path,
+          float connection_tolerance);
+
+bool write(const RoadNetwork &road_network,
+           const std::filesystem::path &cache_path,
+           const std::filesystem::path &source_path,
+           float connection_tolerance);
+
+} // namespace road_cache
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "mapped_array.h"
+#include "road_graph.h"
+#include <cstdint>
+#include <span>
+
+// Contracted view of the junction graph. Runs of segments welded at
+// degree-2 nodes (one way in, one way out) collapse into a single chain,
+// stored as the links a car drives in order. The original segment indices
+// stay on every link, so visit tracking still sees each segment; only the
+// decision logic is limited to the real junctions at chain ends.
+struct RoadChains {
+  static constexpr uint32_t INVALID = RoadGraph::INVALID;
+
+  // Per port: the link welded onto it at a degree-2 node, or INVALID at
+  // junctions and dead ends
+  MappedArray<uint32_t> pass_through;
+  // Chain c drives chain_links[chain_offsets[c], chain_offsets[c + 1])
+  MappedArray<uint32_t> chain_offsets;
+  MappedArray<uint32_t> chain_links;
+  MappedArray<uint32_t> segment_chain;
+
+  size_t chain_count() const {
+    return chain_offsets.empty() ? 0 : chain_offsets.size() - 1;
+  }
+
+  // Link to follow without a decision after leaving through exit_port
+  uint32_t continue_link(uint32_t exit_port) const {
+    return exit_port < pass_through.size() ? pass_through[exit_port]
+                                           : INVALID;
+  }
+
+  std::span<const uint32_t> chain(size_t chain_id) const {
+    return {chain_links.data() + chain_offsets[chain_id],
+            chain_links.data() + chain_offsets[chain_id + 1]};
+  }
+
+  uint32_t chain_of(size_t segment) const {
+    return segment < segment_chain.size() ? segment_chain[segment] : INVALID;
+  }
+
+  // Calls fn(point) for the chain's polyline, first entry to last exit
+  template <typename Segments, typename Fn>
+  void for_each_point(size_t chain_id, const Segments &segments,
+                      Fn &&fn) const {
+    std::span<const uint32_t> links = chain(chain_id);
+    if (links.empty()) {
+      return;
+    }
+    const auto &first = segments[RoadGraph::link_segment(links.front())];
+    fn(RoadGraph::link_reverse(links.front()) ? first.end : first.start);
+    for (uint32_t link : links) {
+      const auto &segment = segments[RoadGraph::link_segment(link)];
+      fn(RoadGraph::link_reverse(link) ? segment.start : segment.end);
+    }
+  }
+
+  void build(const RoadGraph &graph) {
+    clear();
+    size_t port_count = graph.port_node.size();
+    size_t segment_count = port_count / 2;
+    pass_through.assign(port_count, INVALID);
+    for (const RoadNode &node : graph.nodes) {
+      if (node.port_count != 2) {
+        continue;
+      }
+      // The two ports welded here; entering through a port is the link of
+      // the same value. Tolerance links to nearby nodes are left to the
+      // junctions, since short segments reach past their neighbours.
+      uint32_t a = graph.node_ports[node.first_port];
+      uint32_t b = graph.node_ports[node.first_port + 1];
+      if (RoadGraph::link_segment(a) != RoadGraph::link_segment(b)) {
+        pass_through[a] = b;
+        pass_through[b] = a;
+      }
+    }
+
+    segment_chain.assign(segment_count, INVALID);
+    chain_links.reserve(segment_count);
+    chain_offsets.push_back(0);
+    for (size_t seg = 0; seg < segment_count; ++seg) {
+      if (segment_chain[seg] != INVALID) {
+        continue;
+      }
+      uint32_t chain_id = static_cast<uint32_t>(chain_count());
+
+      // Back up to the junction the chain starts from. A link's value is
+      // also the port it enters through, and the predecessor leaves
+      // through that port, so it was driven as link ^ 1.
+      uint32_t first = RoadGraph::make_link(seg, false);
+      for (size_t steps = 0; steps < segment_count; ++steps) {
+        uint32_t back = continue_link(first);
+        if (back == INVALID || RoadGraph::link_segment(back) == seg) {
+          break;
+        }
+        first = back ^ 1u;
+      }
+
+      uint32_t link = first;
+      while (link != INVALID &&
+             segment_chain[RoadGraph::link_segment(link)] == INVALID) {
+        segment_chain[RoadGraph::link_segment(link)] = chain_id;
+        chain_links.push_back(link);
+        link = continue_link(link ^ 1u);
+      }
+      chain_offsets.push_back(static_cast<uint32_t>(chain_links.size()));
+    }
+  }
+
+  void clear() {
+    pass_through.clear();
+    chain_offsets.clear();
+    chain_links.clear();
+    segment_chain.clear();
+  }
+
+  size_t memory_bytes() const {
+    return (pass_through.capacity() + chain_offsets.capacity() +
+            chain_links.capacity() + segment_chain.capacity()) *
+           sizeof(uint32_t);
+  }
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "mapped_array.h"
+#include "rl.h"
+#include "std_include.h"
+#include <cstdint>
+
+struct RoadChunkBounds {
+  vec2 min{0.0f, 0.0f};
+  vec2 max{0.0f, 0.0f};
+};
+
+struct RoadChunkLayout {
+  vec2 origin{0.0f, 0.0f};
+  float chunk_size{0.0f};
+  uint32_t columns{0};
+  uint32_t rows{0};
+  // Furthest any segment reaches outside its own chunk's square
+  float overhang{0.0f};
+};
+
+// Fixed-size square chunks over the road network's bounding box. Segments
+// are stored chunk-major by midpoint, so chunk c owns segments
+// [segment_offsets[c], segment_offsets[c + 1]) and with them one contiguous
+// run of ports, links and component entries. Links hold global segment
+// indices, so edges crossing a chunk border are already stitched.
+struct RoadChunkGrid {
+  static constexpr float DEFAULT_CHUNK_SIZE = 256.0f;
+
+  RoadChunkLayout layout;
+  MappedArray<uint32_t> segment_offsets;
+  MappedArray<RoadChunkBounds> bounds;
+
+  size_t chunk_count() const {
+    return static_cast<size_t>(layout.columns) * layout.rows;
+  }
+  bool empty() const { return chunk_count() == 0; }
+
+  uint32_t first_segment(size_t chunk) const {
+    return segment_offsets[chunk];
+  }
+  uint32_t last_segment(size_t chunk) const {
+    return segment_offsets[chunk + 1];
+  }
+
+  // Positions outside the grid clamp to the nearest edge chunk
+  uint32_t chunk_at(vec2 position) const {
+    uint32_t x = cell(position.x - layout.origin.x, layout.columns);
+    uint32_t y = cell(position.y - layout.origin.y, layout.rows);
+    return y * layout.columns + x;
+  }
+
+  // Calls fn(chunk) for every non-empty chunk with segments inside the rect
+  template <typename Fn>
+  void for_each_overlapping(vec2 min, vec2 max, Fn &&fn) const {
+    if (empty()) {
+      return;
+    }
+    float reach = layout.overhang;
+    uint32_t x0 = cell(min.x - reach - layout.origin.x, layout.columns);
+    uint32_t x1 = cell(max.x + reach - layout.origin.x, layout.columns);
+    uint32_t y0 = cell(min.y - reach - layout.origin.y, layout.rows);
+    uint32_t y1 = cell(max.y + reach - layout.origin.y, layout.rows);
+    for (uint32_t y = y0; y <= y1; ++y) {
+      for (uint32_t x = x0; x <= x1; ++x) {
+        uint32_t chunk = y * layout.columns + x;
+        if (first_segment(chunk) == last_segment(chunk)) {
+          continue;
+        }
+        const RoadChunkBounds &box = bounds[chunk];
+        if (box.max.x < min.x || box.min.x > max.x || box.max.y < min.y ||
+            box.min.y > max.y) {
+          continue;
+        }
+        fn(chunk);
+      }
+    }
+  }
+
+  // Calls visit(chunk) for every non-empty chunk that could still hold a
+  // segment closer than best_dist_sq, in rings outward from position's
+  // chunk. visit may lower best_dist_sq as it finds closer segments.
+  template <typename Fn>
+  void for_each_near(vec2 position, float &best_dist_sq, Fn &&visit) const {
+    if (empty()) {
+      return;
+    }
+    int64_t cx = cell(position.x - layout.origin.x, layout.columns);
+    int64_t cy = cell(position.y - layout.origin.y, layout.rows);
+    int64_t columns = layout.columns;
+    int64_t rows = layout.rows;
+    int64_t max_ring = std::max({cx, columns - 1 - cx, cy, rows - 1 - cy});
+    for (int64_t ring = 0; ring <= max_ring; ++ring) {
+      // Segments reach at most overhang past their chunk's square
+      float gap =
+          static_cast<float>(ring - 1) * layout.chunk_size - layout.overhang;
+      if (gap > 0.0f && gap * gap > best_dist_sq) {
+        return;
+      }
+      int64_t y0 = std::max<int64_t>(cy - ring, 0);
+      int64_t y1 = std::min<int64_t>(cy + ring, rows - 1);
+      for (int64_t y = y0; y <= y1; ++y) {
+        bool full_row = y == cy - ring || y == cy + ring;
+        int64_t step = full_row ? 1 : std::max<int64_t>(ring * 2, 1);
+        for (int64_t x = cx - ring; x <= cx + ring; x += step) {
+          if (x < 0 || x >= columns) {
+            continue;
+          }
+          uint32_t chunk = static_cast<uint32_t>(y * columns + x);
+          if (first_segment(chunk) == last_segment(chunk)) {
+            continue;
+          }
+          const RoadChunkBounds &box = bounds[chunk];
+          float dx = std::max({box.min.x - position.x, 0.0f,
+                               position.x - box.max.x});
+          float dy = std::max({box.min.y - position.y, 0.0f,
+                               position.y - box.max.y});
+          if (dx * dx + dy * dy > best_dist_sq) {
+            continue;
+          }
+          visit(chunk);
+        }
+      }
+    }
+  }
+
+  void clear() {
+    layout = RoadChunkLayout{};
+    segment_offsets.clear();
+    bounds.clear();
+  }
+
+private:
+  uint32_t cell(float offset, uint32_t count) const {
+    // Negative and NaN offsets land in the first cell
+    if (!(offset > 0.0f)) {
+      return 0;
+    }
+    float index = offset / layout.chunk_size;
+    if (index >= static_cast<float>(count)) {
+      return count - 1;
+    }
+    return static_cast<uint32_t>(index);
+  }
+};
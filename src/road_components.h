@@ -0,0 +1,112 @@
+#pragma once
+
+#include "mapped_array.h"
+#include <cstdint>
+#include <utility>
+
+// Union-find over segment indices that stays correct as segments are added
+// and joined, so an edit never needs a full rebuild. A component is named by
+// its root segment. Each component's members also form a circular list
+// through next_member, so they can be listed in O(size).
+struct RoadComponents {
+  MappedArray<uint32_t> parent;
+  MappedArray<uint32_t> next_member;
+  // Member count, only meaningful at roots
+  MappedArray<uint32_t> size;
+  size_t live_count{0};
+
+  size_t segment_count() const { return parent.size(); }
+  size_t count() const { return live_count; }
+
+  bool is_root(size_t segment) const {
+    return segment < parent.size() && parent[segment] == segment;
+  }
+
+  size_t size_of(size_t root) const { return is_root(root) ? size[root] : 0; }
+
+  // Union by size keeps every path O(log n) even without compression
+  uint32_t find(size_t segment) const {
+    uint32_t current = static_cast<uint32_t>(segment);
+    while (parent[current] != current) {
+      current = parent[current];
+    }
+    return current;
+  }
+
+  // Tracks segments appended since the last call, each on its own
+  void grow(size_t new_segment_count) {
+    if (new_segment_count <= parent.size()) {
+      return;
+    }
+    parent.reserve(new_segment_count);
+    next_member.reserve(new_segment_count);
+    size.reserve(new_segment_count);
+    for (size_t i = parent.size(); i < new_segment_count; ++i) {
+      parent.push_back(static_cast<uint32_t>(i));
+      next_member.push_back(static_cast<uint32_t>(i));
+      size.push_back(1);
+      live_count++;
+    }
+  }
+
+  // Returns false when a and b were already connected
+  bool unite(size_t a, size_t b) {
+    make_owned();
+    uint32_t root_a = find_halving(a);
+    uint32_t root_b = find_halving(b);
+    if (root_a == root_b) {
+      return false;
+    }
+    if (size[root_a] < size[root_b]) {
+      std::swap(root_a, root_b);
+    }
+    parent[root_b] = root_a;
+    size[root_a] += size[root_b];
+    // Swapping successors splices two circular lists into one
+    std::swap(next_member[root_a], next_member[root_b]);
+    live_count--;
+    return true;
+  }
+
+  // Points every segment straight at its root so find is a single load
+  void flatten() {
+    make_owned();
+    for (size_t i = 0; i < parent.size(); ++i) {
+      parent[i] = find(i);
+    }
+  }
+
+  template <typename Fn> void for_each_member(size_t root, Fn &&fn) const {
+    if (!is_root(root)) {
+      return;
+    }
+    size_t member = root;
+    do {
+      fn(member);
+      member = next_member[member];
+    } while (member != root);
+  }
+
+  void clear() {
+    parent.clear();
+    next_member.clear();
+    size.clear();
+    live_count = 0;
+  }
+
+private:
+  uint32_t find_halving(size_t segment) {
+    uint32_t current = static_cast<uint32_t>(segment);
+    while (parent[current] != current) {
+      parent[current] = parent[parent[current]];
+      current = parent[current];
+    }
+    return current;
+  }
+
+  void make_owned() {
+    parent.make_owned();
+    next_member.make_owned();
+    size.make_owned();
+  }
+};
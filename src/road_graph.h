@@ -0,0 +1,105 @@
+#pragma once
+
+#include "mapped_array.h"
+#include "rl.h"
+#include "std_include.h"
+#include <cstdint>
+#include <span>
+
+struct RoadNode {
+  vec2 position{0.0f, 0.0f};
+  uint32_t first_port{0};
+  uint32_t port_count{0};
+};
+
+// Compressed junction graph over segment endpoints ("ports").
+// Port segment * 2 is the segment start, segment * 2 + 1 its end.
+// A link is the port a car enters the next segment through, so it packs the
+// segment index with the reverse flag in the low bit, and link ^ 1 is the
+// port the car will leave that segment from.
+struct RoadGraph {
+  static constexpr uint32_t INVALID = UINT32_MAX;
+
+  MappedArray<uint32_t> port_offsets;
+  MappedArray<uint32_t> links;
+  MappedArray<uint32_t> port_node;
+  MappedArray<RoadNode> nodes;
+  MappedArray<uint32_t> node_ports;
+
+  static uint32_t make_port(size_t segment, size_t endpoint) {
+    return static_cast<uint32_t>(segment * 2 + endpoint);
+  }
+
+  static uint32_t make_link(size_t segment, bool reverse) {
+    return static_cast<uint32_t>(segment * 2 + (reverse ? 1 : 0));
+  }
+
+  static size_t link_segment(uint32_t link) { return link >> 1; }
+  static bool link_reverse(uint32_t link) { return (link & 1u) != 0; }
+
+  // Port reached after driving a segment to its far end
+  static uint32_t exit_port(size_t segment, bool reverse) {
+    return make_port(segment, reverse ? 0 : 1);
+  }
+
+  size_t segment_count() const {
+    return port_offsets.empty() ? 0 : (port_offsets.size() - 1) / 2;
+  }
+
+  std::span<const uint32_t> port_links(uint32_t port) const {
+    if (static_cast<size_t>(port) + 1 >= port_offsets.size()) {
+      return {};
+    }
+    return {links.data() + port_offsets[port],
+            links.data() + port_offsets[port + 1]};
+  }
+
+  std::span<const uint32_t> next_links(size_t segment, bool reverse) const {
+    return port_links(exit_port(segment, reverse));
+  }
+
+  const RoadNode &node_at(uint32_t port) const {
+    return nodes[port_node[port]];
+  }
+
+  void clear() {
+    port_offsets.clear();
+    links.clear();
+    port_node.clear();
+    nodes.clear();
+    node_ports.clear();
+  }
+
+  size_t link_bytes() const {
+    return port_offsets.capacity() * sizeof(uint32_t) +
+           links.capacity() * sizeof(uint32_t);
+  }
+
+  size_t memory_bytes() const {
+    return link_bytes() + port_node.capacity() * sizeof(uint32_t) +
+           nodes.capacity() * sizeof(RoadNode) +
+           node_ports.capacity() * sizeof(uint32_t);
+  }
+
+  // Group ports by node once port_node is filled in
+  void build_node_ports() {
+    for (RoadNode &node : nodes) {
+      node.port_count = 0;
+    }
+    for (uint32_t node_id : port_node) {
+      nodes[node_id].port_count++;
+    }
+    uint32_t next_port = 0;
+    for (RoadNode &node : nodes) {
+      node.first_port = next_port;
+      next_port += node.port_count;
+      node.port_count = 0;
+    }
+    node_ports.resize(port_node.size());
+    for (size_t port = 0; port < port_node.size(); ++port) {
+      RoadNode &node = nodes[port_node[port]];
+      node_ports[node.first_port + node.port_count++] =
+          static_cast<uint32_t>(port);
+    }
+  }
+};
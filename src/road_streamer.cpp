@@ -0,0 +1,203 @@
+#include "road_streamer.h"
+
+#include "components.h"
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+RoadChunkStreamer::RoadChunkStreamer() : worker([this]() { run(); }) {}
+
+RoadChunkStreamer::~RoadChunkStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  worker.join();
+}
+
+void RoadChunkStreamer::attach(const RoadNetwork &road_network) {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this]() { return !busy; });
+  has_pending = false;
+  file.reset();
+  chunk_ranges.clear();
+  ranges.clear();
+  resident.clear();
+
+  const RoadChunkGrid &chunks = road_network.chunks;
+  const RoadGraph &graph = road_network.graph;
+  const std::shared_ptr<MappedFile> &mapping = road_network.segments.mapping();
+  if (mapping == nullptr || chunks.empty() ||
+      graph.segment_count() != road_network.segments.size()) {
+    return;
+  }
+
+  auto add = [&](const auto &array, size_t first, size_t last) {
+    using T = std::remove_cvref_t<decltype(array[0])>;
+    if (array.mapping() != mapping || first >= last) {
+      return;
+    }
+    const std::byte *start =
+        reinterpret_cast<const std::byte *>(array.data() + first);
+    ranges.push_back({static_cast<size_t>(start - mapping->data()),
+                      (last - first) * sizeof(T)});
+  };
+
+  // Nodes are numbered in port order, so the nodes a chunk created are the
+  // ones numbered after every node seen in earlier chunks
+  size_t chunk_count = chunks.chunk_count();
+  std::vector<uint32_t> node_begin(chunk_count + 1, 0);
+  uint32_t nodes_seen = 0;
+  for (size_t c = 0; c < chunk_count; ++c) {
+    node_begin[c] = nodes_seen;
+    for (size_t port = chunks.first_segment(c) * 2ull;
+         port < chunks.last_segment(c) * 2ull; ++port) {
+      nodes_seen = std::max(nodes_seen, graph.port_node[port] + 1);
+    }
+  }
+  node_begin[chunk_count] = static_cast<uint32_t>(graph.nodes.size());
+  auto node_port_begin = [&](uint32_t node) -> size_t {
+    return node < graph.nodes.size() ? graph.nodes[node].first_port
+                                     : graph.node_ports.size();
+  };
+
+  // Chains are numbered by their lowest segment the same way
+  const RoadChains &chains = road_network.chains;
+  std::vector<uint32_t> chain_begin(chunk_count + 1, 0);
+  uint32_t chains_seen = 0;
+  for (size_t c = 0; c < chunk_count; ++c) {
+    chain_begin[c] = chains_seen;
+    for (size_t seg = chunks.first_segment(c); seg < chunks.last_segment(c);
+         ++seg) {
+      uint32_t chain = chains.chain_of(seg);
+      if (chain != RoadChains::INVALID) {
+        chains_seen = std::max(chains_seen, chain + 1);
+      }
+    }
+  }
+  chain_begin[chunk_count] = static_cast<uint32_t>(chains.chain_count());
+  const RoadTurns &turns = road_network.turns;
+  bool has_turns = turns.offsets.size() == graph.port_node.size() + 1;
+
+  chunk_ranges.push_back(0);
+  for (size_t c = 0; c < chunk_count; ++c) {
+    size_t first = chunks.first_segment(c);
+    size_t last = chunks.last_segment(c);
+    add(road_network.segments, first, last);
+    add(road_network.components.parent, first, last);
+    add(road_network.components.next_member, first, last);
+    add(road_network.components.size, first, last);
+    add(graph.port_offsets, first * 2, last * 2 + 1);
+    add(graph.port_node, first * 2, last * 2);
+    add(graph.links, graph.port_offsets[first * 2],
+        graph.port_offsets[last * 2]);
+    add(graph.nodes, node_begin[c], node_begin[c + 1]);
+    add(graph.node_ports, node_port_begin(node_begin[c]),
+        node_port_begin(node_begin[c + 1]));
+    add(chains.pass_through, first * 2, last * 2);
+    add(chains.segment_chain, first, last);
+    add(chains.chain_offsets, chain_begin[c], chain_begin[c + 1]);
+    if (chain_begin[c] < chain_begin[c + 1]) {
+      add(chains.chain_links, chains.chain_offsets[chain_begin[c]],
+          chains.chain_offsets[chain_begin[c + 1]]);
+    }
+    if (has_turns) {
+      add(turns.offsets, first * 2, last * 2 + 1);
+      add(turns.turns, turns.offsets[first * 2], turns.offsets[last * 2]);
+    }
+    chunk_ranges.push_back(static_cast<uint32_t>(ranges.size()));
+  }
+
+  file = mapping;
+  resident.resize(chunk_count);
+  std::iota(resident.begin(), resident.end(), 0u);
+}
+
+void RoadChunkStreamer::detach() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this]() { return !busy; });
+  has_pending = false;
+  file.reset();
+  chunk_ranges.clear();
+  ranges.clear();
+  resident.clear();
+}
+
+void RoadChunkStreamer::request(std::vector<uint32_t> wanted) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == nullptr) {
+      return;
+    }
+    pending = std::move(wanted);
+    has_pending = true;
+  }
+  wake.notify_one();
+}
+
+void RoadChunkStreamer::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this]() { return !busy && !has_pending; });
+}
+
+size_t RoadChunkStreamer::resident_chunk_count() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return resident.size();
+}
+
+size_t RoadChunkStreamer::chunk_bytes(uint32_t chunk) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (static_cast<size_t>(chunk) + 1 >= chunk_ranges.size()) {
+    return 0;
+  }
+  size_t bytes = 0;
+  for (uint32_t r = chunk_ranges[chunk]; r < chunk_ranges[chunk + 1]; ++r) {
+    bytes += ranges[r].length;
+  }
+  return bytes;
+}
+
+void RoadChunkStreamer::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [this]() { return stopping || has_pending; });
+    if (stopping) {
+      return;
+    }
+    std::vector<uint32_t> wanted = std::move(pending);
+    has_pending = false;
+    busy = true;
+    lock.unlock();
+    apply(wanted);
+    lock.lock();
+    resident = std::move(wanted);
+    busy = false;
+    idle.notify_all();
+  }
+}
+
+void RoadChunkStreamer::apply(const std::vector<uint32_t> &wanted) {
+  std::vector<uint32_t> leaving;
+  std::set_difference(resident.begin(), resident.end(), wanted.begin(),
+                      wanted.end(), std::back_inserter(leaving));
+  std::vector<uint32_t> arriving;
+  std::set_difference(wanted.begin(), wanted.end(), resident.begin(),
+                      resident.end(), std::back_inserter(arriving));
+
+  // A page shared with a wanted neighbour is dropped too; it costs that
+  // neighbour one soft fault from the page cache
+  for (uint32_t chunk : leaving) {
+    for (uint32_t r = chunk_ranges[chunk]; r < chunk_ranges[chunk + 1]; ++r) {
+      file->release(ranges[r].offset, ranges[r].length);
+    }
+  }
+  for (uint32_t chunk : arriving) {
+    if (static_cast<size_t>(chunk) + 1 >= chunk_ranges.size()) {
+      continue;
+    }
+    for (uint32_t r = chunk_ranges[chunk]; r < chunk_ranges[chunk + 1]; ++r) {
+      file->prefetch(ranges[r].offset, ranges[r].length);
+    }
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct RoadNetwork;
+
+// Pages mapped road chunks in and out on a background thread so resident
+// memory follows the chunks around the camera and cars rather than the size
+// of the world. Only networks mapped from the road cache are streamed; one
+// built in memory is already resident and is left alone.
+struct RoadChunkStreamer {
+  RoadChunkStreamer();
+  ~RoadChunkStreamer();
+
+  RoadChunkStreamer(const RoadChunkStreamer &) = delete;
+  void operator=(const RoadChunkStreamer &) = delete;
+
+  // Records where each chunk lives in the mapping. Every chunk counts as
+  // resident until the first request releases the unwanted ones.
+  void attach(const RoadNetwork &road_network);
+  void detach();
+  bool is_streaming() const { return file != nullptr; }
+
+  // wanted is sorted and unique; only the latest request is acted on
+  void request(std::vector<uint32_t> wanted);
+  // Blocks until every request so far has been applied
+  void wait_idle();
+
+  size_t resident_chunk_count() const;
+  size_t chunk_bytes(uint32_t chunk) const;
+
+private:
+  struct ByteRange {
+    size_t offset;
+    size_t length;
+  };
+
+  void run();
+  void apply(const std::vector<uint32_t> &wanted);
+
+  // Written by attach while the worker is idle, read by the worker
+  std::shared_ptr<MappedFile> file;
+  std::vector<uint32_t> chunk_ranges;
+  std::vector<ByteRange> ranges;
+  std::vector<uint32_t> resident;
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::vector<uint32_t> pending;
+  bool has_pending{false};
+  bool busy{false};
+  bool stopping{false};
+  std::thread worker;
+};
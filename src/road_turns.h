@@ -0,0 +1,114 @@
+#pragma once
+
+#include "mapped_array.h"
+#include "road_graph.h"
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+struct RoadTurn {
+  uint32_t link{RoadGraph::INVALID};
+  // Signed angle from the arriving heading, positive turns right
+  float angle{0.0f};
+  // Unit direction the car drives the candidate in
+  vec2 heading{0.0f, 0.0f};
+};
+
+// Per exit port, the segments a car arriving there can continue onto, with
+// headings and turn angles worked out once at load and sorted into
+// wall-follower preference order. A junction decision is then a walk down
+// the table checking visited bits.
+struct RoadTurns {
+  // Turns for port p are turns[offsets[p], offsets[p + 1])
+  MappedArray<uint32_t> offsets;
+  MappedArray<RoadTurn> turns;
+
+  // Straight on first, then right turns from shallow to sharp, then left
+  // turns the same way
+  static float wall_follower_rank(float angle) {
+    float abs_angle = std::abs(angle);
+    if (abs_angle < 0.1f) {
+      return abs_angle;
+    }
+    if (angle > 0.0f) {
+      return 1.0f + angle / 3.14159f;
+    }
+    return 3.0f + abs_angle / 3.14159f;
+  }
+
+  std::span<const RoadTurn> at(uint32_t exit_port) const {
+    if (static_cast<size_t>(exit_port) + 1 >= offsets.size()) {
+      return {};
+    }
+    return {turns.data() + offsets[exit_port],
+            turns.data() + offsets[exit_port + 1]};
+  }
+
+  template <typename Segments>
+  void build(const RoadGraph &graph, const Segments &segments) {
+    clear();
+    size_t port_count = graph.port_node.size();
+    offsets.assign(port_count + 1, 0);
+    turns.reserve(graph.links.size());
+    for (size_t port = 0; port < port_count; ++port) {
+      size_t seg = port / 2;
+      // Arriving at the end port means the segment was driven forwards
+      const auto &current = segments[seg];
+      vec2 from = (port & 1u) != 0 ? current.start : current.end;
+      vec2 to = (port & 1u) != 0 ? current.end : current.start;
+      vec2 arriving{0.0f, 0.0f};
+      bool has_heading = unit(from, to, arriving);
+
+      size_t first = turns.size();
+      for (uint32_t link :
+           graph.port_links(static_cast<uint32_t>(port))) {
+        size_t next = RoadGraph::link_segment(link);
+        if (!has_heading || next == seg) {
+          continue;
+        }
+        const auto &candidate = segments[next];
+        bool reverse = RoadGraph::link_reverse(link);
+        RoadTurn turn;
+        turn.link = link;
+        if (!unit(reverse ? candidate.end : candidate.start,
+                  reverse ? candidate.start : candidate.end, turn.heading)) {
+          continue;
+        }
+        float cross =
+            arriving.x * turn.heading.y - arriving.y * turn.heading.x;
+        float dot = arriving.x * turn.heading.x + arriving.y * turn.heading.y;
+        turn.angle = std::atan2(cross, dot);
+        turns.push_back(turn);
+      }
+      std::stable_sort(turns.begin() + first, turns.end(),
+                       [](const RoadTurn &a, const RoadTurn &b) {
+                         return wall_follower_rank(a.angle) <
+                                wall_follower_rank(b.angle);
+                       });
+      offsets[port + 1] = static_cast<uint32_t>(turns.size());
+    }
+    turns.shrink_to_fit();
+  }
+
+  void clear() {
+    offsets.clear();
+    turns.clear();
+  }
+
+  size_t memory_bytes() const {
+    return offsets.capacity() * sizeof(uint32_t) +
+           turns.capacity() * sizeof(RoadTurn);
+  }
+
+private:
+  // Same 0.001 cut-off MazeTraversal uses for degenerate segments
+  static bool unit(vec2 from, vec2 to, vec2 &out) {
+    vec2 dir{to.x - from.x, to.y - from.y};
+    float len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+    if (len < 0.001f) {
+      return false;
+    }
+    out = {dir.x / len, dir.y / len};
+    return true;
+  }
+};
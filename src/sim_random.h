@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+// The one engine every random choice in the simulation draws from, so a
+// run started with --seed replays exactly. Unseeded runs start it from
+// std::random_device.
+//
+// Draws go through below() and between() rather than the std
+// distributions: the engine's output is fixed by the standard, but how
+// uniform_int_distribution and uniform_real_distribution map it is not,
+// and libstdc++ and libc++ differ, so a seed would replay differently
+// depending on the standard library.
+struct SimRandom {
+  using Engine = std::mt19937;
+
+  static Engine &engine() {
+    static Engine rng(std::random_device{}());
+    return rng;
+  }
+
+  static void seed(uint32_t value) { engine().seed(value); }
+
+  // Uniform in [0, n), by Lemire's multiply-shift with rejection so no
+  // value is favoured. n must be nonzero and fit in 32 bits.
+  template <typename Rng> static uint32_t below(Rng &rng, uint32_t n) {
+    static_assert(Rng::min() == 0 && Rng::max() == UINT32_MAX,
+                  "SimRandom draws need a full 32-bit engine");
+    uint64_t product = static_cast<uint64_t>(rng()) * n;
+    uint32_t low = static_cast<uint32_t>(product);
+    if (low < n) {
+      uint32_t threshold = (0u - n) % n;
+      while (low < threshold) {
+        product = static_cast<uint64_t>(rng()) * n;
+        low = static_cast<uint32_t>(product);
+      }
+    }
+    return static_cast<uint32_t>(product >> 32);
+  }
+
+  // Uniform between lo and hi, from the top 24 bits of one draw
+  template <typename Rng> static float between(Rng &rng, float lo, float hi) {
+    static_assert(Rng::min() == 0 && Rng::max() == UINT32_MAX,
+                  "SimRandom draws need a full 32-bit engine");
+    float unit = static_cast<float>(rng() >> 8) * 0x1.0p-24f;
+    return lo + (hi - lo) * unit;
+  }
+};
@@ -6,12 +6,80 @@
 #include "../log.h"
 #include "MapRevealSystem.h"
 #include <afterhours/ah.h>
+#include <algorithm>
+#include <bitset>
 #include <cmath>
+#include <vector>
 
 struct DiscoverySystem
     : afterhours::System<
           Transform,
           afterhours::tags::Any<ColliderTag::Square, ColliderTag::Circle>> {
+  // Pooled cars only check POIs from fog cells within reach of one that
+  // is still hidden, so most cars cost a single bit test
+  virtual void once(float) override {
+    CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    if (!cars || cars->empty()) {
+      return;
+    }
+    FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
+    invariant(fog, "FogOfWar singleton not found");
+    float reveal_radius = fog->reveal_radius;
+
+    hidden.clear();
+    for (PointOfInterest &poi : afterhours::EntityQuery()
+                                    .whereHasComponent<PointOfInterest>()
+                                    .gen_as<PointOfInterest>()) {
+      if (!poi.is_discovered) {
+        hidden.push_back(&poi);
+      }
+    }
+    if (hidden.empty()) {
+      return;
+    }
+
+    near_hidden.reset();
+    for (const PointOfInterest *poi : hidden) {
+      int x0 = grid_x(poi->position.x - reveal_radius);
+      int x1 = grid_x(poi->position.x + reveal_radius);
+      int y0 = grid_y(poi->position.y - reveal_radius);
+      int y1 = grid_y(poi->position.y + reveal_radius);
+      for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+          near_hidden.set(y * game_constants::GRID_WIDTH + x);
+        }
+      }
+    }
+
+    SimulationWorkers *workers =
+        afterhours::EntityHelper::get_singleton_cmp<SimulationWorkers>();
+    if (!workers || !workers->runs_parallel(cars->size())) {
+      for (size_t car = 0; car < cars->size(); ++car) {
+        if (near_hidden_poi(cars->position[car])) {
+          discover_around(cars->position[car], reveal_radius);
+        }
+      }
+      return;
+    }
+
+    // The bit tests split across the workers; the few cars that pass check
+    // POIs afterwards in pool order, so rewards land as they would serially
+    workers->for_each_slice(
+        cars->size(),
+        [&](size_t begin, size_t end, std::vector<uint32_t> &near) {
+          for (size_t car = begin; car < end; ++car) {
+            if (near_hidden_poi(cars->position[car])) {
+              near.push_back(static_cast<uint32_t>(car));
+            }
+          }
+        });
+    for (const std::vector<uint32_t> &near : workers->deferred) {
+      for (uint32_t car : near) {
+        discover_around(cars->position[car], reveal_radius);
+      }
+    }
+  }
+
   virtual void for_each_with(afterhours::Entity &, Transform &transform,
                              float) override {
     FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
@@ -25,24 +93,56 @@ struct DiscoverySystem
       if (poi.is_discovered) {
         continue;
       }
+      try_discover(poi, transform.position, reveal_radius);
+    }
+  }
 
-      float dx = transform.position.x - poi.position.x;
-      float dy = transform.position.y - poi.position.y;
-      float dist_sq = dx * dx + dy * dy;
-      float reveal_radius_sq = reveal_radius * reveal_radius;
+private:
+  std::vector<PointOfInterest *> hidden;
+  // Fog cells a car must be in to be within reveal radius of a hidden POI
+  std::bitset<game_constants::GRID_SIZE> near_hidden;
 
-      if (dist_sq > reveal_radius_sq) {
-        continue;
+  // Fog cell coordinates, clamped so every position has one
+  static int grid_x(float world_x) {
+    return std::clamp(game_constants::world_to_grid_x(world_x), 0,
+                      game_constants::GRID_WIDTH - 1);
+  }
+  static int grid_y(float world_y) {
+    return std::clamp(game_constants::world_to_grid_y(world_y), 0,
+                      game_constants::GRID_HEIGHT - 1);
+  }
+
+  bool near_hidden_poi(vec2 position) const {
+    return near_hidden.test(grid_y(position.y) * game_constants::GRID_WIDTH +
+                            grid_x(position.x));
+  }
+
+  void discover_around(vec2 position, float reveal_radius) {
+    for (PointOfInterest *poi : hidden) {
+      if (!poi->is_discovered) {
+        try_discover(*poi, position, reveal_radius);
       }
+    }
+  }
 
-      poi.is_discovered = true;
+  static void try_discover(PointOfInterest &poi, vec2 position,
+                           float reveal_radius) {
+    float dx = position.x - poi.position.x;
+    float dy = position.y - poi.position.y;
+    float dist_sq = dx * dx + dy * dy;
+    float reveal_radius_sq = reveal_radius * reveal_radius;
 
-      IsShopManager *shop =
-          afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
-      invariant(shop, "IsShopManager singleton not found");
-      shop->pixels_collected += poi.reward_amount;
-      log_info("Discovered POI! Type: {}, Reward: {} pixels",
-               static_cast<int>(poi.poi_type), poi.reward_amount);
+    if (dist_sq > reveal_radius_sq) {
+      return;
     }
+
+    poi.is_discovered = true;
+
+    IsShopManager *shop =
+        afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
+    invariant(shop, "IsShopManager singleton not found");
+    shop->pixels_collected += poi.reward_amount;
+    log_info("Discovered POI! Type: {}, Reward: {} pixels",
+             static_cast<int>(poi.poi_type), poi.reward_amount);
   }
 };
@@ -81,6 +81,16 @@ struct HandleCollisions
     cached_photo_reveal =
         afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
     invariant(cached_photo_reveal, "IsPhotoReveal singleton not found");
+
+    // Pooled cars stay on their roads, so they only chip at bricks under
+    // them rather than bouncing off
+    CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    if (cars) {
+      for (size_t car = 0; car < cars->size(); ++car) {
+        damage_brick_under(cars->position[car], cars->radius[car],
+                           cars->damage[car]);
+      }
+    }
   }
 
   virtual void for_each_with(afterhours::Entity &, Transform &car_transform,
@@ -175,4 +185,49 @@ struct HandleCollisions
       restore_car_velocity(car_transform, stored_velocity);
     }
   }
+
+private:
+  // Damages the first brick the car's circle overlaps, if any
+  void damage_brick_under(vec2 car_center, float car_radius, int damage) {
+    int min_grid_x = std::max(
+        game_constants::world_to_grid_x(car_center.x - car_radius), 0);
+    int max_grid_x =
+        std::min(game_constants::world_to_grid_x(car_center.x + car_radius),
+                 game_constants::GRID_WIDTH - 1);
+    int min_grid_y = std::max(
+        game_constants::world_to_grid_y(car_center.y - car_radius), 0);
+    int max_grid_y =
+        std::min(game_constants::world_to_grid_y(car_center.y + car_radius),
+                 game_constants::GRID_HEIGHT - 1);
+
+    for (int grid_y = min_grid_y; grid_y <= max_grid_y; ++grid_y) {
+      for (int grid_x = min_grid_x; grid_x <= max_grid_x; ++grid_x) {
+        if (!cached_brick_grid->has_brick(grid_x, grid_y)) {
+          continue;
+        }
+        float brick_left = game_constants::BRICK_START_X +
+                           grid_x * game_constants::BRICK_CELL_SIZE;
+        float brick_top = game_constants::BRICK_START_Y +
+                          grid_y * game_constants::BRICK_CELL_SIZE;
+        float closest_x =
+            std::clamp(car_center.x, brick_left,
+                       brick_left + game_constants::BRICK_CELL_SIZE);
+        float closest_y =
+            std::clamp(car_center.y, brick_top,
+                       brick_top + game_constants::BRICK_CELL_SIZE);
+        float dx = car_center.x - closest_x;
+        float dy = car_center.y - closest_y;
+        if (dx * dx + dy * dy >= car_radius * car_radius) {
+          continue;
+        }
+        cached_brick_grid->add_health(grid_x, grid_y,
+                                      static_cast<short>(-damage));
+        if (cached_brick_grid->get_health(grid_x, grid_y) <= 0) {
+          cached_shop->pixels_collected += 1;
+          cached_photo_reveal->set_revealed(grid_x, grid_y);
+        }
+        return;
+      }
+    }
+  }
 };
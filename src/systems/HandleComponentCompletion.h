@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../components.h"
+#include "../log.h"
+#include <afterhours/ah.h>
+
+// Reacts to the completion events mark_visited raises. Once the current
+// component is finished, play moves to the component of a random unvisited
+// segment.
+struct HandleComponentCompletion : afterhours::System<RoadNetwork> {
+  virtual void for_each_with(afterhours::Entity &, RoadNetwork &road_network,
+                             float) override {
+    if (road_network.completed_components.empty()) {
+      return;
+    }
+
+    bool current_completed = false;
+    for (size_t comp_id : road_network.completed_components) {
+      log_info("Component {} complete ({} segments)", comp_id,
+               road_network.get_component_size(comp_id));
+      current_completed =
+          current_completed || comp_id == road_network.current_component_id;
+    }
+    road_network.completed_components.clear();
+
+    if (!current_completed) {
+      return;
+    }
+    size_t next_segment = road_network.find_random_unvisited_segment();
+    if (next_segment == SIZE_MAX) {
+      log_info("Every road has been visited");
+      road_network.current_component_id = SIZE_MAX;
+      return;
+    }
+    road_network.current_component_id =
+        road_network.get_component_id(next_segment);
+    log_info("Moving on to component {} ({} of {} segments unvisited)",
+             road_network.current_component_id,
+             road_network.get_unvisited_count_in_component(
+                 road_network.current_component_id),
+             road_network.get_component_size(
+                 road_network.current_component_id));
+  }
+};
@@ -15,7 +15,7 @@ struct LoopDetection
   virtual void once(float) override {}
 
   virtual void for_each_with(afterhours::Entity & /* entity */,
-                             Transform &transform,
+                             Transform & /* transform */,
                              RoadFollowing &road_following, float dt) override {
     RoadNetwork *road_network =
         afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
@@ -24,6 +24,14 @@ struct LoopDetection
       return;
     }
 
+    // Only the wall follower can circle forever; the other algorithms
+    // drive back over visited roads on purpose, as does a car already on
+    // its way to unvisited road
+    if (road_following.current_algorithm != MazeAlgorithm::WallFollower ||
+        road_following.seeking_frontier) {
+      return;
+    }
+
     // Check if we're in a loop (too many consecutive visited segments)
     if (road_following.segments_without_reveal <
         RoadFollowing::LOOP_DETECTION_THRESHOLD) {
@@ -39,28 +47,15 @@ struct LoopDetection
     road_following.forced_direction_attempts++;
 
     // If we've tried forced direction multiple times and still stuck,
-    // jump to a random unvisited segment
+    // head for the nearest unvisited road
     if (road_following.forced_direction_attempts >=
         RoadFollowing::MAX_FORCED_DIRECTION_ATTEMPTS) {
-      size_t unvisited_seg = road_network->find_random_unvisited_segment();
-      if (unvisited_seg != SIZE_MAX) {
-        size_t attempts = road_following.forced_direction_attempts;
-        road_following.current_segment_index = unvisited_seg;
-        road_following.progress_along_segment = 0.0f;
-        road_following.reverse_direction = false;
-        road_following.segments_without_reveal = 0;
-        road_following.forced_direction_attempts = 0;
-        // Update transform position to the start of the new segment
-        const RoadSegment &new_seg = road_network->segments[unvisited_seg];
-        transform.position = new_seg.start;
-        log_info("LoopDetection: Jumping to unvisited segment {} after {} "
-                 "forced direction attempts",
-                 unvisited_seg, attempts);
-        return;
-      }
-      // All segments visited! Reset attempts counter
+      log_info("LoopDetection: Heading for unvisited road after {} forced "
+               "direction attempts",
+               road_following.forced_direction_attempts);
       road_following.forced_direction_attempts = 0;
-      log_info("LoopDetection: All segments visited!");
+      road_following.seeking_frontier = true;
+      return;
     }
 
     // Calculate current direction
@@ -4,7 +4,9 @@
 #include "../game_constants.h"
 #include "../log.h"
 #include <afterhours/ah.h>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 struct MapRevealSystem {
   static bool reveal_segment(size_t segment_index) {
@@ -63,42 +65,234 @@ struct MapRevealSystem {
         afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
     invariant(photo_reveal, "IsPhotoReveal singleton not found");
 
-    float reveal_radius_sq = radius * radius;
-    int center_grid_x = game_constants::world_to_grid_x(position.x);
-    int center_grid_y = game_constants::world_to_grid_y(position.y);
+    reveal_position(*fog, *photo_reveal, position, radius);
+  }
 
-    int radius_in_cells =
-        static_cast<int>(std::ceil(radius / game_constants::BRICK_CELL_SIZE));
+  static void reveal_position(FogOfWar &fog, IsPhotoReveal &photo_reveal,
+                              const vec2 &position, float radius) {
+    for_each_disc_span(position, radius, [&](int grid_y, int x0, int x1) {
+      reveal_span(fog, photo_reveal, grid_y, x0, x1);
+    });
+  }
 
-    for (int dy = -radius_in_cells; dy <= radius_in_cells; ++dy) {
-      for (int dx = -radius_in_cells; dx <= radius_in_cells; ++dx) {
-        int grid_x = center_grid_x + dx;
-        int grid_y = center_grid_y + dy;
+  // Reveals cells x0..x1 of row grid_y in the fog, and in the photo
+  // wherever the fog was still hidden
+  static void reveal_span(FogOfWar &fog, IsPhotoReveal &photo_reveal,
+                          int grid_y, int x0, int x1) {
+    fog.reveal_span(grid_y, x0, x1, [&](size_t word, uint64_t fresh) {
+      photo_reveal.reveal_bits(word, fresh);
+    });
+  }
 
-        if (grid_x < 0 || grid_x >= game_constants::GRID_WIDTH || grid_y < 0 ||
-            grid_y >= game_constants::GRID_HEIGHT) {
-          continue;
+  // Calls fn(grid_y, x0, x1) for each row of cells whose centres lie within
+  // radius of position, as a single run per row clipped to the grid. A
+  // row's run comes from one square root; an end landing within rounding
+  // error of a cell centre is settled by the per-cell distance test, so
+  // runs hold exactly the cells that test passes. A row costs the same
+  // however wide the disc is, but a disc has a row per cell of diameter,
+  // so a reveal is still linear in the radius.
+  template <typename Fn>
+  static void for_each_disc_span(const vec2 &position, float radius,
+                                 Fn &&fn) {
+    constexpr float cell_size = game_constants::BRICK_CELL_SIZE;
+    float radius_sq = radius * radius;
+    int center_grid_y = game_constants::world_to_grid_y(position.y);
+    int radius_in_cells = static_cast<int>(std::ceil(radius / cell_size));
+    int y0 = std::max(0, center_grid_y - radius_in_cells);
+    int y1 = std::min(game_constants::GRID_HEIGHT - 1,
+                      center_grid_y + radius_in_cells);
+
+    // Where the car is in cell units, measured so cell x's centre is at x
+    float center_cells =
+        (position.x - game_constants::BRICK_START_X) / cell_size - 0.5f;
+    for (int grid_y = y0; grid_y <= y1; ++grid_y) {
+      float dy = cell_center(0, grid_y).y - position.y;
+      float dy_sq = dy * dy;
+      if (dy_sq > radius_sq) {
+        continue;
+      }
+      auto within = [&](int grid_x) {
+        float dx = cell_center(grid_x, grid_y).x - position.x;
+        return dx * dx + dy_sq <= radius_sq;
+      };
+
+      float half_width = std::sqrt(radius_sq - dy_sq) / cell_size;
+      float from = center_cells - half_width;
+      float to = center_cells + half_width;
+      constexpr float width = game_constants::GRID_WIDTH;
+      int x0 = static_cast<int>(std::clamp(std::ceil(from), 0.0f, width));
+      int x1 =
+          static_cast<int>(std::clamp(std::floor(to), -1.0f, width - 1.0f));
+      // Rounding can only misplace an end that lands by a cell centre
+      if (!near_whole(from) && !near_whole(to)) {
+        if (x0 <= x1) {
+          fn(grid_y, x0, x1);
         }
+        continue;
+      }
+      while (x0 <= x1 && !within(x0)) {
+        ++x0;
+      }
+      while (x0 > 0 && within(x0 - 1)) {
+        --x0;
+      }
+      while (x1 >= x0 && !within(x1)) {
+        --x1;
+      }
+      while (x1 < game_constants::GRID_WIDTH - 1 && within(x1 + 1)) {
+        ++x1;
+      }
+      if (x0 <= x1) {
+        fn(grid_y, x0, x1);
+      }
+    }
+  }
 
-        if (fog->is_revealed(grid_x, grid_y)) {
-          continue;
+  // Calls fn(grid_y, x0, x1) for each row of cells whose centres lie within
+  // radius of the segment, the capsule it sweeps, as a single run per row
+  // clipped to the grid. Each row's run is worked out from where the row
+  // crosses the two end discs and the band between them, slightly too
+  // wide, then trimmed at both ends by the per-cell distance test, so runs
+  // hold exactly the cells that test passes.
+  template <typename Fn>
+  static void for_each_capsule_span(const RoadSegment &segment, float radius,
+                                    Fn &&fn) {
+    constexpr float cell_size = game_constants::BRICK_CELL_SIZE;
+    // Keeps rounding from losing a cell the test would pass
+    constexpr float slack = 0.01f;
+    vec2 start = segment.start;
+    vec2 dir = {segment.end.x - start.x, segment.end.y - start.y};
+    float len_sq = dir.x * dir.x + dir.y * dir.y;
+    float length = std::sqrt(len_sq);
+    float radius_sq = radius * radius;
+    float wide = radius + slack;
+
+    float top = std::min(start.y, segment.end.y) - wide;
+    float bottom = std::max(start.y, segment.end.y) + wide;
+    int y0 = std::max(
+        0, static_cast<int>(std::floor(
+               (top - game_constants::BRICK_START_Y) / cell_size - 0.5f)));
+    int y1 = std::min(
+        game_constants::GRID_HEIGHT - 1,
+        static_cast<int>(std::ceil(
+            (bottom - game_constants::BRICK_START_Y) / cell_size - 0.5f)));
+
+    for (int grid_y = y0; grid_y <= y1; ++grid_y) {
+      float row_y = cell_center(0, grid_y).y;
+      auto within = [&](int grid_x) {
+        return distance_sq_to_segment(cell_center(grid_x, grid_y), start, dir,
+                                      len_sq) <= radius_sq;
+      };
+
+      // Where the row's line meets the capsule, in world x
+      float lo = std::numeric_limits<float>::max();
+      float hi = std::numeric_limits<float>::lowest();
+      for (vec2 end : {start, segment.end}) {
+        float dy = row_y - end.y;
+        if (std::abs(dy) <= wide) {
+          float half = std::sqrt(std::max(0.0f, wide * wide - dy * dy));
+          lo = std::min(lo, end.x - half);
+          hi = std::max(hi, end.x + half);
         }
-
-        vec2 cell_world_pos = game_constants::grid_to_world_pos(grid_x, grid_y);
-        vec2 cell_center = {
-            cell_world_pos.x + game_constants::BRICK_CELL_SIZE * 0.5f,
-            cell_world_pos.y + game_constants::BRICK_CELL_SIZE * 0.5f};
-
-        float dx_world = cell_center.x - position.x;
-        float dy_world = cell_center.y - position.y;
-        float dist_sq = dx_world * dx_world + dy_world * dy_world;
-
-        if (dist_sq > reveal_radius_sq) {
-          continue;
+      }
+      if (length > 0.0f) {
+        // Along the segment, its projection must fall between the ends;
+        // across it, the line must be within radius
+        float along_lo = std::numeric_limits<float>::lowest();
+        float along_hi = std::numeric_limits<float>::max();
+        float offset_y = row_y - start.y;
+        float t_slack = slack * length;
+        if (dir.x != 0.0f) {
+          float a = start.x + (-t_slack - offset_y * dir.y) / dir.x;
+          float b = start.x + (len_sq + t_slack - offset_y * dir.y) / dir.x;
+          along_lo = std::min(a, b);
+          along_hi = std::max(a, b);
+        } else if (offset_y * dir.y < -t_slack ||
+                   offset_y * dir.y > len_sq + t_slack) {
+          along_lo = 1.0f;
+          along_hi = 0.0f;
+        }
+        float across = wide * length;
+        if (dir.y != 0.0f) {
+          float a = start.x + (offset_y * dir.x - across) / dir.y;
+          float b = start.x + (offset_y * dir.x + across) / dir.y;
+          along_lo = std::max(along_lo, std::min(a, b));
+          along_hi = std::min(along_hi, std::max(a, b));
+        } else if (std::abs(offset_y * dir.x) > across) {
+          along_lo = 1.0f;
+          along_hi = 0.0f;
+        }
+        if (along_lo <= along_hi) {
+          lo = std::min(lo, along_lo);
+          hi = std::max(hi, along_hi);
         }
+      }
+      if (lo > hi) {
+        continue;
+      }
+
+      constexpr float width = game_constants::GRID_WIDTH;
+      float from = (lo - game_constants::BRICK_START_X) / cell_size - 0.5f;
+      float to = (hi - game_constants::BRICK_START_X) / cell_size - 0.5f;
+      int x0 = static_cast<int>(std::clamp(std::ceil(from), 0.0f, width));
+      int x1 =
+          static_cast<int>(std::clamp(std::floor(to), -1.0f, width - 1.0f));
+      while (x0 <= x1 && !within(x0)) {
+        ++x0;
+      }
+      while (x1 >= x0 && !within(x1)) {
+        --x1;
+      }
+      if (x0 <= x1) {
+        fn(grid_y, x0, x1);
+      }
+    }
+  }
 
-        fog->set_revealed(grid_x, grid_y);
-        photo_reveal->set_revealed(grid_x, grid_y);
+  // Calls fn(grid_y, x0, x1) for each row of cells the segment passes
+  // through or touches, as a single run per row clipped to the grid. Cells
+  // are the ones world_to_grid_x and world_to_grid_y give for points on it.
+  template <typename Fn>
+  static void for_each_crossed_span(const RoadSegment &segment, Fn &&fn) {
+    constexpr float cell_size = game_constants::BRICK_CELL_SIZE;
+    constexpr float slack = 0.01f;
+    vec2 start = segment.start;
+    vec2 dir = {segment.end.x - start.x, segment.end.y - start.y};
+    int y0 = std::max(0, game_constants::world_to_grid_y(
+                             std::min(start.y, segment.end.y) - slack));
+    int y1 = std::min(game_constants::GRID_HEIGHT - 1,
+                      game_constants::world_to_grid_y(
+                          std::max(start.y, segment.end.y) + slack));
+
+    for (int grid_y = y0; grid_y <= y1; ++grid_y) {
+      // The stretch of world y that maps to this row; world_to_grid_y
+      // truncates, so row 0 also takes the cell's height above the grid
+      float band_top = game_constants::BRICK_START_Y +
+                       (grid_y == 0 ? -cell_size : grid_y * cell_size);
+      float band_bottom =
+          game_constants::BRICK_START_Y + (grid_y + 1) * cell_size;
+      float t0 = 0.0f;
+      float t1 = 1.0f;
+      if (dir.y != 0.0f) {
+        float a = (band_top - slack - start.y) / dir.y;
+        float b = (band_bottom + slack - start.y) / dir.y;
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+      } else if (start.y < band_top - slack || start.y > band_bottom + slack) {
+        continue;
+      }
+      if (t0 > t1) {
+        continue;
+      }
+      float xa = start.x + t0 * dir.x;
+      float xb = start.x + t1 * dir.x;
+      int x0 = std::max(0, game_constants::world_to_grid_x(std::min(xa, xb) -
+                                                           slack));
+      int x1 = std::min(game_constants::GRID_WIDTH - 1,
+                        game_constants::world_to_grid_x(std::max(xa, xb) +
+                                                        slack));
+      if (x0 <= x1) {
+        fn(grid_y, x0, x1);
       }
     }
   }
@@ -118,129 +312,59 @@ struct MapRevealSystem {
       return;
     }
 
-    float reveal_radius = fog->reveal_radius;
-
     for (const RoadSegment &segment : road_network->segments) {
-      vec2 start = segment.start;
-      vec2 end = segment.end;
-      vec2 direction = {end.x - start.x, end.y - start.y};
-      float segment_length =
-          std::sqrt(direction.x * direction.x + direction.y * direction.y);
-
-      if (segment_length < 0.001f) {
-        mark_reachable_position(start, reveal_radius, fog);
-        continue;
-      }
-
-      int steps =
-          static_cast<int>(std::ceil(segment_length / reveal_radius)) + 1;
-
-      for (int i = 0; i <= steps; ++i) {
-        float t = static_cast<float>(i) / static_cast<float>(steps);
-        vec2 pos = {start.x + direction.x * t, start.y + direction.y * t};
-        mark_reachable_position(pos, reveal_radius, fog);
-      }
+      for_each_capsule_span(segment, fog->reveal_radius,
+                            [&](int grid_y, int x0, int x1) {
+                              fog->reachable_cells.set_span(grid_y, x0, x1);
+                            });
     }
 
     fog->reachable_computed = true;
   }
 
 private:
-  static void mark_reachable_position(const vec2 &position, float radius,
-                                      FogOfWar *fog) {
-    float reveal_radius_sq = radius * radius;
-    int center_grid_x = game_constants::world_to_grid_x(position.x);
-    int center_grid_y = game_constants::world_to_grid_y(position.y);
-
-    int radius_in_cells =
-        static_cast<int>(std::ceil(radius / game_constants::BRICK_CELL_SIZE));
-
-    for (int dy = -radius_in_cells; dy <= radius_in_cells; ++dy) {
-      for (int dx = -radius_in_cells; dx <= radius_in_cells; ++dx) {
-        int grid_x = center_grid_x + dx;
-        int grid_y = center_grid_y + dy;
-
-        if (grid_x < 0 || grid_x >= game_constants::GRID_WIDTH || grid_y < 0 ||
-            grid_y >= game_constants::GRID_HEIGHT) {
-          continue;
-        }
-
-        if (fog->is_reachable(grid_x, grid_y)) {
-          continue;
-        }
+  // Within a rounding error of a whole number, which for a run end in
+  // cells means within one of a cell centre
+  static bool near_whole(float cells) {
+    return std::abs(cells - std::round(cells)) < 1e-3f;
+  }
 
-        vec2 cell_world_pos = game_constants::grid_to_world_pos(grid_x, grid_y);
-        vec2 cell_center = {
-            cell_world_pos.x + game_constants::BRICK_CELL_SIZE * 0.5f,
+  static vec2 cell_center(int grid_x, int grid_y) {
+    vec2 cell_world_pos = game_constants::grid_to_world_pos(grid_x, grid_y);
+    return {cell_world_pos.x + game_constants::BRICK_CELL_SIZE * 0.5f,
             cell_world_pos.y + game_constants::BRICK_CELL_SIZE * 0.5f};
+  }
 
-        float dx_world = cell_center.x - position.x;
-        float dy_world = cell_center.y - position.y;
-        float dist_sq = dx_world * dx_world + dy_world * dy_world;
-
-        if (dist_sq <= reveal_radius_sq) {
-          fog->set_reachable(grid_x, grid_y);
-        }
-      }
+  static float distance_sq_to_segment(vec2 point, vec2 start, vec2 dir,
+                                      float len_sq) {
+    float t = 0.0f;
+    if (len_sq > 0.0f) {
+      t = std::clamp(
+          ((point.x - start.x) * dir.x + (point.y - start.y) * dir.y) / len_sq,
+          0.0f, 1.0f);
     }
+    float dx = point.x - (start.x + t * dir.x);
+    float dy = point.y - (start.y + t * dir.y);
+    return dx * dx + dy * dy;
   }
 
   static void reveal_segment_fog(const RoadSegment &segment, FogOfWar *fog) {
-    vec2 start = segment.start;
-    vec2 end = segment.end;
-    vec2 direction = {end.x - start.x, end.y - start.y};
-    float segment_length =
-        std::sqrt(direction.x * direction.x + direction.y * direction.y);
-
-    if (segment_length < 0.001f) {
-      reveal_position(start, fog->reveal_radius);
-      return;
-    }
-
-    float reveal_radius = fog->reveal_radius;
-    int steps = static_cast<int>(std::ceil(segment_length / reveal_radius)) + 1;
-
-    for (int i = 0; i <= steps; ++i) {
-      float t = static_cast<float>(i) / static_cast<float>(steps);
-      vec2 pos = {start.x + direction.x * t, start.y + direction.y * t};
-      reveal_position(pos, reveal_radius);
-    }
+    IsPhotoReveal *photo_reveal =
+        afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
+    invariant(photo_reveal, "IsPhotoReveal singleton not found");
+    for_each_capsule_span(segment, fog->reveal_radius,
+                          [&](int grid_y, int x0, int x1) {
+                            reveal_span(*fog, *photo_reveal, grid_y, x0, x1);
+                          });
   }
 
   static bool is_segment_revealed_in_fog(const RoadSegment &segment,
                                          FogOfWar *fog) {
-    vec2 start = segment.start;
-    vec2 end = segment.end;
-    vec2 direction = {end.x - start.x, end.y - start.y};
-    float segment_length =
-        std::sqrt(direction.x * direction.x + direction.y * direction.y);
-
-    if (segment_length < 0.001f) {
-      int grid_x = game_constants::world_to_grid_x(start.x);
-      int grid_y = game_constants::world_to_grid_y(start.y);
-      return fog->is_revealed(grid_x, grid_y);
-    }
-
-    float reveal_radius = fog->reveal_radius;
-    int steps = static_cast<int>(std::ceil(segment_length / reveal_radius)) + 1;
-
     bool any_revealed = false;
-    for (int i = 0; i <= steps; ++i) {
-      float t = static_cast<float>(i) / static_cast<float>(steps);
-      vec2 pos = {start.x + direction.x * t, start.y + direction.y * t};
-
-      int grid_x = game_constants::world_to_grid_x(pos.x);
-      int grid_y = game_constants::world_to_grid_y(pos.y);
-
-      if (grid_x >= 0 && grid_x < game_constants::GRID_WIDTH && grid_y >= 0 &&
-          grid_y < game_constants::GRID_HEIGHT) {
-        if (fog->is_revealed(grid_x, grid_y)) {
-          any_revealed = true;
-          break;
-        }
-      }
-    }
-
+    for_each_crossed_span(segment, [&](int grid_y, int x0, int x1) {
+      any_revealed =
+          any_revealed || fog->revealed_cells.any_in_span(grid_y, x0, x1);
+    });
     return any_revealed;
   }
 };
@@ -2,41 +2,48 @@
 
 #include "../components.h"
 #include "../eq.h"
-#include "../game_constants.h"
+#include "../exploration_policies.h"
 #include "../log.h"
 #include "MapRevealSystem.h"
 #include <afterhours/ah.h>
 #include <algorithm>
 #include <cmath>
-#include <set>
+#include <type_traits>
 #include <vector>
 
 struct MazeTraversal
     : afterhours::System<
           Transform, RoadFollowing,
           afterhours::tags::Any<ColliderTag::Square, ColliderTag::Circle>> {
-  static size_t last_segment_index;
-  static size_t second_last_segment_index;
+  static inline size_t last_segment_index = SIZE_MAX;
+  static inline size_t second_last_segment_index = SIZE_MAX;
 
-  static bool detect_loop(const std::vector<size_t> &recent_segments,
-                          size_t next_seg) {
-    if (recent_segments.size() < 4) {
+  using SegmentHistory = SegmentRing<RoadFollowing::MAX_HISTORY_SIZE>;
+
+  // Most segments a car crosses in one tick, which bounds the work when a
+  // fast car meets a run of tiny segments
+  static constexpr int MAX_SEGMENTS_PER_TICK = 64;
+
+  // True when driving next_seg would repeat a recent run of segments.
+  // Reads the history plus next_seg in place rather than copying it.
+  static bool detect_loop(const SegmentHistory &history, size_t next_seg) {
+    size_t n = history.size() + 1;
+    auto at = [&](size_t i) {
+      return i < history.size() ? history[i] : next_seg;
+    };
+    if (n < 4) {
       return false;
     }
 
-    for (size_t pattern_len = 2; pattern_len <= recent_segments.size() / 2;
-         ++pattern_len) {
+    for (size_t pattern_len = 3; pattern_len <= n / 2; ++pattern_len) {
       bool is_loop = true;
       for (size_t i = 0; i < pattern_len; ++i) {
-        size_t idx1 = recent_segments.size() - i;
-        size_t idx2 = recent_segments.size() - pattern_len - i;
-        size_t seg1 = (i == 0) ? next_seg : recent_segments[idx1 - 1];
-        if (idx2 >= recent_segments.size() || seg1 != recent_segments[idx2]) {
+        if (at(n - 1 - i) != at(n - pattern_len - i)) {
           is_loop = false;
           break;
         }
       }
-      if (is_loop && pattern_len >= 3) {
+      if (is_loop) {
         return true;
       }
     }
@@ -44,24 +51,213 @@ struct MazeTraversal
     return false;
   }
 
-  virtual void once(float) override {}
+  virtual void once(float dt) override {
+    refresh_frontier();
+    CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    if (cars) {
+      drive_pool(*cars, dt, MAX_SEGMENTS_PER_TICK,
+                 afterhours::EntityHelper::get_singleton_cmp<
+                     SimulationWorkers>());
+    }
+  }
+
+  // Folds last frame's visits into the frontier field in one batch and
+  // picks up any coverage tours the planner has finished
+  static void refresh_frontier() {
+    RoadNetwork *road_network =
+        afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
+    if (road_network && road_network->is_loaded) {
+      road_network->frontier.refresh(road_network->graph,
+                                     road_network->chains);
+      CoverageRouting *routing =
+          afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>();
+      if (routing) {
+        routing->collect(*road_network);
+      }
+    }
+  }
 
   virtual void for_each_with(afterhours::Entity & /* entity */,
                              Transform &transform,
                              RoadFollowing &road_following, float dt) override {
-    RoadNetwork *road_network =
-        afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
-    if (!road_network || !road_network->is_loaded ||
-        road_network->segments.empty()) {
+    advance(transform, road_following, dt, MAX_SEGMENTS_PER_TICK);
+  }
+
+  // Drives one car for dt, crossing at most max_segments segments. Offline
+  // catch-up calls this with whole seconds at a time and a matching cap.
+  static void advance(Transform &transform,
+                      RoadFollowingState &road_following, float dt,
+                      int max_segments) {
+    Tick tick;
+    if (!begin_tick(tick)) {
+      return;
+    }
+    drive(tick, transform.position, road_following, dt, max_segments);
+
+    // Heading along whichever segment the car is now on
+    if (road_following.current_segment_index >=
+        tick.road_network->segments.size()) {
+      return;
+    }
+    const RoadSegment &segment =
+        tick.road_network->segments[road_following.current_segment_index];
+    vec2 direction = {segment.end.x - segment.start.x,
+                      segment.end.y - segment.start.y};
+    float length =
+        std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    if (length >= 0.001f) {
+      float sign = road_following.reverse_direction ? -1.0f : 1.0f;
+      float scale = sign * road_following.speed / length;
+      transform.velocity = {direction.x * scale, direction.y * scale};
+    }
+  }
+
+  // Drives every pooled car for dt, with the same result as in pool order.
+  // A car partway along a road it has already revealed only moves along
+  // it, which needs nothing but its own hot arrays; the rest load their
+  // cold state and go through the same junction logic as entity cars.
+  //
+  // With workers, the gliding cars move in parallel first, each lane over
+  // its own slice of the pool, and everything they touch is theirs alone.
+  // The cars left at junctions then take their turns serially in pool
+  // order, so every visit, claim and random draw lands exactly as it would
+  // serially. Roads only ever become visited during a tick, so a car that
+  // could glide at the start of it could glide at its turn too, and a
+  // deferred car whose road was revealed before its turn glides then.
+  static void drive_pool(CarPool &cars, float dt, int max_segments,
+                         SimulationWorkers *workers = nullptr) {
+    Tick tick;
+    if (!begin_tick(tick)) {
+      return;
+    }
+    const RoadNetwork &road_network = *tick.road_network;
+    size_t count = cars.size();
+    if (!workers || !workers->runs_parallel(count)) {
+      for (size_t car = 0; car < count; ++car) {
+        if (!glide(road_network, cars, car, dt)) {
+          drive_loaded(tick, cars, car, dt, max_segments);
+        }
+      }
       return;
     }
 
-    // Update algorithm from shop if available
+    workers->for_each_slice(count, [&](size_t begin, size_t end,
+                                       std::vector<uint32_t> &at_junction) {
+      for (size_t car = begin; car < end; ++car) {
+        if (!glide(road_network, cars, car, dt)) {
+          at_junction.push_back(static_cast<uint32_t>(car));
+        }
+      }
+    });
+    for (const std::vector<uint32_t> &at_junction : workers->deferred) {
+      for (uint32_t car : at_junction) {
+        if (!glide(road_network, cars, car, dt)) {
+          drive_loaded(tick, cars, car, dt, max_segments);
+        }
+      }
+    }
+  }
+
+private:
+  // What every car this tick shares, looked up once rather than per car
+  struct Tick {
+    RoadNetwork *road_network{nullptr};
+    MazeAlgorithm algorithm{MazeAlgorithm::WallFollower};
+    bool prioritize_unvisited{false};
+  };
+
+  // False when there is no road to drive
+  static bool begin_tick(Tick &tick) {
+    tick.road_network =
+        afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
+    if (!tick.road_network || !tick.road_network->is_loaded ||
+        tick.road_network->segments.empty()) {
+      return false;
+    }
+
     IsShopManager *shop =
         afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
     invariant(shop, "Shop manager not found");
-    road_following.current_algorithm = shop->get_current_algorithm();
+    tick.algorithm = shop->get_current_algorithm();
+
+    FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
+    invariant(fog, "FogOfWar singleton not found");
+    float reveal_percentage = fog->get_reveal_percentage();
+    // A coverage tour already finishes the map as directly as it can
+    tick.prioritize_unvisited = reveal_percentage >= 90.0f &&
+                                tick.algorithm != MazeAlgorithm::Route;
+    return true;
+  }
+
+  // Moves a pooled car along a revealed segment it won't reach the end of
+  // this tick, with the same arithmetic as drive_segment so both paths
+  // agree exactly. False, leaving the car as it was, for any other car.
+  static bool glide(const RoadNetwork &road_network, CarPool &cars,
+                    size_t car, float dt) {
+    const MappedArray<RoadSegment> &segments = road_network.segments;
+    uint32_t seg = cars.segment[car];
+    float progress = cars.progress[car];
+    if (seg >= segments.size() || progress <= 0.0f ||
+        !road_network.is_visited(seg)) {
+      return false;
+    }
+    const RoadSegment &segment = segments[seg];
+    vec2 segment_start = cars.reverse[car] ? segment.end : segment.start;
+    vec2 segment_end = cars.reverse[car] ? segment.start : segment.end;
+    vec2 direction = {segment_end.x - segment_start.x,
+                      segment_end.y - segment_start.y};
+    float segment_length =
+        std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    float distance_to_travel = cars.speed[car] * dt;
+    if (segment_length < 0.001f ||
+        distance_to_travel >= (1.0f - progress) * segment_length) {
+      return false;
+    }
+    progress += distance_to_travel / segment_length;
+    cars.progress[car] = progress;
+    cars.position[car] = {segment_start.x + progress * direction.x,
+                          segment_start.y + progress * direction.y};
+    return true;
+  }
+
+  static void drive_loaded(const Tick &tick, CarPool &cars, size_t car,
+                           float dt, int max_segments) {
+    RoadFollowingState &road_following = cars.load(car);
+    drive(tick, cars.position[car], road_following, dt, max_segments);
+    cars.store(car);
+  }
+
+  static void drive(const Tick &tick, vec2 &position,
+                    RoadFollowingState &road_following, float dt,
+                    int max_segments) {
+    // Update algorithm from shop
+    if (tick.algorithm != road_following.current_algorithm) {
+      forget_route(road_following);
+    }
+    road_following.current_algorithm = tick.algorithm;
+    if (road_following.agent_id == FrontierClaims::FREE) {
+      road_following.agent_id = tick.road_network->claims.new_agent();
+    }
+
+    // Spend the whole distance budget, crossing as many segments and
+    // junctions as it covers; each is revealed as the car reaches it
+    float distance_to_travel = road_following.speed * dt;
+    for (int step = 0; step < max_segments; ++step) {
+      if (!drive_segment(position, road_following, tick.road_network,
+                         tick.prioritize_unvisited, distance_to_travel)) {
+        break;
+      }
+    }
+  }
 
+  // Drives the current segment as far as the budget allows, taking the
+  // junction at its end if it gets there. True when the car is on a new
+  // segment with distance left to spend.
+  static bool drive_segment(vec2 &position,
+                            RoadFollowingState &road_following,
+                            RoadNetwork *road_network,
+                            bool prioritize_unvisited,
+                            float &distance_to_travel) {
     if (road_following.current_segment_index >= road_network->segments.size()) {
       road_following.current_segment_index = 0;
       road_following.progress_along_segment = 0.0f;
@@ -84,50 +280,29 @@ struct MazeTraversal
       road_following.current_segment_index++;
       road_following.progress_along_segment = 0.0f;
       road_following.reverse_direction = false;
-      return;
+      return true;
     }
 
-    float normalized_x = direction.x / segment_length;
-    float normalized_y = direction.y / segment_length;
-
     bool just_revealed =
         MapRevealSystem::reveal_segment(road_following.current_segment_index);
 
-    FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
-    invariant(fog, "FogOfWar singleton not found");
-    float reveal_percentage = fog->get_reveal_percentage();
-    bool prioritize_unvisited = reveal_percentage >= 90.0f;
-
-    // Update segments_without_reveal counter
+    // Update segments_without_reveal counter, once per segment driven
     if (just_revealed) {
       road_following.segments_without_reveal = 0;
+      road_following.seeking_frontier = false;
       road_following.forced_direction_attempts =
           0; // Reset when we reveal a new segment
-    } else {
+    } else if (road_following.progress_along_segment == 0.0f) {
       road_following.segments_without_reveal++;
     }
 
-    // At 90%+, if we've been going through visited segments for too long, jump
-    // to unvisited
+    // At 90%+, if we've been going through visited segments for too long,
+    // head for unvisited road
     if (prioritize_unvisited && road_following.segments_without_reveal >= 5) {
-      size_t random_unvisited = road_network->find_random_unvisited_segment();
-      if (random_unvisited != SIZE_MAX) {
-        log_info("MazeTraversal: At 90%+, jumping to unvisited segment {} "
-                 "after {} visited segments",
-                 random_unvisited, road_following.segments_without_reveal);
-        road_following.current_segment_index = random_unvisited;
-        road_following.progress_along_segment = 0.0f;
-        road_following.reverse_direction = false;
-        road_following.segments_without_reveal = 0;
-        road_following.segment_history.clear();
-        const RoadSegment &new_seg = road_network->segments[random_unvisited];
-        transform.position = new_seg.start;
-        return;
-      }
+      road_following.seeking_frontier = true;
     }
 
     // Move along current segment
-    float distance_to_travel = road_following.speed * dt;
     float remaining_on_segment =
         (1.0f - road_following.progress_along_segment) * segment_length;
 
@@ -135,35 +310,46 @@ struct MazeTraversal
       // Continue along current segment
       road_following.progress_along_segment +=
           distance_to_travel / segment_length;
-      transform.position.x =
+      position.x =
           segment_start.x + road_following.progress_along_segment * direction.x;
-      transform.position.y =
+      position.y =
           segment_start.y + road_following.progress_along_segment * direction.y;
 
-      road_following.last_position = transform.position;
-      transform.velocity.x = normalized_x * road_following.speed;
-      transform.velocity.y = normalized_y * road_following.speed;
-      return;
+      road_following.last_position = position;
+      return false;
     }
 
     // Reached end of segment, select next segment
-    transform.position = segment_end;
+    position = segment_end;
     road_following.progress_along_segment = 0.0f;
+    distance_to_travel -= remaining_on_segment;
+
+    // Inside a chain there is only one way on, so skip the junction logic
+    uint32_t chain_link = road_network->chains.continue_link(
+        RoadGraph::exit_port(road_following.current_segment_index,
+                             road_following.reverse_direction));
+    if (chain_link != RoadChains::INVALID) {
+      remember_segment(road_following);
+      road_following.current_segment_index =
+          RoadGraph::link_segment(chain_link);
+      road_following.reverse_direction = RoadGraph::link_reverse(chain_link);
+      road_following.last_position = position;
+      return distance_to_travel > 0.0f;
+    }
 
-    vec2 current_end = segment_end;
-    // Connection tolerance should match road width (square size = 12.0)
-    // Use a small tolerance to only connect segments that actually meet
-    float connection_tolerance = 15.0f; // Slightly larger than square size
     size_t next_segment_index = SIZE_MAX;
     bool next_reverse_direction = false;
 
     // Select next segment based on algorithm or forced direction mode
-    if (road_following.forced_direction_steps > 0) {
+    if (road_following.seeking_frontier &&
+        head_for_frontier(road_following, road_network, next_segment_index,
+                          next_reverse_direction)) {
+      // Routed downhill toward the nearest unvisited road
+    } else if (road_following.forced_direction_steps > 0) {
       // Forced direction mode: choose segment that best matches forced
       // direction
-      select_next_forced_direction(road_following, road_network, current_end,
-                                   connection_tolerance, next_segment_index,
-                                   next_reverse_direction);
+      select_next_forced_direction(road_following, road_network,
+                                   next_segment_index, next_reverse_direction);
       if (next_segment_index != SIZE_MAX) {
         road_following.forced_direction_steps--;
         if (road_following.forced_direction_steps == 0) {
@@ -178,59 +364,63 @@ struct MazeTraversal
         }
       }
     } else {
-      // Normal algorithm selection - all algorithms currently use wall follower
-      select_next_wall_follower(road_following, road_network, current_end,
-                                connection_tolerance, next_segment_index,
-                                next_reverse_direction);
-
-      // At 90%+, if no unvisited segments found at junction, jump to one
-      if (prioritize_unvisited && next_segment_index != SIZE_MAX) {
-        bool next_is_unvisited = !road_network->is_visited(next_segment_index);
-        if (!next_is_unvisited) {
-          size_t random_unvisited =
-              road_network->find_random_unvisited_segment();
-          if (random_unvisited != SIZE_MAX) {
-            log_info("MazeTraversal: At 90%+, no unvisited at junction, "
-                     "jumping to unvisited segment {}",
-                     random_unvisited);
-            next_segment_index = random_unvisited;
-            next_reverse_direction = false;
-            road_following.segment_history.clear();
-          }
-        }
+      switch (road_following.current_algorithm) {
+      case MazeAlgorithm::WallFollower:
+        select_next_wall_follower(road_following, road_network,
+                                  next_segment_index, next_reverse_direction);
+        break;
+      case MazeAlgorithm::Tremaux:
+        select_next_with<TremauxPolicy>(road_following, road_network,
+                                        next_segment_index,
+                                        next_reverse_direction);
+        break;
+      case MazeAlgorithm::DFS:
+        select_next_with<DfsPolicy>(road_following, road_network,
+                                    next_segment_index,
+                                    next_reverse_direction);
+        break;
+      case MazeAlgorithm::AStar:
+        select_next_with<AStarPolicy>(road_following, road_network,
+                                      next_segment_index,
+                                      next_reverse_direction);
+        break;
+      case MazeAlgorithm::Route:
+        select_next_with<RoutePolicy>(road_following, road_network,
+                                      next_segment_index,
+                                      next_reverse_direction);
+        break;
+      }
+
+      // At 90%+, if no unvisited segments found at junction, head for one
+      if (prioritize_unvisited && next_segment_index != SIZE_MAX &&
+          road_network->is_visited(next_segment_index)) {
+        road_following.seeking_frontier = true;
+        head_for_frontier(road_following, road_network, next_segment_index,
+                          next_reverse_direction);
       }
     }
 
     if (next_segment_index != SIZE_MAX) {
-      road_following.segment_history.push_back(
-          road_following.current_segment_index);
-      if (road_following.segment_history.size() >
-          RoadFollowing::MAX_HISTORY_SIZE) {
-        road_following.segment_history.erase(
-            road_following.segment_history.begin());
-      }
+      remember_segment(road_following);
 
-      std::vector<size_t> test_history = road_following.segment_history;
-      test_history.push_back(next_segment_index);
-      bool is_loop = detect_loop(test_history, next_segment_index);
+      // The other algorithms keep their own memory and never loop
+      bool is_loop =
+          road_following.current_algorithm == MazeAlgorithm::WallFollower &&
+          detect_loop(road_following.segment_history, next_segment_index);
 
       if (is_loop) {
-        size_t random_unvisited = road_network->find_random_unvisited_segment();
-        if (random_unvisited != SIZE_MAX) {
-          log_warn(
-              "MazeTraversal: Loop detected, jumping to unvisited segment {}",
-              random_unvisited);
-          next_segment_index = random_unvisited;
-          next_reverse_direction = false;
-          road_following.segment_history.clear();
+        road_following.segment_history.clear();
+        road_following.seeking_frontier = true;
+        if (head_for_frontier(road_following, road_network,
+                              next_segment_index, next_reverse_direction)) {
+          log_warn("MazeTraversal: Loop detected, heading for unvisited road");
         } else {
           log_warn("MazeTraversal: Loop detected but no unvisited segments "
                    "available");
         }
       }
 
-      second_last_segment_index = last_segment_index;
-      last_segment_index = road_following.current_segment_index;
+      stake_claim(road_following, road_network, next_segment_index);
       road_following.current_segment_index = next_segment_index;
       road_following.reverse_direction = next_reverse_direction;
     } else {
@@ -238,379 +428,225 @@ struct MazeTraversal
                road_following.current_segment_index);
     }
 
-    road_following.last_position = transform.position;
-    transform.velocity.x = normalized_x * road_following.speed;
-    transform.velocity.y = normalized_y * road_following.speed;
+    road_following.last_position = position;
+    return next_segment_index != SIZE_MAX && distance_to_travel > 0.0f;
   }
 
-private:
-  static void select_next_wall_follower(RoadFollowing &road_following,
-                                        RoadNetwork *road_network,
-                                        const vec2 &current_end,
-                                        float connection_tolerance,
-                                        size_t &next_segment_index,
-                                        bool &next_reverse_direction) {
-    size_t current_seg = road_following.current_segment_index;
-    if (current_seg >= road_network->segment_connections.size()) {
-      return;
+  // Drops everything the car remembers about its route, for when it
+  // teleports or switches algorithm
+  static void forget_route(RoadFollowingState &road_following) {
+    road_following.segment_history.clear();
+    ExplorationPool *pool =
+        afterhours::EntityHelper::get_singleton_cmp<ExplorationPool>();
+    if (pool && road_following.exploration_slot < pool->slots.size()) {
+      pool->slots[road_following.exploration_slot].clear();
     }
+  }
 
-    FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
-    invariant(fog, "FogOfWar singleton not found");
-    float reveal_percentage = fog->get_reveal_percentage();
-    bool prioritize_unvisited = reveal_percentage >= 90.0f;
-
-    // Determine which endpoint we're at: 0 = start, 1 = end
-    size_t endpoint_idx = road_following.reverse_direction ? 0 : 1;
-    const auto &connections =
-        road_network->segment_connections[current_seg][endpoint_idx];
+  // Records the segment being left so later junctions skip it
+  static void remember_segment(RoadFollowingState &road_following) {
+    road_following.segment_history.push(road_following.current_segment_index);
+    second_last_segment_index = last_segment_index;
+    last_segment_index = road_following.current_segment_index;
+  }
 
-    if (connections.empty()) {
+  // Swaps the car's claim over to the chain it is about to drive, so cars
+  // reaching this junction after it take other open roads
+  static void stake_claim(RoadFollowingState &road_following,
+                          RoadNetwork *road_network, size_t next_segment) {
+    uint32_t chain = road_network->chains.chain_of(next_segment);
+    if (chain == road_following.claimed_chain) {
       return;
     }
-
-    // Get current direction for angle calculation
-    const RoadSegment &current_segment = road_network->segments[current_seg];
-    vec2 current_start = road_following.reverse_direction
-                             ? current_segment.end
-                             : current_segment.start;
-    vec2 current_dir = {current_end.x - current_start.x,
-                        current_end.y - current_start.y};
-    float current_dir_len = std::sqrt(current_dir.x * current_dir.x +
-                                      current_dir.y * current_dir.y);
-    if (current_dir_len <= 0.001f) {
-      return;
+    road_network->claims.release(road_following.claimed_chain,
+                                 road_following.agent_id);
+    road_following.claimed_chain = RoadGraph::INVALID;
+    if (!road_network->is_visited(next_segment) &&
+        road_network->claims.try_claim(chain, road_following.agent_id)) {
+      road_following.claimed_chain = chain;
     }
-    current_dir.x /= current_dir_len;
-    current_dir.y /= current_dir_len;
-
-    // Collect valid candidates with their angles
-    struct Candidate {
-      size_t segment_index;
-      bool reverse;
-      float angle;
-      bool is_unvisited;
-      float distance;
-    };
-    std::vector<Candidate> candidates;
+  }
 
-    std::set<size_t> recent_segments;
-    recent_segments.insert(last_segment_index);
-    recent_segments.insert(second_last_segment_index);
-    for (size_t hist_seg : road_following.segment_history) {
-      recent_segments.insert(hist_seg);
+  static bool is_recent(const RoadFollowingState &road_following,
+                        size_t segment, bool include_history) {
+    if (segment == last_segment_index ||
+        segment == second_last_segment_index) {
+      return true;
     }
-
-    for (const auto &[connected_seg, use_reverse] : connections) {
-      if (connected_seg == current_seg) {
-        continue;
-      }
-      if (recent_segments.find(connected_seg) != recent_segments.end()) {
-        continue;
-      }
-
-      const RoadSegment &candidate_seg = road_network->segments[connected_seg];
-      vec2 cand_start = use_reverse ? candidate_seg.end : candidate_seg.start;
-      vec2 cand_end = use_reverse ? candidate_seg.start : candidate_seg.end;
-
-      // Calculate direction vector
-      vec2 cand_dir = {cand_end.x - cand_start.x, cand_end.y - cand_start.y};
-      float cand_len =
-          std::sqrt(cand_dir.x * cand_dir.x + cand_dir.y * cand_dir.y);
-      if (cand_len < 0.001f) {
-        continue;
-      }
-      cand_dir.x /= cand_len;
-      cand_dir.y /= cand_len;
-
-      // Calculate angle relative to current direction (right-hand rule)
-      // Use cross product to determine if right or left
-      float cross = current_dir.x * cand_dir.y - current_dir.y * cand_dir.x;
-      float dot = current_dir.x * cand_dir.x + current_dir.y * cand_dir.y;
-      float angle = std::atan2(cross, dot); // Range: -PI to PI
-
-      // Distance check
-      float dist_to_start = std::sqrt(
-          (cand_start.x - current_end.x) * (cand_start.x - current_end.x) +
-          (cand_start.y - current_end.y) * (cand_start.y - current_end.y));
-      float dist_to_end = std::sqrt(
-          (cand_end.x - current_end.x) * (cand_end.x - current_end.x) +
-          (cand_end.y - current_end.y) * (cand_end.y - current_end.y));
-
-      if (dist_to_start >= connection_tolerance &&
-          dist_to_end >= connection_tolerance) {
-        continue;
-      }
-      bool is_unvisited = !road_network->is_visited(connected_seg);
-      candidates.push_back({connected_seg, use_reverse, angle, is_unvisited,
-                            std::min(dist_to_start, dist_to_end)});
+    if (!include_history) {
+      return false;
     }
+    return road_following.segment_history.contains(segment);
+  }
 
-    if (candidates.empty()) {
-      std::set<size_t> recent_segments_fallback;
-      recent_segments_fallback.insert(last_segment_index);
-      recent_segments_fallback.insert(second_last_segment_index);
-      for (const auto &[connected_seg, use_reverse] : connections) {
-        if (connected_seg == current_seg) {
-          continue;
-        }
-        if (recent_segments_fallback.find(connected_seg) !=
-            recent_segments_fallback.end()) {
+  static std::span<const RoadTurn>
+  junction_turns(const RoadFollowingState &road_following,
+                 const RoadNetwork *road_network) {
+    return road_network->turns.at(
+        RoadGraph::exit_port(road_following.current_segment_index,
+                             road_following.reverse_direction));
+  }
+
+  // Wall follower: follow the right wall. The turn table is already in
+  // preference order (straight, then right, then left), so the first open
+  // turn wins and otherwise the first allowed one. Recently driven
+  // segments are skipped unless nothing else is left.
+  static void select_next_wall_follower(RoadFollowingState &road_following,
+                                        RoadNetwork *road_network,
+                                        size_t &next_segment_index,
+                                        bool &next_reverse_direction) {
+    std::span<const RoadTurn> turns =
+        junction_turns(road_following, road_network);
+    for (bool include_history : {true, false}) {
+      const RoadTurn *fallback = nullptr;
+      for (const RoadTurn &turn : turns) {
+        size_t seg = RoadGraph::link_segment(turn.link);
+        if (is_recent(road_following, seg, include_history)) {
           continue;
         }
-        const RoadSegment &candidate_seg =
-            road_network->segments[connected_seg];
-        vec2 cand_start = use_reverse ? candidate_seg.end : candidate_seg.start;
-        vec2 cand_end = use_reverse ? candidate_seg.start : candidate_seg.end;
-        vec2 cand_dir = {cand_end.x - cand_start.x, cand_end.y - cand_start.y};
-        float cand_len =
-            std::sqrt(cand_dir.x * cand_dir.x + cand_dir.y * cand_dir.y);
-        if (cand_len < 0.001f) {
-          continue;
+        if (road_network->is_open_for(seg, road_following.agent_id)) {
+          fallback = &turn;
+          break;
         }
-        cand_dir.x /= cand_len;
-        cand_dir.y /= cand_len;
-        float cross = current_dir.x * cand_dir.y - current_dir.y * cand_dir.x;
-        float dot = current_dir.x * cand_dir.x + current_dir.y * cand_dir.y;
-        float angle = std::atan2(cross, dot);
-        float dist_to_start = std::sqrt(
-            (cand_start.x - current_end.x) * (cand_start.x - current_end.x) +
-            (cand_start.y - current_end.y) * (cand_start.y - current_end.y));
-        float dist_to_end = std::sqrt(
-            (cand_end.x - current_end.x) * (cand_end.x - current_end.x) +
-            (cand_end.y - current_end.y) * (cand_end.y - current_end.y));
-        if (dist_to_start >= connection_tolerance &&
-            dist_to_end >= connection_tolerance) {
-          continue;
+        if (!fallback) {
+          fallback = &turn;
         }
-        bool is_unvisited = !road_network->is_visited(connected_seg);
-        candidates.push_back({connected_seg, use_reverse, angle, is_unvisited,
-                              std::min(dist_to_start, dist_to_end)});
       }
-      if (candidates.empty()) {
+      if (fallback) {
+        next_segment_index = RoadGraph::link_segment(fallback->link);
+        next_reverse_direction = RoadGraph::link_reverse(fallback->link);
         return;
       }
     }
-
-    if (prioritize_unvisited) {
-      std::vector<Candidate> unvisited_candidates;
-      std::vector<Candidate> visited_candidates;
-      for (const auto &cand : candidates) {
-        if (cand.is_unvisited) {
-          unvisited_candidates.push_back(cand);
-        } else {
-          visited_candidates.push_back(cand);
-        }
-      }
-
-      if (!unvisited_candidates.empty()) {
-        std::sort(unvisited_candidates.begin(), unvisited_candidates.end(),
-                  [](const Candidate &a, const Candidate &b) {
-                    float abs_angle_a = std::abs(a.angle);
-                    float abs_angle_b = std::abs(b.angle);
-                    if (abs_angle_a < 0.1f && abs_angle_b >= 0.1f) {
-                      return true;
-                    }
-                    if (abs_angle_a >= 0.1f && abs_angle_b < 0.1f) {
-                      return false;
-                    }
-                    if (abs_angle_a < 0.1f && abs_angle_b < 0.1f) {
-                      return abs_angle_a < abs_angle_b;
-                    }
-                    if (a.angle > 0.0f && b.angle <= 0.0f) {
-                      return true;
-                    }
-                    if (a.angle <= 0.0f && b.angle > 0.0f) {
-                      return false;
-                    }
-                    return abs_angle_a < abs_angle_b;
-                  });
-        next_segment_index = unvisited_candidates[0].segment_index;
-        next_reverse_direction = unvisited_candidates[0].reverse;
-        return;
-      }
+    // The last two segments are shared by every car, so they can rule out
+    // a whole junction that this car never drove
+    if (!turns.empty()) {
+      next_segment_index = RoadGraph::link_segment(turns.front().link);
+      next_reverse_direction = RoadGraph::link_reverse(turns.front().link);
     }
-
-    // Wall follower: Follow right wall
-    // Priority order (for visited segments):
-    // 1. Straight ahead (angle closest to 0) - ONLY turn if can't go straight
-    // 2. Right turn (positive angle, prefer angles closer to +90°)
-    // 3. Left turn (negative angle, prefer angles closer to -90°)
-    // 4. Turn around (angle closest to ±180°)
-    // Unvisited segments always take priority
-    std::sort(
-        candidates.begin(), candidates.end(),
-        [](const Candidate &a, const Candidate &b) {
-          // First priority: unvisited segments
-          if (a.is_unvisited != b.is_unvisited) {
-            return a.is_unvisited;
-          }
-
-          // For visited segments, follow right wall algorithm:
-          // Calculate priority scores (lower = higher priority)
-          auto get_priority = [](float angle) -> float {
-            // Straight (angle ≈ 0): highest priority (only turn if can't go
-            // straight)
-            float abs_angle = std::abs(angle);
-            if (abs_angle <
-                0.1f) { // ~6 degrees tolerance for "straight" - stricter
-              return abs_angle; // 0 is best, small angles are good
-            }
-            // Right turn (0 to π): second priority
-            if (angle > 0.0f) {
-              return 1.0f + angle / 3.14159f; // Range: 1.0 (small right) to 2.0
-                                              // (90° right)
-            }
-            // Left turn (-π to 0): third priority
-            if (angle < 0.0f) {
-              return 3.0f +
-                     abs_angle /
-                         3.14159f; // Range: 3.0 (small left) to 4.0 (90° left)
-            }
-            // Turn around (≈ ±π): lowest priority
-            return 5.0f;
-          };
-
-          float priority_a = get_priority(a.angle);
-          float priority_b = get_priority(b.angle);
-          return priority_a < priority_b;
-        });
-
-    // Select best candidate
-    next_segment_index = candidates[0].segment_index;
-    next_reverse_direction = candidates[0].reverse;
   }
 
-  static void select_next_forced_direction(RoadFollowing &road_following,
-                                           RoadNetwork *road_network,
-                                           const vec2 &current_end,
-                                           float connection_tolerance,
-                                           size_t &next_segment_index,
-                                           bool &next_reverse_direction) {
-    size_t current_seg = road_following.current_segment_index;
-    if (current_seg >= road_network->segment_connections.size()) {
+  // Runs an exploration policy at this junction. When it has explored
+  // everything it can reach, the car heads for the nearest unvisited road,
+  // and with none left it falls back to the wall follower.
+  template <typename Policy>
+  static void select_next_with(RoadFollowingState &road_following,
+                               RoadNetwork *road_network,
+                               size_t &next_segment_index,
+                               bool &next_reverse_direction) {
+    ExplorationPool *pool =
+        afterhours::EntityHelper::get_singleton_cmp<ExplorationPool>();
+    if (!pool) {
+      select_next_wall_follower(road_following, road_network,
+                                next_segment_index, next_reverse_direction);
       return;
     }
-
-    size_t endpoint_idx = road_following.reverse_direction ? 0 : 1;
-    const auto &connections =
-        road_network->segment_connections[current_seg][endpoint_idx];
-
-    if (connections.empty()) {
+    ExplorationContext ctx{
+        road_following,
+        *road_network,
+        pool->state_for(road_following),
+        pool->scratch,
+        junction_turns(road_following, road_network),
+        RoadGraph::make_link(road_following.current_segment_index,
+                             !road_following.reverse_direction)};
+    if constexpr (std::is_same_v<Policy, RoutePolicy>) {
+      ctx.route = coverage_route(road_following, road_network);
+    }
+    uint32_t link = Policy::choose(ctx);
+    if (link != RoadGraph::INVALID) {
+      next_segment_index = RoadGraph::link_segment(link);
+      next_reverse_direction = RoadGraph::link_reverse(link);
       return;
     }
-
-    vec2 forced_dir = road_following.forced_direction;
-    float best_dot = -1.0f;
-    size_t best_seg = SIZE_MAX;
-    bool best_reverse = false;
-
-    std::set<size_t> recent_segments;
-    recent_segments.insert(last_segment_index);
-    recent_segments.insert(second_last_segment_index);
-    for (size_t hist_seg : road_following.segment_history) {
-      recent_segments.insert(hist_seg);
+    forget_route(road_following);
+    road_following.seeking_frontier = true;
+    if (head_for_frontier(road_following, road_network, next_segment_index,
+                          next_reverse_direction)) {
+      return;
     }
+    select_next_wall_follower(road_following, road_network,
+                              next_segment_index, next_reverse_direction);
+  }
 
-    // First pass: try to find a segment that's not in recent history
-    for (const auto &[connected_seg, use_reverse] : connections) {
-      if (connected_seg == current_seg) {
-        continue;
-      }
-      // In forced direction mode, prefer segments not in recent history
-      // but if that's the only option, we'll allow it in second pass
-      if (recent_segments.find(connected_seg) != recent_segments.end()) {
-        continue;
-      }
+  // The tour of the car's component, asking the planner for one the first
+  // time a car there needs it
+  static const CoverageRoute *
+  coverage_route(const RoadFollowingState &road_following,
+                 const RoadNetwork *road_network) {
+    CoverageRouting *routing =
+        afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>();
+    if (!routing) {
+      return nullptr;
+    }
+    size_t component =
+        road_network->get_component_id(road_following.current_segment_index);
+    const CoverageRoute *route = routing->route_for(component);
+    if (route == nullptr && component != SIZE_MAX) {
+      routing->request(*road_network, component);
+    }
+    return route;
+  }
 
-      const RoadSegment &candidate_seg = road_network->segments[connected_seg];
-      vec2 cand_start = use_reverse ? candidate_seg.end : candidate_seg.start;
-      vec2 cand_end = use_reverse ? candidate_seg.start : candidate_seg.end;
+  // Follows the frontier field one junction downhill. Only when nothing
+  // unvisited is reachable does the car jump, to another island's road.
+  // Returns false, and stops seeking, once everything has been visited.
+  static bool head_for_frontier(RoadFollowingState &road_following,
+                                RoadNetwork *road_network,
+                                size_t &next_segment_index,
+                                bool &next_reverse_direction) {
+    uint32_t link = road_network->step_toward_frontier(
+        road_following.current_segment_index,
+        road_following.reverse_direction);
+    if (link != RoadGraph::INVALID) {
+      next_segment_index = RoadGraph::link_segment(link);
+      next_reverse_direction = RoadGraph::link_reverse(link);
+      return true;
+    }
+    size_t random_unvisited = road_network->find_random_unvisited_segment();
+    if (random_unvisited == SIZE_MAX) {
+      road_following.seeking_frontier = false;
+      return false;
+    }
+    log_info("MazeTraversal: Nothing unvisited reachable, jumping to "
+             "segment {} on another island",
+             random_unvisited);
+    next_segment_index = random_unvisited;
+    next_reverse_direction = false;
+    forget_route(road_following);
+    return true;
+  }
 
-      // Calculate direction vector
-      vec2 cand_dir = {cand_end.x - cand_start.x, cand_end.y - cand_start.y};
-      float cand_len =
-          std::sqrt(cand_dir.x * cand_dir.x + cand_dir.y * cand_dir.y);
-      if (cand_len < 0.001f) {
-        continue;
-      }
-      cand_dir.x /= cand_len;
-      cand_dir.y /= cand_len;
-
-      // Distance check
-      float dist_to_start = std::sqrt(
-          (cand_start.x - current_end.x) * (cand_start.x - current_end.x) +
-          (cand_start.y - current_end.y) * (cand_start.y - current_end.y));
-      float dist_to_end = std::sqrt(
-          (cand_end.x - current_end.x) * (cand_end.x - current_end.x) +
-          (cand_end.y - current_end.y) * (cand_end.y - current_end.y));
-
-      if (dist_to_start >= connection_tolerance &&
-          dist_to_end >= connection_tolerance) {
-        continue;
-      }
-      // Calculate dot product with forced direction
-      float dot = forced_dir.x * cand_dir.x + forced_dir.y * cand_dir.y;
-      if (dot <= best_dot) {
-        continue;
-      }
-      best_dot = dot;
-      best_seg = connected_seg;
-      best_reverse = use_reverse;
-    }
-
-    // If no segment found (all excluded), do a second pass allowing excluded
-    // segments This prevents getting stuck when the only connection is in
-    // recent history
-    if (best_seg == SIZE_MAX) {
-      best_dot = -1.0f;
-      for (const auto &[connected_seg, use_reverse] : connections) {
-        if (connected_seg == current_seg) {
-          continue;
-        }
-        // Now allow even excluded segments if it's the only option
-        const RoadSegment &candidate_seg =
-            road_network->segments[connected_seg];
-        vec2 cand_start = use_reverse ? candidate_seg.end : candidate_seg.start;
-        vec2 cand_end = use_reverse ? candidate_seg.start : candidate_seg.end;
-
-        vec2 cand_dir = {cand_end.x - cand_start.x, cand_end.y - cand_start.y};
-        float cand_len =
-            std::sqrt(cand_dir.x * cand_dir.x + cand_dir.y * cand_dir.y);
-        if (cand_len < 0.001f) {
-          continue;
-        }
-        cand_dir.x /= cand_len;
-        cand_dir.y /= cand_len;
-
-        float dist_to_start = std::sqrt(
-            (cand_start.x - current_end.x) * (cand_start.x - current_end.x) +
-            (cand_start.y - current_end.y) * (cand_start.y - current_end.y));
-        float dist_to_end = std::sqrt(
-            (cand_end.x - current_end.x) * (cand_end.x - current_end.x) +
-            (cand_end.y - current_end.y) * (cand_end.y - current_end.y));
-
-        if (dist_to_start >= connection_tolerance &&
-            dist_to_end >= connection_tolerance) {
+  // Picks the turn heading closest to the forced direction, avoiding
+  // recent segments unless they are the only way on
+  static void select_next_forced_direction(RoadFollowingState &road_following,
+                                           RoadNetwork *road_network,
+                                           size_t &next_segment_index,
+                                           bool &next_reverse_direction) {
+    std::span<const RoadTurn> turns =
+        junction_turns(road_following, road_network);
+    vec2 forced_dir = road_following.forced_direction;
+    for (bool avoid_recent : {true, false}) {
+      const RoadTurn *best = nullptr;
+      float best_dot = -1.0f;
+      for (const RoadTurn &turn : turns) {
+        if (avoid_recent &&
+            is_recent(road_following, RoadGraph::link_segment(turn.link),
+                      true)) {
           continue;
         }
-        float dot = forced_dir.x * cand_dir.x + forced_dir.y * cand_dir.y;
+        float dot =
+            forced_dir.x * turn.heading.x + forced_dir.y * turn.heading.y;
         if (dot <= best_dot) {
           continue;
         }
         best_dot = dot;
-        best_seg = connected_seg;
-        best_reverse = use_reverse;
+        best = &turn;
+      }
+      if (best) {
+        next_segment_index = RoadGraph::link_segment(best->link);
+        next_reverse_direction = RoadGraph::link_reverse(best->link);
+        return;
       }
     }
-
-    if (best_seg == SIZE_MAX) {
-      return;
-    }
-    next_segment_index = best_seg;
-    next_reverse_direction = best_reverse;
   }
 };
-
-size_t MazeTraversal::last_segment_index = SIZE_MAX;
-size_t MazeTraversal::second_last_segment_index = SIZE_MAX;
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "../components.h"
+#include "../game_constants.h"
+#include "../log.h"
+#include "HandleComponentCompletion.h"
+#include "LoopDetection.h"
+#include "MapRevealSystem.h"
+#include "MazeTraversal.h"
+#include <afterhours/ah.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Advances the world over a long gap, such as the time the game was
+// closed, without stepping every frame. Cars still drive segment by segment
+// under their own traversal policy, but a whole step at a time, and fog is
+// revealed along each segment as it is first visited instead of around
+// every car every frame. Bricks are worn down in one pass at the end along
+// the roads first driven during the gap, rather than under each car every
+// tick. Nothing more can be earned once every road is visited, so the
+// rest of the gap is skipped.
+struct OfflineProgress {
+  // Cars take turns, and the frontier field catches up with their visits,
+  // once per step rather than once per tick. Much coarser and cars seeking
+  // unvisited road chase targets another car already took.
+  static constexpr float STEP_SECONDS = 0.25f;
+
+  struct Report {
+    float requested_seconds{0.0f};
+    // Less than requested when the map ran out of unvisited road first
+    float simulated_seconds{0.0f};
+    size_t steps{0};
+    size_t segments_visited{0};
+    size_t pois_discovered{0};
+    size_t bricks_destroyed{0};
+    int pixels_earned{0};
+  };
+
+  static Report catch_up(float seconds) {
+    Report report;
+    report.requested_seconds = seconds;
+
+    RoadNetwork *road_network =
+        afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
+    IsShopManager *shop =
+        afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
+    FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
+    if (!road_network || !shop || !fog || !road_network->is_loaded ||
+        road_network->segments.empty()) {
+      return report;
+    }
+    CoverageRouting *routing =
+        afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>();
+
+    afterhours::RefEntities cars = afterhours::EntityQuery()
+                                       .whereHasComponent<Transform>()
+                                       .whereHasComponent<RoadFollowing>()
+                                       .gen();
+    CarPool *pool = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    SimulationWorkers *workers =
+        afterhours::EntityHelper::get_singleton_cmp<SimulationWorkers>();
+    std::vector<PoiWatch> watches = watch_pois(*road_network, *fog);
+
+    // The same segment cap per simulated second as the per-tick system
+    int ticks_per_step = static_cast<int>(
+        std::lround(STEP_SECONDS / game_constants::FIXED_TICK_SECONDS));
+    int max_segments = MazeTraversal::MAX_SEGMENTS_PER_TICK * ticks_per_step;
+
+    LoopDetection loop_detection;
+    HandleComponentCompletion completion;
+    afterhours::Entity &network_entity =
+        afterhours::EntityHelper::get_singleton<RoadNetwork>();
+
+    size_t unvisited_before = road_network->get_unvisited_count();
+    std::vector<bool> visited_before = road_network->visited_segments;
+    int pixels_before = shop->pixels_collected;
+
+    while (report.simulated_seconds < seconds &&
+           road_network->get_unvisited_count() > 0) {
+      float dt = std::min(STEP_SECONDS, seconds - report.simulated_seconds);
+      MazeTraversal::refresh_frontier();
+      if (pool) {
+        MazeTraversal::drive_pool(*pool, dt, max_segments, workers);
+      }
+      for (afterhours::Entity &car : cars) {
+        Transform &transform = car.get<Transform>();
+        RoadFollowing &road_following = car.get<RoadFollowing>();
+        MazeTraversal::advance(transform, road_following, dt, max_segments);
+        if (car.hasTag(ColliderTag::Square)) {
+          loop_detection.for_each_with(car, transform, road_following, dt);
+        }
+      }
+      completion.for_each_with(network_entity, *road_network, dt);
+      report.pois_discovered += discover_pois(*road_network, *shop, watches);
+      // Tours asked for this step are ready by the next, as they would be
+      // a few frames later in the live game
+      if (routing && routing->planner) {
+        routing->planner->wait_idle();
+      }
+      report.simulated_seconds += dt;
+      ++report.steps;
+    }
+
+    // The live game also reveals around each car wherever it stops
+    for (afterhours::Entity &car : cars) {
+      MapRevealSystem::reveal_position(car.get<Transform>().position,
+                                       fog->reveal_radius);
+    }
+    if (pool) {
+      for (vec2 position : pool->position) {
+        MapRevealSystem::reveal_position(position, fog->reveal_radius);
+      }
+    }
+
+    if (pool) {
+      report.bricks_destroyed =
+          wear_bricks(*road_network, visited_before, *pool, *shop);
+    }
+
+    report.segments_visited =
+        unvisited_before - road_network->get_unvisited_count();
+    report.pixels_earned = shop->pixels_collected - pixels_before;
+    log_info("OfflineProgress: caught up {:.0f} s in {} steps ({:.0f} s "
+             "driven), {} segments, {} POIs, {} bricks, {} pixels",
+             report.requested_seconds, report.steps, report.simulated_seconds,
+             report.segments_visited, report.pois_discovered,
+             report.bricks_destroyed, report.pixels_earned);
+    return report;
+  }
+
+private:
+  // An undiscovered POI and the segments that pass within reveal radius
+  // of it; driving any of them would have found it
+  struct PoiWatch {
+    PointOfInterest *poi{nullptr};
+    std::vector<uint32_t> segments;
+  };
+
+  static float distance_sq_to_segment(vec2 point, const RoadSegment &segment) {
+    vec2 d = {segment.end.x - segment.start.x, segment.end.y - segment.start.y};
+    float len_sq = d.x * d.x + d.y * d.y;
+    float t = 0.0f;
+    if (len_sq > 0.0f) {
+      t = ((point.x - segment.start.x) * d.x +
+           (point.y - segment.start.y) * d.y) /
+          len_sq;
+      t = std::clamp(t, 0.0f, 1.0f);
+    }
+    float dx = segment.start.x + d.x * t - point.x;
+    float dy = segment.start.y + d.y * t - point.y;
+    return dx * dx + dy * dy;
+  }
+
+  static std::vector<PoiWatch> watch_pois(const RoadNetwork &road_network,
+                                          const FogOfWar &fog) {
+    float radius = fog.reveal_radius;
+    std::vector<PoiWatch> watches;
+    for (PointOfInterest &poi : afterhours::EntityQuery()
+                                    .whereHasComponent<PointOfInterest>()
+                                    .gen_as<PointOfInterest>()) {
+      if (poi.is_discovered) {
+        continue;
+      }
+      PoiWatch watch{&poi, {}};
+      const RoadChunkGrid &chunks = road_network.chunks;
+      chunks.for_each_overlapping(
+          {poi.position.x - radius, poi.position.y - radius},
+          {poi.position.x + radius, poi.position.y + radius},
+          [&](uint32_t chunk) {
+            for (uint32_t seg = chunks.first_segment(chunk);
+                 seg < chunks.last_segment(chunk); ++seg) {
+              if (distance_sq_to_segment(poi.position,
+                                         road_network.segments[seg]) <=
+                  radius * radius) {
+                watch.segments.push_back(seg);
+              }
+            }
+          });
+      if (!watch.segments.empty()) {
+        watches.push_back(std::move(watch));
+      }
+    }
+    return watches;
+  }
+
+  // Live, HandleCollisions has each pooled car chip at a brick its circle
+  // touches every tick. Here every road first driven during the gap wears
+  // each brick within a car's radius plus half a cell of it, by what a car
+  // does crossing a whole cell at the fleet's mean speed and damage. Every
+  // brick that breaks earns its pixel and shows its photo cell, as live.
+  static size_t wear_bricks(const RoadNetwork &road_network,
+                            const std::vector<bool> &visited_before,
+                            const CarPool &pool, IsShopManager &shop) {
+    BrickGrid *bricks =
+        afterhours::EntityHelper::get_singleton_cmp<BrickGrid>();
+    IsPhotoReveal *photo_reveal =
+        afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
+    if (!bricks || !photo_reveal || pool.size() == 0) {
+      return 0;
+    }
+    double speed = 0.0;
+    double damage = 0.0;
+    float radius = 0.0f;
+    for (size_t car = 0; car < pool.size(); ++car) {
+      speed += pool.speed[car];
+      damage += pool.damage[car];
+      radius += pool.radius[car];
+    }
+    float reach = radius / static_cast<float>(pool.size()) +
+                  game_constants::BRICK_CELL_SIZE * 0.5f;
+    if (speed <= 0.0) {
+      return 0;
+    }
+    double ticks_per_cell = game_constants::BRICK_CELL_SIZE * pool.size() /
+                            (speed * game_constants::FIXED_TICK_SECONDS);
+    short wear = static_cast<short>(std::clamp(
+        std::lround(damage / pool.size() * ticks_per_cell), 0l, 15l));
+    if (wear == 0) {
+      return 0;
+    }
+
+    size_t destroyed = 0;
+    for (size_t seg = 0; seg < road_network.segments.size(); ++seg) {
+      if (visited_before[seg] || !road_network.is_visited(seg)) {
+        continue;
+      }
+      MapRevealSystem::for_each_capsule_span(
+          road_network.segments[seg], reach, [&](int grid_y, int x0, int x1) {
+            for (int grid_x = x0; grid_x <= x1; ++grid_x) {
+              if (!bricks->has_brick(grid_x, grid_y)) {
+                continue;
+              }
+              bricks->add_health(grid_x, grid_y, static_cast<short>(-wear));
+              if (!bricks->has_brick(grid_x, grid_y)) {
+                shop.pixels_collected += 1;
+                photo_reveal->set_revealed(grid_x, grid_y);
+                ++destroyed;
+              }
+            }
+          });
+    }
+    return destroyed;
+  }
+
+  // Credits every watched POI whose roads have now been driven
+  static size_t discover_pois(const RoadNetwork &road_network,
+                              IsShopManager &shop,
+                              std::vector<PoiWatch> &watches) {
+    size_t discovered = 0;
+    for (PoiWatch &watch : watches) {
+      if (watch.poi->is_discovered) {
+        continue;
+      }
+      bool driven = std::any_of(
+          watch.segments.begin(), watch.segments.end(),
+          [&](uint32_t seg) { return road_network.is_visited(seg); });
+      if (!driven) {
+        continue;
+      }
+      watch.poi->is_discovered = true;
+      shop.pixels_collected += watch.poi->reward_amount;
+      ++discovered;
+    }
+    return discovered;
+  }
+};
@@ -5,13 +5,16 @@
 #include "../render_backend.h"
 #include <afterhours/ah.h>
 
-struct RenderCar
-    : afterhours::System<Transform, RoadFollowing,
-                         afterhours::tags::All<ColliderTag::Circle>> {
-  virtual void for_each_with(const afterhours::Entity &,
-                             const Transform &transform,
-                             const RoadFollowing &road_following,
+struct RenderCar : afterhours::System<CarPool> {
+  virtual void for_each_with(const afterhours::Entity &, const CarPool &cars,
                              float) const override {
+    for (size_t car = 0; car < cars.size(); ++car) {
+      render_backend::DrawCircleV(cars.position[car], cars.radius[car],
+                                  car_color(cars.cold[car]));
+    }
+  }
+
+  static raylib::Color car_color(const RoadFollowingState &road_following) {
     raylib::Color car_color = raylib::GREEN;
     if (road_following.forced_direction_steps > 0) {
       car_color = raylib::ORANGE;
@@ -22,11 +25,11 @@ struct RenderCar
       car_color = raylib::BLUE;
     } else if (road_following.current_algorithm == MazeAlgorithm::DFS) {
       car_color = raylib::PURPLE;
-    } else {
+    } else if (road_following.current_algorithm == MazeAlgorithm::AStar) {
       car_color = raylib::YELLOW;
+    } else {
+      car_color = raylib::SKYBLUE;
     }
-
-    render_backend::DrawCircleV(transform.position, transform.size.x / 2.0f,
-                                car_color);
+    return car_color;
   }
 };
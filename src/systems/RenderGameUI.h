@@ -133,6 +133,8 @@ private:
       return "DFS";
     case MazeAlgorithm::AStar:
       return "A*";
+    case MazeAlgorithm::Route:
+      return "Route Planner";
     default:
       return "Unknown";
     }
@@ -4,6 +4,7 @@
 #include "../eq.h"
 #include "../render_backend.h"
 #include "MapRevealSystem.h"
+#include "StreamRoadChunks.h"
 #include <afterhours/ah.h>
 
 struct RenderRoads : afterhours::System<RoadNetwork> {
@@ -17,7 +18,28 @@ struct RenderRoads : afterhours::System<RoadNetwork> {
     FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
     invariant(fog, "FogOfWar singleton not found");
 
-    for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    const afterhours::camera::HasCamera *camera =
+        afterhours::EntityHelper::get_singleton_cmp<
+            afterhours::camera::HasCamera>();
+    if (!camera || road_network.chunks.empty()) {
+      draw_segments(road_network, *fog, 0, road_network.segments.size());
+      return;
+    }
+
+    vec2 view_min;
+    vec2 view_max;
+    StreamRoadChunks::camera_view(*camera, view_min, view_max);
+    const RoadChunkGrid &chunks = road_network.chunks;
+    chunks.for_each_overlapping(view_min, view_max, [&](uint32_t chunk) {
+      draw_segments(road_network, *fog, chunks.first_segment(chunk),
+                    chunks.last_segment(chunk));
+    });
+  }
+
+private:
+  void draw_segments(const RoadNetwork &road_network, const FogOfWar &fog,
+                     size_t first, size_t last) const {
+    for (size_t i = first; i < last; ++i) {
       const RoadSegment &segment = road_network.segments[i];
 
       int grid_x1 = game_constants::world_to_grid_x(segment.start.x);
@@ -25,8 +47,8 @@ struct RenderRoads : afterhours::System<RoadNetwork> {
       int grid_x2 = game_constants::world_to_grid_x(segment.end.x);
       int grid_y2 = game_constants::world_to_grid_y(segment.end.y);
 
-      bool start_revealed = fog->is_revealed(grid_x1, grid_y1);
-      bool end_revealed = fog->is_revealed(grid_x2, grid_y2);
+      bool start_revealed = fog.is_revealed(grid_x1, grid_y1);
+      bool end_revealed = fog.is_revealed(grid_x2, grid_y2);
 
       if (!start_revealed && !end_revealed) {
         continue;
@@ -41,7 +63,6 @@ struct RenderRoads : afterhours::System<RoadNetwork> {
     }
   }
 
-private:
   raylib::Color get_road_color(RoadType road_type, bool is_mapped) const {
     if (!is_mapped) {
       return raylib::DARKGRAY;
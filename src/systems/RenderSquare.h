@@ -25,8 +25,10 @@ struct RenderSquare
       square_color = raylib::BLUE;
     } else if (road_following.current_algorithm == MazeAlgorithm::DFS) {
       square_color = raylib::PURPLE;
+    } else if (road_following.current_algorithm == MazeAlgorithm::AStar) {
+      square_color = raylib::YELLOW;
     } else {
-      square_color = raylib::YELLOW; // AStar
+      square_color = raylib::SKYBLUE; // Route
     }
 
     render_backend::DrawRectangleV(center_pos, transform.size, square_color);
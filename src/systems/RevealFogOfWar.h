@@ -7,11 +7,76 @@
 #include "MapRevealSystem.h"
 #include <afterhours/ah.h>
 #include <cmath>
+#include <vector>
 
 struct RevealFogOfWar
     : afterhours::System<
           Transform,
           afterhours::tags::Any<ColliderTag::Square, ColliderTag::Circle>> {
+  // Pooled cars reveal around themselves every tick, as entity cars do.
+  // A row of the disc already clear costs a word test rather than a write.
+  //
+  // With workers, each lane lists the runs of cells around its own slice
+  // of cars that still hide something, against the fog as it was before
+  // the pass, and the runs are revealed together afterwards. Revealing only
+  // ever sets cells, so the fog ends up exactly as if the cars had revealed
+  // one after another.
+  virtual void once(float) override {
+    CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    if (!cars || cars->empty()) {
+      return;
+    }
+    FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
+    invariant(fog, "FogOfWar singleton not found");
+    IsPhotoReveal *photo_reveal =
+        afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
+    invariant(photo_reveal, "IsPhotoReveal singleton not found");
+    SimulationWorkers *workers =
+        afterhours::EntityHelper::get_singleton_cmp<SimulationWorkers>();
+
+    if (!workers || !workers->runs_parallel(cars->size())) {
+      for (size_t car = 0; car < cars->size(); ++car) {
+        MapRevealSystem::for_each_disc_span(
+            cars->position[car], fog->reveal_radius,
+            [&](int grid_y, int x0, int x1) {
+              if (!fog->revealed_cells.all_in_span(grid_y, x0, x1)) {
+                MapRevealSystem::reveal_span(*fog, *photo_reveal, grid_y, x0,
+                                             x1);
+              }
+            });
+      }
+      return;
+    }
+
+    const FogOfWar &before = *fog;
+    // Each run as the cell index of its first and last cell
+    workers->for_each_slice(
+        cars->size(),
+        [&](size_t begin, size_t end, std::vector<uint32_t> &runs) {
+          for (size_t car = begin; car < end; ++car) {
+            MapRevealSystem::for_each_disc_span(
+                cars->position[car], before.reveal_radius,
+                [&](int grid_y, int x0, int x1) {
+                  if (before.revealed_cells.all_in_span(grid_y, x0, x1)) {
+                    return;
+                  }
+                  uint32_t row = static_cast<uint32_t>(
+                      grid_y * game_constants::GRID_WIDTH);
+                  runs.push_back(row + static_cast<uint32_t>(x0));
+                  runs.push_back(row + static_cast<uint32_t>(x1));
+                });
+          }
+        });
+    for (const std::vector<uint32_t> &runs : workers->deferred) {
+      for (size_t i = 0; i + 1 < runs.size(); i += 2) {
+        int grid_y = static_cast<int>(runs[i]) / game_constants::GRID_WIDTH;
+        int x0 = static_cast<int>(runs[i]) % game_constants::GRID_WIDTH;
+        int x1 = static_cast<int>(runs[i + 1]) % game_constants::GRID_WIDTH;
+        MapRevealSystem::reveal_span(*fog, *photo_reveal, grid_y, x0, x1);
+      }
+    }
+  }
+
   virtual void for_each_with(afterhours::Entity &, Transform &transform,
                              float) override {
     FogOfWar *fog = afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
@@ -9,11 +9,15 @@
 #include "../settings.h"
 #include "MapRevealSystem.h"
 #include <afterhours/ah.h>
-#include <random>
 
 struct SpawnNewCars : afterhours::System<IsShopManager> {
   int last_car_count{0};
 
+  static int pooled_car_count() {
+    CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    return cars ? static_cast<int>(cars->size()) : 0;
+  }
+
   virtual bool should_run(float) override {
     IsShopManager *shop =
         afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
@@ -23,16 +27,8 @@ struct SpawnNewCars : afterhours::System<IsShopManager> {
       return false;
     }
 
-    bool has_cars = false;
-    int car_count_found = 0;
-    for ([[maybe_unused]] const Transform &transform :
-         afterhours::EntityQuery()
-             .whereHasTag(ColliderTag::Circle)
-             .whereHasComponent<Transform>()
-             .gen_as<Transform>()) {
-      has_cars = true;
-      car_count_found++;
-    }
+    int car_count_found = pooled_car_count();
+    bool has_cars = car_count_found > 0;
 
     log_info("SpawnNewCars::should_run: car_count={}, last_car_count={}, "
              "has_cars={}, cars_found={}",
@@ -52,14 +48,7 @@ struct SpawnNewCars : afterhours::System<IsShopManager> {
         afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
     invariant(shop, "IsShopManager singleton not found");
 
-    int cars_found = 0;
-    for ([[maybe_unused]] const Transform &transform :
-         afterhours::EntityQuery()
-             .whereHasTag(ColliderTag::Circle)
-             .whereHasComponent<Transform>()
-             .gen_as<Transform>()) {
-      cars_found++;
-    }
+    int cars_found = pooled_car_count();
 
     if (cars_found == 0 && shop->car_count == 1) {
       last_car_count = 1;
@@ -87,26 +76,17 @@ struct SpawnNewCars : afterhours::System<IsShopManager> {
 
     last_car_count = shop.car_count;
 
-    Transform *existing_car_transform_ptr = nullptr;
-    int cars_found = 0;
-    for (Transform &transform : afterhours::EntityQuery()
-                                    .whereHasTag(ColliderTag::Circle)
-                                    .whereHasComponent<Transform>()
-                                    .gen_as<Transform>()) {
-      if (!existing_car_transform_ptr) {
-        existing_car_transform_ptr = &transform;
-      }
-      cars_found++;
-    }
+    CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    invariant(cars, "CarPool singleton not found");
+    int cars_found = static_cast<int>(cars->size());
 
     log_info("SpawnNewCars: found {} existing cars", cars_found);
 
     float radius = 6.0f;
     int damage = shop.get_car_damage_value();
     vec2 spawn_position;
-    vec2 base_velocity;
 
-    if (!existing_car_transform_ptr) {
+    if (cars->empty()) {
       RoadNetwork *road_network =
           afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
       invariant(road_network, "RoadNetwork singleton not found");
@@ -114,7 +94,6 @@ struct SpawnNewCars : afterhours::System<IsShopManager> {
       if (!road_network->is_loaded || road_network->segments.empty()) {
         spawn_position = {game_constants::WORLD_WIDTH * 0.5f,
                           game_constants::WORLD_HEIGHT * 0.5f};
-        base_velocity = {200.0f, 200.0f};
         log_info(
             "SpawnNewCars: no road network or fog, using default position");
       } else {
@@ -126,87 +105,42 @@ struct SpawnNewCars : afterhours::System<IsShopManager> {
         }
 
         if (!explored_segments.empty()) {
-          static std::mt19937 rng(std::random_device{}());
-          std::uniform_int_distribution<size_t> seg_dist(
-              0, explored_segments.size() - 1);
-          size_t chosen_seg = explored_segments[seg_dist(rng)];
+          SimRandom::Engine &rng = SimRandom::engine();
+          size_t chosen_seg = explored_segments[SimRandom::below(
+              rng, static_cast<uint32_t>(explored_segments.size()))];
           spawn_position = road_network->segments[chosen_seg].start;
-          vec2 seg_dir = {road_network->segments[chosen_seg].end.x -
-                              road_network->segments[chosen_seg].start.x,
-                          road_network->segments[chosen_seg].end.y -
-                              road_network->segments[chosen_seg].start.y};
-          float seg_len =
-              std::sqrt(seg_dir.x * seg_dir.x + seg_dir.y * seg_dir.y);
-          if (seg_len > 0.1f) {
-            seg_dir.x /= seg_len;
-            seg_dir.y /= seg_len;
-            base_velocity = {seg_dir.x * 200.0f, seg_dir.y * 200.0f};
-          } else {
-            base_velocity = {200.0f, 200.0f};
-          }
           log_info("SpawnNewCars: spawning at explored segment {} position "
                    "({:.1f}, {:.1f})",
                    chosen_seg, spawn_position.x, spawn_position.y);
         } else {
           spawn_position = {game_constants::WORLD_WIDTH * 0.5f,
                             game_constants::WORLD_HEIGHT * 0.5f};
-          base_velocity = {200.0f, 200.0f};
           log_info("SpawnNewCars: no explored segments found, using default "
                    "position");
         }
       }
     } else {
-      Transform &existing_car_transform = *existing_car_transform_ptr;
-      spawn_position = existing_car_transform.position;
-      base_velocity = existing_car_transform.velocity;
+      spawn_position = cars->position[0];
     }
 
-    log_info(
-        "SpawnNewCars: existing car at ({:.1f}, {:.1f}), velocity ({:.1f}, "
-        "{:.1f})",
-        spawn_position.x, spawn_position.y, base_velocity.x, base_velocity.y);
-
-    static std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution<float> angle_dist(-1.0f, 1.0f);
-    std::uniform_real_distribution<float> speed_variation(0.7f, 1.3f);
-
-    float base_speed = std::sqrt(base_velocity.x * base_velocity.x +
-                                 base_velocity.y * base_velocity.y);
-    if (base_speed < 0.1f) {
-      log_info("SpawnNewCars: base speed too low ({:.1f}), using default",
-               base_speed);
-      base_velocity = {200.0f, 200.0f};
-      base_speed = std::sqrt(base_velocity.x * base_velocity.x +
-                             base_velocity.y * base_velocity.y);
-    }
+    log_info("SpawnNewCars: spawning around ({:.1f}, {:.1f})",
+             spawn_position.x, spawn_position.y);
 
-    float base_angle = std::atan2(base_velocity.y, base_velocity.x);
+    SimRandom::Engine &rng = SimRandom::engine();
 
-    std::uniform_real_distribution<float> position_offset_dist(-radius * 0.5f,
-                                                               radius * 0.5f);
-
-    log_info("SpawnNewCars: spawning {} cars with base_speed={:.1f}, "
-             "base_angle={:.2f}",
-             cars_to_spawn, base_speed, base_angle);
+    log_info("SpawnNewCars: spawning {} cars", cars_to_spawn);
 
     for (int i = 0; i < cars_to_spawn; ++i) {
-      float angle_offset = angle_dist(rng);
-      float speed_mult = speed_variation(rng);
-      float new_angle = base_angle + angle_offset;
-      float new_speed = base_speed * speed_mult;
-      vec2 varied_velocity = {std::cos(new_angle) * new_speed,
-                              std::sin(new_angle) * new_speed};
-
       vec2 offset_position = spawn_position;
-      offset_position.x += position_offset_dist(rng);
-      offset_position.y += position_offset_dist(rng);
+      offset_position.x +=
+          SimRandom::between(rng, -radius * 0.5f, radius * 0.5f);
+      offset_position.y +=
+          SimRandom::between(rng, -radius * 0.5f, radius * 0.5f);
 
-      log_info("SpawnNewCars: spawning car {} at ({:.1f}, {:.1f}) with "
-               "velocity ({:.1f}, {:.1f}), speed={:.1f}, angle={:.2f}",
-               i + 1, offset_position.x, offset_position.y, varied_velocity.x,
-               varied_velocity.y, new_speed, new_angle);
+      log_info("SpawnNewCars: spawning car {} at ({:.1f}, {:.1f})", i + 1,
+               offset_position.x, offset_position.y);
 
-      make_car(offset_position, varied_velocity, radius, damage);
+      make_car(offset_position, radius, damage);
     }
 
     log_info("SpawnNewCars: finished spawning {} cars", cars_to_spawn);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../components.h"
+#include <afterhours/ah.h>
+#include <afterhours/src/plugins/camera.h>
+
+// Keeps the road chunks around the camera and every road-following car
+// resident; the paging itself happens on the streamer's thread
+struct StreamRoadChunks : afterhours::System<RoadChunkStreaming> {
+  // World rect the camera shows, assuming the offset centres the viewport
+  static void camera_view(const afterhours::camera::HasCamera &camera,
+                          vec2 &view_min, vec2 &view_max) {
+    float zoom = std::max(camera.camera.zoom, 0.001f);
+    vec2 half{camera.camera.offset.x / zoom, camera.camera.offset.y / zoom};
+    view_min = {camera.camera.target.x - half.x,
+                camera.camera.target.y - half.y};
+    view_max = {camera.camera.target.x + half.x,
+                camera.camera.target.y + half.y};
+  }
+
+  virtual void for_each_with(afterhours::Entity &,
+                             RoadChunkStreaming &streaming, float) override {
+    const RoadNetwork *road_network =
+        afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
+    if (!road_network || !road_network->is_loaded) {
+      return;
+    }
+    if (!streaming.streamer) {
+      streaming.streamer = std::make_shared<RoadChunkStreamer>();
+    }
+    if (streaming.attached_segments != road_network->segments.data()) {
+      streaming.streamer->attach(*road_network);
+      streaming.attached_segments = road_network->segments.data();
+      streaming.wanted.clear();
+    }
+    if (!streaming.streamer->is_streaming()) {
+      return;
+    }
+
+    // One chunk of slack so chunks are in before they scroll into view
+    const RoadChunkGrid &chunks = road_network->chunks;
+    float margin = chunks.layout.chunk_size;
+    auto want_around = [&](vec2 min, vec2 max) {
+      chunks.for_each_overlapping(
+          {min.x - margin, min.y - margin}, {max.x + margin, max.y + margin},
+          [&](uint32_t chunk) { next_wanted.push_back(chunk); });
+    };
+
+    next_wanted.clear();
+    const afterhours::camera::HasCamera *camera =
+        afterhours::EntityHelper::get_singleton_cmp<
+            afterhours::camera::HasCamera>();
+    if (camera) {
+      vec2 view_min;
+      vec2 view_max;
+      camera_view(*camera, view_min, view_max);
+      want_around(view_min, view_max);
+    }
+    for (const Transform &transform : afterhours::EntityQuery()
+                                          .whereHasComponent<RoadFollowing>()
+                                          .whereHasComponent<Transform>()
+                                          .gen_as<Transform>()) {
+      want_around(transform.position, transform.position);
+    }
+    // Pooled cars are gathered by the chunk they are in first, so a crowd
+    // costs one lookup per car and one search per occupied chunk
+    const CarPool *cars =
+        afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    if (cars && !cars->empty() && !chunks.empty()) {
+      occupied.assign(chunks.chunk_count(), 0);
+      for (vec2 position : cars->position) {
+        occupied[chunks.chunk_at(position)] = 1;
+      }
+      for (uint32_t chunk = 0; chunk < occupied.size(); ++chunk) {
+        if (!occupied[chunk]) {
+          continue;
+        }
+        const RoadChunkLayout &layout = chunks.layout;
+        vec2 min = {layout.origin.x +
+                        (chunk % layout.columns) * layout.chunk_size,
+                    layout.origin.y +
+                        (chunk / layout.columns) * layout.chunk_size};
+        want_around(min,
+                    {min.x + layout.chunk_size, min.y + layout.chunk_size});
+      }
+    }
+    std::sort(next_wanted.begin(), next_wanted.end());
+    next_wanted.erase(std::unique(next_wanted.begin(), next_wanted.end()),
+                      next_wanted.end());
+
+    if (next_wanted != streaming.wanted) {
+      streaming.wanted = next_wanted;
+      streaming.streamer->request(next_wanted);
+    }
+  }
+
+private:
+  std::vector<uint32_t> next_wanted;
+  std::vector<uint8_t> occupied;
+};
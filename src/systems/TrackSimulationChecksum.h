@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../components.h"
+#include "../log.h"
+#include <afterhours/ah.h>
+#include <bit>
+#include <cstdint>
+
+// Folds everything the simulation owns into one FNV-1a hash each fixed
+// tick: visited roads, revealed fog, the shop's pixels, discovered POIs and
+// where every car is. Floats are hashed by their bits, so two runs only
+// match when they really are identical.
+struct TrackSimulationChecksum : afterhours::System<SimulationChecksum> {
+  virtual void for_each_with(afterhours::Entity &,
+                             SimulationChecksum &checksum, float) override {
+    Hash hash;
+
+    const RoadNetwork *road_network =
+        afterhours::EntityHelper::get_singleton_cmp<RoadNetwork>();
+    if (road_network) {
+      hash.add_bits(road_network->visited_segments);
+    }
+    const FogOfWar *fog =
+        afterhours::EntityHelper::get_singleton_cmp<FogOfWar>();
+    if (fog) {
+      hash.add_bits(fog->revealed_cells);
+    }
+    const IsShopManager *shop =
+        afterhours::EntityHelper::get_singleton_cmp<IsShopManager>();
+    if (shop) {
+      hash.add(static_cast<uint64_t>(shop->pixels_collected));
+      hash.add(static_cast<uint64_t>(shop->car_count));
+    }
+
+    for (const PointOfInterest &poi : afterhours::EntityQuery()
+                                          .whereHasComponent<PointOfInterest>()
+                                          .gen_as<PointOfInterest>()) {
+      hash.add(poi.is_discovered ? 1u : 0u);
+    }
+    for (afterhours::Entity &car : afterhours::EntityQuery()
+                                       .whereHasComponent<Transform>()
+                                       .whereHasComponent<RoadFollowing>()
+                                       .gen()) {
+      const Transform &transform = car.get<Transform>();
+      const RoadFollowing &road_following = car.get<RoadFollowing>();
+      hash.add(std::bit_cast<uint32_t>(transform.position.x));
+      hash.add(std::bit_cast<uint32_t>(transform.position.y));
+      hash.add(road_following.current_segment_index);
+      hash.add(road_following.reverse_direction ? 1u : 0u);
+      hash.add(std::bit_cast<uint32_t>(road_following.progress_along_segment));
+    }
+    const CarPool *cars =
+        afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    if (cars) {
+      hash.add(cars->size());
+      for (size_t car = 0; car < cars->size(); ++car) {
+        hash.add(std::bit_cast<uint32_t>(cars->position[car].x));
+        hash.add(std::bit_cast<uint32_t>(cars->position[car].y));
+        hash.add(cars->segment[car]);
+        hash.add(cars->reverse[car]);
+        hash.add(std::bit_cast<uint32_t>(cars->progress[car]));
+      }
+    }
+
+    checksum.tick++;
+    checksum.value = hash.value;
+    if (checksum.log_each_tick) {
+      log_info("tick {} checksum {:016x}", checksum.tick, checksum.value);
+    }
+  }
+
+private:
+  struct Hash {
+    uint64_t value{14695981039346656037ull};
+
+    void add(uint64_t word) {
+      for (int i = 0; i < 8; ++i) {
+        value ^= (word >> (i * 8)) & 0xFF;
+        value *= 1099511628211ull;
+      }
+    }
+
+    // Packs any indexable run of bools 64 to a word before hashing
+    template <typename Bits> void add_bits(const Bits &bits) {
+      size_t count = bits.size();
+      add(count);
+      uint64_t word = 0;
+      for (size_t i = 0; i < count; ++i) {
+        word |= static_cast<uint64_t>(bits[i] ? 1 : 0) << (i & 63);
+        if ((i & 63) == 63) {
+          add(word);
+          word = 0;
+        }
+      }
+      add(word);
+    }
+  };
+};
@@ -3,6 +3,7 @@
 #include "../components.h"
 #include "../eq.h"
 #include <afterhours/ah.h>
+#include <algorithm>
 
 struct UpdateCarUpgrades : afterhours::System<IsShopManager> {
   int last_speed_level{-1};
@@ -29,6 +30,11 @@ struct UpdateCarUpgrades : afterhours::System<IsShopManager> {
     last_speed_level = shop.car_speed_level;
     last_damage_level = shop.car_damage_level;
 
+    CarPool *cars = afterhours::EntityHelper::get_singleton_cmp<CarPool>();
+    if (!cars) {
+      return;
+    }
+
     if (speed_changed) {
       float speed_multiplier = shop.get_car_speed_multiplier();
 
@@ -36,24 +42,14 @@ struct UpdateCarUpgrades : afterhours::System<IsShopManager> {
           old_speed_level > 0 ? 1.0f + ((old_speed_level - 1) * 0.2f) : 1.0f;
       float speed_scale = speed_multiplier / old_multiplier;
 
-      for (Transform &transform : afterhours::EntityQuery()
-                                      .whereHasTag(ColliderTag::Circle)
-                                      .whereHasComponent<Transform>()
-                                      .gen_as<Transform>()) {
-        transform.velocity.x *= speed_scale;
-        transform.velocity.y *= speed_scale;
+      for (float &speed : cars->speed) {
+        speed *= speed_scale;
       }
     }
 
     if (damage_changed) {
       int damage_value = shop.get_car_damage_value();
-
-      for (CanDamage &can_damage : afterhours::EntityQuery()
-                                       .whereHasTag(ColliderTag::Circle)
-                                       .whereHasComponent<CanDamage>()
-                                       .gen_as<CanDamage>()) {
-        can_damage.amount = damage_value;
-      }
+      std::fill(cars->damage.begin(), cars->damage.end(), damage_value);
     }
   }
 };
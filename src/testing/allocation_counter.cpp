@@ -0,0 +1,147 @@
+#include "allocation_counter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace allocation_counter {
+std::atomic<bool> counting{false};
+std::atomic<size_t> allocations{0};
+} // namespace allocation_counter
+
+// Replacing the global operator new reaches every allocation in the
+// binary, so it only happens in builds made with ALLOCATION_COUNTING=1
+#ifdef COUNT_ALLOCATIONS
+
+// Every replaceable form of operator new, plain, array, aligned and
+// nothrow, goes through allocate_or_throw so none of them escapes the count
+namespace {
+
+void *allocate(std::size_t size) {
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *allocate_aligned(std::size_t size, std::align_val_t align) {
+  std::size_t alignment = static_cast<std::size_t>(align);
+  // aligned_alloc wants the size to be a multiple of the alignment
+  std::size_t rounded = (std::max<std::size_t>(size, 1) + alignment - 1) /
+                        alignment * alignment;
+#ifdef _WIN32
+  return _aligned_malloc(rounded, alignment);
+#else
+  return std::aligned_alloc(alignment, rounded);
+#endif
+}
+
+void release_aligned(void *ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+// Like the standard operator new, retries through the installed new
+// handler and only throws once there is none
+template <typename Allocate> void *allocate_or_throw(Allocate allocate_once) {
+  if (allocation_counter::counting.load(std::memory_order_relaxed)) {
+    allocation_counter::allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  while (true) {
+    if (void *ptr = allocate_once()) {
+      return ptr;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void *allocate_or_throw(std::size_t size) {
+  return allocate_or_throw([size] { return allocate(size); });
+}
+
+void *allocate_aligned_or_throw(std::size_t size, std::align_val_t align) {
+  return allocate_or_throw(
+      [size, align] { return allocate_aligned(size, align); });
+}
+
+void *allocate_or_null(std::size_t size) noexcept {
+  try {
+    return allocate_or_throw(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void *allocate_aligned_or_null(std::size_t size,
+                               std::align_val_t align) noexcept {
+  try {
+    return allocate_aligned_or_throw(size, align);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return allocate_or_throw(size); }
+void *operator new[](std::size_t size) { return allocate_or_throw(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate_or_null(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate_or_null(size);
+}
+void *operator new(std::size_t size, std::align_val_t align) {
+  return allocate_aligned_or_throw(size, align);
+}
+void *operator new[](std::size_t size, std::align_val_t align) {
+  return allocate_aligned_or_throw(size, align);
+}
+void *operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t &) noexcept {
+  return allocate_aligned_or_null(size, align);
+}
+void *operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t &) noexcept {
+  return allocate_aligned_or_null(size, align);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  release_aligned(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  release_aligned(ptr);
+}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  release_aligned(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+  release_aligned(ptr);
+}
+void operator delete(void *ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  release_aligned(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  release_aligned(ptr);
+}
+
+#endif
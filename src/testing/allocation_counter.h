@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Counts global allocations while an AllocationCounter is alive. The
+// replacement operator new and delete live in allocation_counter.cpp, so
+// they are defined exactly once however many files include this. They are
+// only compiled in with COUNT_ALLOCATIONS (make ALLOCATION_COUNTING=1);
+// otherwise every count reads zero and ENABLED says not to trust it.
+namespace allocation_counter {
+#ifdef COUNT_ALLOCATIONS
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+extern std::atomic<bool> counting;
+extern std::atomic<size_t> allocations;
+} // namespace allocation_counter
+
+struct AllocationCounter {
+  AllocationCounter() {
+    allocation_counter::allocations = 0;
+    allocation_counter::counting = true;
+  }
+  ~AllocationCounter() { allocation_counter::counting = false; }
+
+  AllocationCounter(const AllocationCounter &) = delete;
+  AllocationCounter &operator=(const AllocationCounter &) = delete;
+
+  size_t count() const { return allocation_counter::allocations; }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+
+struct BenchmarkRegistry {
+  static BenchmarkRegistry &get() {
+    static BenchmarkRegistry instance;
+    return instance;
+  }
+
+  void register_benchmark(const std::string &name,
+                          std::function<int()> bench_func) {
+    benchmarks[name] = bench_func;
+  }
+
+  std::map<std::string, std::function<int()>> benchmarks;
+};
+
+inline double bench_elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+#define BENCHMARK(name)                                                        \
+  static int bench_##name();                                                   \
+  static struct BenchmarkRegistrar_##name {                                    \
+    BenchmarkRegistrar_##name() {                                              \
+      BenchmarkRegistry::get().register_benchmark(#name, bench_##name);        \
+    }                                                                          \
+  } bench_registrar_##name;                                                    \
+  int bench_##name()
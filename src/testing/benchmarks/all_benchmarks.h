@@ -0,0 +1,17 @@
+#pragma once
+
+#include "car_pool_benchmarks.h"
+#include "fog_reveal_benchmarks.h"
+#include "maze_traversal_benchmarks.h"
+#include "offline_progress_benchmarks.h"
+#include "parallel_car_pool_benchmarks.h"
+#include "road_network_benchmarks.h"
+#include "road_cache_benchmarks.h"
+#include "road_chain_benchmarks.h"
+#include "road_chunk_benchmarks.h"
+#include "road_frontier_benchmarks.h"
+#include "road_json_benchmarks.h"
+#include "road_turn_benchmarks.h"
+#include "road_unvisited_benchmarks.h"
+#include "simulation_checksum_benchmarks.h"
+#include "osm_import_benchmarks.h"
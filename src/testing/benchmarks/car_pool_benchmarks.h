@@ -0,0 +1,199 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../sim_random.h"
+#include "../../systems/DiscoverySystem.h"
+#include "../../systems/MazeTraversal.h"
+#include "../../systems/RevealFogOfWar.h"
+#include "../bench_macros.h"
+#include "maze_traversal_benchmarks.h"
+#include <algorithm>
+#include <bit>
+#include <fmt/format.h>
+#include <iostream>
+
+namespace car_pool_bench {
+
+using maze_traversal_bench::World;
+
+constexpr float CAR_SPEED = 250.0f;
+
+struct Snapshot {
+  uint32_t segment{0};
+  uint32_t progress{0};
+  uint32_t x{0};
+  uint32_t y{0};
+  bool reverse{false};
+
+  bool operator==(const Snapshot &) const = default;
+};
+
+inline Snapshot snapshot(const RoadFollowingState &road_following,
+                         vec2 position) {
+  return {static_cast<uint32_t>(road_following.current_segment_index),
+          std::bit_cast<uint32_t>(road_following.progress_along_segment),
+          std::bit_cast<uint32_t>(position.x),
+          std::bit_cast<uint32_t>(position.y),
+          road_following.reverse_direction};
+}
+
+// A dark map with nothing left over from the last run
+inline void reset(World &w, int level) {
+  maze_traversal_bench::reset_world(w);
+  w.shop->maze_algorithm_level = level;
+  MazeTraversal::last_segment_index = SIZE_MAX;
+  MazeTraversal::second_last_segment_index = SIZE_MAX;
+  SimRandom::seed(42);
+}
+
+// count pooled cars at random points on random segments, so they don't
+// all reach their junctions on the same tick
+inline void place(World &w, size_t count) {
+  const RoadNetwork &road_network = *w.road_network;
+  CarPool &cars = *w.cars;
+  cars.clear();
+  std::mt19937 rng(11);
+  for (size_t i = 0; i < count; ++i) {
+    size_t car = cars.add({0.0f, 0.0f}, 6.0f, CAR_SPEED, 1);
+    RoadFollowingState &road_following = cars.load(car);
+    road_following.current_segment_index =
+        rng() % road_network.segments.size();
+    road_following.reverse_direction = (rng() & 1) != 0;
+    road_following.progress_along_segment =
+        static_cast<float>(rng() % 1000) / 1000.0f;
+    cars.store(car);
+    const RoadSegment &segment = road_network.segments[cars.segment[car]];
+    vec2 from = cars.reverse[car] ? segment.end : segment.start;
+    vec2 to = cars.reverse[car] ? segment.start : segment.end;
+    cars.position[car] = {from.x + (to.x - from.x) * cars.progress[car],
+                          from.y + (to.y - from.y) * cars.progress[car]};
+  }
+}
+
+inline void release_slots(CarPool &cars) {
+  ExplorationPool *pool =
+      afterhours::EntityHelper::get_singleton_cmp<ExplorationPool>();
+  for (RoadFollowingState &road_following : cars.cold) {
+    pool->release(road_following);
+  }
+}
+
+// Every car after every tick, driving the pool as MazeTraversal does
+inline std::vector<Snapshot> drive_pooled(World &w, int ticks, float dt) {
+  MazeTraversal traversal;
+  CarPool &cars = *w.cars;
+  std::vector<Snapshot> snapshots;
+  for (int tick = 0; tick < ticks; ++tick) {
+    traversal.once(dt);
+    for (size_t car = 0; car < cars.size(); ++car) {
+      snapshots.push_back(snapshot(cars.load(car), cars.position[car]));
+    }
+  }
+  return snapshots;
+}
+
+// The same, but with each car a standalone struct driven through
+// MazeTraversal::advance(), the way entity cars are
+inline std::vector<Snapshot> drive_one_by_one(World &w, int ticks, float dt) {
+  CarPool &cars = *w.cars;
+  std::vector<Transform> transforms(cars.size());
+  std::vector<RoadFollowingState> states(cars.size());
+  for (size_t car = 0; car < cars.size(); ++car) {
+    transforms[car].position = cars.position[car];
+    states[car] = cars.load(car);
+  }
+  std::vector<Snapshot> snapshots;
+  for (int tick = 0; tick < ticks; ++tick) {
+    MazeTraversal::refresh_frontier();
+    for (size_t car = 0; car < cars.size(); ++car) {
+      MazeTraversal::advance(transforms[car], states[car], dt,
+                             MazeTraversal::MAX_SEGMENTS_PER_TICK);
+      snapshots.push_back(snapshot(states[car], transforms[car].position));
+    }
+  }
+  ExplorationPool *pool =
+      afterhours::EntityHelper::get_singleton_cmp<ExplorationPool>();
+  for (RoadFollowingState &road_following : states) {
+    pool->release(road_following);
+  }
+  return snapshots;
+}
+
+} // namespace car_pool_bench
+
+// Checks pooled cars drive exactly as they would one by one, then times a
+// fleet of 100k on the grid: every tick drives, reveals around and checks
+// POIs for each car, and must average under 1/60 s once the map is lit.
+// Driving the same fleet one by one is timed for comparison.
+BENCHMARK(car_pool_100k) {
+  using namespace car_pool_bench;
+  World &w = maze_traversal_bench::world();
+  int failures = 0;
+  constexpr float dt = 1.0f / 60.0f;
+
+  for (int level : {0, 3}) {
+    reset(w, level);
+    place(w, 64);
+    std::vector<Snapshot> one_by_one = drive_one_by_one(w, 120, dt);
+    reset(w, level);
+    place(w, 64);
+    std::vector<Snapshot> pooled = drive_pooled(w, 120, dt);
+    release_slots(*w.cars);
+    bool same = pooled == one_by_one;
+    failures += same ? 0 : 1;
+    std::cout << fmt::format("level {}: 64 cars over 120 ticks pooled {} "
+                             "one by one\n",
+                             level, same ? "match" : "DO NOT MATCH");
+  }
+
+  constexpr size_t fleet = 100'000;
+  reset(w, 0);
+  place(w, fleet);
+  MazeTraversal traversal;
+  RevealFogOfWar reveal_fog;
+  DiscoverySystem discovery;
+  auto tick = [&]() {
+    traversal.once(dt);
+    reveal_fog.once(dt);
+    discovery.once(dt);
+  };
+
+  // The first second lights the map, so nearly every car is at a junction
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 60; ++i) {
+    tick();
+  }
+  double first_second_ms = bench_elapsed_ms(start);
+
+  constexpr int ticks = 300;
+  double worst_ms = 0.0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ticks; ++i) {
+    auto tick_start = std::chrono::steady_clock::now();
+    tick();
+    worst_ms = std::max(worst_ms, bench_elapsed_ms(tick_start));
+  }
+  double mean_ms = bench_elapsed_ms(start) / ticks;
+  bool fast = mean_ms < 1000.0 / 60.0;
+  failures += fast ? 0 : 1;
+  std::cout << fmt::format(
+      "{} pooled cars: first second {:.0f} ms, then {:.2f} ms a tick "
+      "(worst {:.2f}){}; {}/{} segments visited\n",
+      fleet, first_second_ms, mean_ms, worst_ms,
+      fast ? "" : " (OVER 1/60 s)",
+      maze_traversal_bench::visited_count(*w.road_network),
+      w.road_network->segments.size());
+
+  constexpr int one_by_one_ticks = 10;
+  start = std::chrono::steady_clock::now();
+  drive_one_by_one(w, one_by_one_ticks, dt);
+  double one_by_one_ms = bench_elapsed_ms(start) / one_by_one_ticks;
+  std::cout << fmt::format(
+      "{} cars one by one through advance(): {:.2f} ms a tick (driving "
+      "only)\n",
+      fleet, one_by_one_ms);
+
+  release_slots(*w.cars);
+  w.cars->clear();
+  return failures == 0 ? 0 : 1;
+}
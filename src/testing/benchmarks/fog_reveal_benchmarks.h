@@ -0,0 +1,400 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../systems/MapRevealSystem.h"
+#include "../bench_macros.h"
+#include "maze_traversal_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+#include <random>
+
+namespace fog_reveal_bench {
+
+// The reveal as it was before row runs: every cell of the bounding
+// square tested and set one at a time
+inline void reveal_cell_by_cell(FogCells &fog, FogCells &photo,
+                                const vec2 &position, float radius) {
+  float reveal_radius_sq = radius * radius;
+  int center_grid_x = game_constants::world_to_grid_x(position.x);
+  int center_grid_y = game_constants::world_to_grid_y(position.y);
+  int radius_in_cells =
+      static_cast<int>(std::ceil(radius / game_constants::BRICK_CELL_SIZE));
+  for (int dy = -radius_in_cells; dy <= radius_in_cells; ++dy) {
+    for (int dx = -radius_in_cells; dx <= radius_in_cells; ++dx) {
+      int grid_x = center_grid_x + dx;
+      int grid_y = center_grid_y + dy;
+      if (grid_x < 0 || grid_x >= game_constants::GRID_WIDTH || grid_y < 0 ||
+          grid_y >= game_constants::GRID_HEIGHT) {
+        continue;
+      }
+      if (fog.test(grid_x, grid_y)) {
+        continue;
+      }
+      vec2 cell_world_pos = game_constants::grid_to_world_pos(grid_x, grid_y);
+      vec2 cell_center = {
+          cell_world_pos.x + game_constants::BRICK_CELL_SIZE * 0.5f,
+          cell_world_pos.y + game_constants::BRICK_CELL_SIZE * 0.5f};
+      float dx_world = cell_center.x - position.x;
+      float dy_world = cell_center.y - position.y;
+      if (dx_world * dx_world + dy_world * dy_world > reveal_radius_sq) {
+        continue;
+      }
+      fog.set(grid_x, grid_y);
+      photo.set(grid_x, grid_y);
+    }
+  }
+}
+
+// Mostly on the map, some off its edges the way a car near one can be.
+// Every eighth lands on a cell corner, where distances tie exactly.
+inline std::vector<vec2> positions(size_t count) {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> x(-100.0f,
+                                          game_constants::WORLD_WIDTH + 100.0f);
+  std::uniform_real_distribution<float> y(
+      -100.0f, game_constants::WORLD_HEIGHT + 100.0f);
+  std::vector<vec2> result(count);
+  for (size_t i = 0; i < count; ++i) {
+    result[i] = {x(rng), y(rng)};
+    if (i % 8 == 0) {
+      result[i] = game_constants::grid_to_world_pos(
+          static_cast<int>(rng() % game_constants::GRID_WIDTH),
+          static_cast<int>(rng() % game_constants::GRID_HEIGHT));
+    }
+  }
+  return result;
+}
+
+inline vec2 cell_center(int grid_x, int grid_y) {
+  vec2 cell_world_pos = game_constants::grid_to_world_pos(grid_x, grid_y);
+  return {cell_world_pos.x + game_constants::BRICK_CELL_SIZE * 0.5f,
+          cell_world_pos.y + game_constants::BRICK_CELL_SIZE * 0.5f};
+}
+
+// A segment's reveal as it was before capsules: a disc stamped every
+// radius or so along it
+inline void stamp_segment(FogCells &fog, const RoadSegment &segment,
+                          float radius) {
+  FogCells photo;
+  vec2 direction = {segment.end.x - segment.start.x,
+                    segment.end.y - segment.start.y};
+  float segment_length =
+      std::sqrt(direction.x * direction.x + direction.y * direction.y);
+  if (segment_length < 0.001f) {
+    reveal_cell_by_cell(fog, photo, segment.start, radius);
+    return;
+  }
+  int steps = static_cast<int>(std::ceil(segment_length / radius)) + 1;
+  for (int i = 0; i <= steps; ++i) {
+    float t = static_cast<float>(i) / static_cast<float>(steps);
+    vec2 pos = {segment.start.x + direction.x * t,
+                segment.start.y + direction.y * t};
+    reveal_cell_by_cell(fog, photo, pos, radius);
+  }
+}
+
+// Every cell whose centre is within radius of the segment, tested one by
+// one over the whole grid
+inline FogCells capsule_cell_by_cell(const RoadSegment &segment,
+                                     float radius) {
+  FogCells cells;
+  vec2 dir = {segment.end.x - segment.start.x,
+              segment.end.y - segment.start.y};
+  float len_sq = dir.x * dir.x + dir.y * dir.y;
+  for (int grid_y = 0; grid_y < game_constants::GRID_HEIGHT; ++grid_y) {
+    for (int grid_x = 0; grid_x < game_constants::GRID_WIDTH; ++grid_x) {
+      vec2 point = cell_center(grid_x, grid_y);
+      float t = 0.0f;
+      if (len_sq > 0.0f) {
+        t = std::clamp(((point.x - segment.start.x) * dir.x +
+                        (point.y - segment.start.y) * dir.y) /
+                           len_sq,
+                       0.0f, 1.0f);
+      }
+      float dx = point.x - (segment.start.x + t * dir.x);
+      float dy = point.y - (segment.start.y + t * dir.y);
+      if (dx * dx + dy * dy <= radius * radius) {
+        cells.set(grid_x, grid_y);
+      }
+    }
+  }
+  return cells;
+}
+
+// The cells the old segment query looked at: the one under each stamp
+inline void sampled_cells(const RoadSegment &segment, float radius,
+                          std::vector<std::pair<int, int>> &out) {
+  out.clear();
+  vec2 direction = {segment.end.x - segment.start.x,
+                    segment.end.y - segment.start.y};
+  float segment_length =
+      std::sqrt(direction.x * direction.x + direction.y * direction.y);
+  int steps = segment_length < 0.001f
+                  ? 0
+                  : static_cast<int>(std::ceil(segment_length / radius)) + 1;
+  for (int i = 0; i <= steps; ++i) {
+    float t = steps == 0 ? 0.0f
+                         : static_cast<float>(i) / static_cast<float>(steps);
+    vec2 pos = {segment.start.x + direction.x * t,
+                segment.start.y + direction.y * t};
+    int grid_x = game_constants::world_to_grid_x(pos.x);
+    int grid_y = game_constants::world_to_grid_y(pos.y);
+    if (grid_x >= 0 && grid_x < game_constants::GRID_WIDTH && grid_y >= 0 &&
+        grid_y < game_constants::GRID_HEIGHT) {
+      out.push_back({grid_x, grid_y});
+    }
+  }
+}
+
+// Roads of every shape a map can hold: scattered, axis aligned, running
+// along cell edges and through cell centres where distances tie, and
+// points
+inline std::vector<RoadSegment> segments(size_t count) {
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<float> x(-100.0f,
+                                          game_constants::WORLD_WIDTH + 100.0f);
+  std::uniform_real_distribution<float> y(
+      -100.0f, game_constants::WORLD_HEIGHT + 100.0f);
+  std::uniform_real_distribution<float> reach(-400.0f, 400.0f);
+  auto lattice = [&]() {
+    vec2 corner = game_constants::grid_to_world_pos(
+        static_cast<int>(rng() % game_constants::GRID_WIDTH),
+        static_cast<int>(rng() % game_constants::GRID_HEIGHT));
+    float half = (rng() & 1) ? game_constants::BRICK_CELL_SIZE * 0.5f : 0.0f;
+    return vec2{corner.x + half, corner.y + half};
+  };
+  std::vector<RoadSegment> result(count);
+  for (size_t i = 0; i < count; ++i) {
+    RoadSegment &segment = result[i];
+    vec2 start = {x(rng), y(rng)};
+    vec2 end = {start.x + reach(rng), start.y + reach(rng)};
+    switch (i % 6) {
+    case 1:
+      end.y = start.y;
+      break;
+    case 2:
+      end.x = start.x;
+      break;
+    case 3:
+      start = lattice();
+      end = lattice();
+      break;
+    case 4:
+      end = (rng() & 1) ? start : vec2{start.x + 0.01f, start.y};
+      break;
+    default:
+      break;
+    }
+    segment.start = start;
+    segment.end = end;
+  }
+  return result;
+}
+
+struct SegmentCoverage {
+  // Segments whose capsule runs differ from the per-cell test
+  size_t inexact{0};
+  // Cells the old per-sample discs revealed that the capsule left dark
+  size_t missed{0};
+  // Cells the old segment query sampled that the crossed runs skip
+  size_t unsampled{0};
+  size_t stamped_cells{0};
+  size_t capsule_cells{0};
+
+  bool good() const { return inexact == 0 && missed == 0 && unsampled == 0; }
+};
+
+// Checks every segment's capsule against the per-cell test and the old
+// stamps, and its crossed cells against the old query's samples
+inline SegmentCoverage check_coverage(const std::vector<RoadSegment> &roads,
+                                      float radius) {
+  SegmentCoverage result;
+  std::vector<std::pair<int, int>> samples;
+  for (const RoadSegment &segment : roads) {
+    FogCells capsule;
+    MapRevealSystem::for_each_capsule_span(
+        segment, radius,
+        [&](int grid_y, int x0, int x1) { capsule.set_span(grid_y, x0, x1); });
+    result.inexact +=
+        capsule.words == capsule_cell_by_cell(segment, radius).words ? 0 : 1;
+    FogCells stamped;
+    stamp_segment(stamped, segment, radius);
+    for (size_t word = 0; word < stamped.words.size(); ++word) {
+      result.missed += static_cast<size_t>(
+          std::popcount(stamped.words[word] & ~capsule.words[word]));
+    }
+    result.stamped_cells += stamped.count();
+    result.capsule_cells += capsule.count();
+
+    FogCells crossed;
+    MapRevealSystem::for_each_crossed_span(
+        segment,
+        [&](int grid_y, int x0, int x1) { crossed.set_span(grid_y, x0, x1); });
+    sampled_cells(segment, radius, samples);
+    for (auto [grid_x, grid_y] : samples) {
+      result.unsampled += crossed.test(grid_x, grid_y) ? 0 : 1;
+    }
+  }
+  return result;
+}
+
+} // namespace fog_reveal_bench
+
+// Checks revealing by row runs sets exactly the fog and photo cells the
+// cell-by-cell reveal did, over scattered positions and a range of reveal
+// radii, then times both. Fog is cleared every 64 reveals so most of them
+// still uncover something.
+BENCHMARK(reveal_position) {
+  using namespace fog_reveal_bench;
+  maze_traversal_bench::World &w = maze_traversal_bench::world();
+  IsPhotoReveal *photo =
+      afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>();
+  int failures = 0;
+
+  std::vector<vec2> points = positions(20'000);
+  for (float radius : {20.0f, 50.0f, 100.0f, 200.0f, 400.0f, 800.0f}) {
+    FogCells fog_by_cell;
+    FogCells photo_by_cell;
+    size_t mismatches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < points.size(); ++i) {
+      if (i % 64 == 0) {
+        fog_by_cell.reset();
+        photo_by_cell.reset();
+      }
+      reveal_cell_by_cell(fog_by_cell, photo_by_cell, points[i], radius);
+    }
+    double by_cell_ms = bench_elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < points.size(); ++i) {
+      if (i % 64 == 0) {
+        w.fog->revealed_cells.reset();
+        photo->revealed_cells.reset();
+      }
+      MapRevealSystem::reveal_position(*w.fog, *photo, points[i], radius);
+    }
+    double by_run_ms = bench_elapsed_ms(start);
+    size_t rows = 0;
+    for (const vec2 &point : points) {
+      MapRevealSystem::for_each_disc_span(point, radius,
+                                          [&](int, int, int) { ++rows; });
+    }
+
+    // Batch by batch, so a difference isn't hidden by a later reveal
+    for (size_t batch = 0; batch < points.size(); batch += 64) {
+      FogCells fog_check;
+      FogCells photo_check;
+      w.fog->revealed_cells.reset();
+      photo->revealed_cells.reset();
+      for (size_t i = batch; i < std::min(points.size(), batch + 64); ++i) {
+        reveal_cell_by_cell(fog_check, photo_check, points[i], radius);
+        MapRevealSystem::reveal_position(points[i], radius);
+      }
+      bool same = fog_check.words == w.fog->revealed_cells.words &&
+                  photo_check.words == photo->revealed_cells.words &&
+                  fog_check.count() == w.fog->revealed_cells.count();
+      mismatches += same ? 0 : 1;
+    }
+    failures += mismatches == 0 ? 0 : 1;
+    std::cout << fmt::format(
+        "radius {:.0f}: {} reveals, row runs {:.0f} ns each ({:.1f} rows, "
+        "{:.1f} ns a row), cell by cell {:.0f} ns each; {}\n",
+        radius, points.size(), by_run_ms * 1e6 / points.size(),
+        static_cast<double>(rows) / points.size(),
+        by_run_ms * 1e6 / std::max<size_t>(rows, 1),
+        by_cell_ms * 1e6 / points.size(),
+        mismatches == 0
+            ? "same cells"
+            : fmt::format("{} batches DIFFER", mismatches));
+  }
+
+  w.fog->revealed_cells.reset();
+  photo->revealed_cells.reset();
+  return failures == 0 ? 0 : 1;
+}
+
+// Checks a segment's capsule rasterizes to exactly the cells the per-cell
+// distance test passes, and covers every cell the old disc stamps did;
+// and that the cells a segment crosses include every cell the old query
+// sampled. Then times capsules against stamps, and crossed runs against
+// sampling, per segment.
+BENCHMARK(segment_reveal) {
+  using namespace fog_reveal_bench;
+  int failures = 0;
+  std::vector<RoadSegment> roads = segments(3000);
+  std::vector<std::pair<int, int>> samples;
+
+  for (float radius : {20.0f, 50.0f, 200.0f}) {
+    SegmentCoverage coverage = check_coverage(roads, radius);
+    failures += coverage.good() ? 0 : 1;
+    std::cout << fmt::format(
+        "radius {:.0f}: {} segments, {} not exact, {} stamped cells "
+        "missed, {} sampled cells not crossed; capsules cover {} cells to "
+        "the stamps' {}\n",
+        radius, roads.size(), coverage.inexact, coverage.missed,
+        coverage.unsampled, coverage.capsule_cells, coverage.stamped_cells);
+
+    // Timed on one grid, cleared every 64 segments so most still reveal
+    FogCells fog;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < roads.size(); ++i) {
+      if (i % 64 == 0) {
+        fog.reset();
+      }
+      stamp_segment(fog, roads[i], radius);
+    }
+    double stamps_ms = bench_elapsed_ms(start);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < roads.size(); ++i) {
+      if (i % 64 == 0) {
+        fog.reset();
+      }
+      MapRevealSystem::for_each_capsule_span(
+          roads[i], radius,
+          [&](int grid_y, int x0, int x1) { fog.set_span(grid_y, x0, x1); });
+    }
+    double capsules_ms = bench_elapsed_ms(start);
+    std::cout << fmt::format(
+        "radius {:.0f}: capsule {:.0f} ns a segment, stamps {:.0f} ns\n",
+        radius, capsules_ms * 1e6 / roads.size(),
+        stamps_ms * 1e6 / roads.size());
+  }
+
+  // Half the map revealed, as a query mid-game sees it
+  FogCells fog;
+  std::mt19937 rng(13);
+  for (size_t word = 0; word < fog.words.size(); ++word) {
+    fog.set_bits(word, (static_cast<uint64_t>(rng()) << 32) | rng());
+  }
+  size_t hits = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const RoadSegment &segment : roads) {
+    sampled_cells(segment, 50.0f, samples);
+    hits += std::any_of(samples.begin(), samples.end(),
+                        [&](std::pair<int, int> cell) {
+                          return fog.test(cell.first, cell.second);
+                        })
+                ? 1
+                : 0;
+  }
+  double sampled_ms = bench_elapsed_ms(start);
+  size_t crossed_hits = 0;
+  start = std::chrono::steady_clock::now();
+  for (const RoadSegment &segment : roads) {
+    bool any = false;
+    MapRevealSystem::for_each_crossed_span(
+        segment, [&](int grid_y, int x0, int x1) {
+          any = any || fog.any_in_span(grid_y, x0, x1);
+        });
+    crossed_hits += any ? 1 : 0;
+  }
+  double crossed_ms = bench_elapsed_ms(start);
+  std::cout << fmt::format(
+      "query: crossed cells {:.0f} ns a segment ({} revealed), sampled "
+      "{:.0f} ns ({} revealed)\n",
+      crossed_ms * 1e6 / roads.size(), crossed_hits,
+      sampled_ms * 1e6 / roads.size(), hits);
+
+  return failures == 0 ? 0 : 1;
+}
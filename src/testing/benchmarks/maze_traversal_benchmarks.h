@@ -0,0 +1,557 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../systems/MazeTraversal.h"
+#include "../allocation_counter.h"
+#include "../bench_macros.h"
+#include "road_chain_benchmarks.h"
+#include "road_network_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+
+namespace maze_traversal_bench {
+
+template <typename Component, typename... Args>
+Component &add_singleton(afterhours::Entity &entity, Args &&...args) {
+  Component &component =
+      entity.addComponent<Component>(std::forward<Args>(args)...);
+  afterhours::EntityHelper::registerSingleton<Component>(entity);
+  return component;
+}
+
+struct Car {
+  Transform transform;
+  RoadFollowing road_following;
+};
+
+// The singletons MazeTraversal reads, created once and shared by every
+// benchmark here over a closed grid, so no car can end up at a dead end
+struct World {
+  RoadNetwork *road_network{nullptr};
+  IsShopManager *shop{nullptr};
+  FogOfWar *fog{nullptr};
+  // Empty unless a benchmark fills it, and emptied again after
+  CarPool *cars{nullptr};
+  // Serial unless a benchmark starts it, and stopped again after
+  SimulationWorkers *workers{nullptr};
+};
+
+inline World &world() {
+  static World instance = []() {
+    afterhours::Entity &entity = afterhours::EntityHelper::createEntity();
+    World w;
+    w.road_network = &add_singleton<RoadNetwork>(entity);
+    w.shop = &add_singleton<IsShopManager>(entity, 100, 1, 100);
+    w.fog = &add_singleton<FogOfWar>(entity);
+    w.cars = &add_singleton<CarPool>(entity);
+    w.workers = &add_singleton<SimulationWorkers>(entity);
+    add_singleton<IsPhotoReveal>(entity, game_constants::BRICK_CELL_SIZE);
+    // Left empty unless a benchmark lays bricks
+    add_singleton<BrickGrid>(entity);
+    add_singleton<ExplorationPool>(entity);
+    add_singleton<CoverageRouting>(entity);
+
+    RoadNetwork &road_network = *w.road_network;
+    road_chain_bench::make_subdivided_grid(road_network, 100, 2);
+    road_network.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+    road_network.build_connected_components(
+        road_network_bench::CONNECTION_TOLERANCE);
+    // Completion events are drained elsewhere; give them their room up front
+    road_network.completed_components.reserve(
+        road_network.component_count());
+    return w;
+  }();
+  return instance;
+}
+
+// Forgets every visit so the next run starts on a dark map
+inline void reset_world(World &w) {
+  std::fill(w.road_network->visited_segments.begin(),
+            w.road_network->visited_segments.end(), false);
+  w.road_network->rebuild_visit_tracking();
+  // The game builds it on the first car to seek new road; here it's built
+  // up front so that one-off allocation never lands in a measured tick
+  w.road_network->ensure_frontier();
+  w.road_network->completed_components.reserve(
+      w.road_network->component_count());
+  w.fog->revealed_cells.reset();
+  w.road_network->claims.build(w.road_network->chains.chain_count());
+}
+
+inline std::vector<Car> make_cars(const RoadNetwork &road_network,
+                                  size_t count, float speed) {
+  std::mt19937 rng(3);
+  std::vector<Car> cars(count);
+  for (Car &car : cars) {
+    car.road_following = RoadFollowing(speed);
+    car.road_following.current_segment_index =
+        rng() % road_network.segments.size();
+    car.transform.position =
+        road_network.segments[car.road_following.current_segment_index].start;
+  }
+  return cars;
+}
+
+inline size_t visited_count(const RoadNetwork &road_network) {
+  return road_network.segments.size() - road_network.get_unvisited_count();
+}
+
+// Tour steps a car can't actually drive: past a degree-2 weld only the
+// chain goes on, elsewhere any linked segment or a U-turn
+inline size_t undrivable_steps(const RoadNetwork &road_network,
+                               const CoverageRoute &route) {
+  size_t bad = 0;
+  for (size_t i = 0; i < route.links.size(); ++i) {
+    uint32_t exit = route.links[i] ^ 1u;
+    uint32_t next = route.links[(i + 1) % route.links.size()];
+    uint32_t chained = road_network.chains.continue_link(exit);
+    if (chained != RoadChains::INVALID) {
+      bad += next == chained ? 0 : 1;
+      continue;
+    }
+    std::span<const uint32_t> links = road_network.graph.port_links(exit);
+    bool linked = next == exit ||
+                  std::find(links.begin(), links.end(), next) != links.end();
+    bad += linked ? 0 : 1;
+  }
+  return bad;
+}
+
+// Ticks for a fleet to cover 95% and then all of the map, -1 if it never
+// does within max_ticks
+inline std::pair<int, int> ticks_to_cover(World &w, int level,
+                                          size_t car_count, int max_ticks) {
+  RoadNetwork &road_network = *w.road_network;
+  reset_world(w);
+  w.shop->maze_algorithm_level = level;
+  // Every fleet drives the same total distance per tick
+  std::vector<Car> cars = make_cars(
+      road_network, car_count, 96'000.0f / static_cast<float>(car_count));
+  MazeTraversal traversal;
+  afterhours::Entity &unused = afterhours::EntityHelper::createEntity();
+  size_t most = road_network.segments.size() * 95 / 100;
+  int ticks_to_most = -1;
+  for (int tick = 1; tick <= max_ticks; ++tick) {
+    traversal.once(1.0f / 60.0f);
+    for (Car &car : cars) {
+      traversal.for_each_with(unused, car.transform, car.road_following,
+                              1.0f / 60.0f);
+    }
+    size_t visited = visited_count(road_network);
+    if (ticks_to_most < 0 && visited >= most) {
+      ticks_to_most = tick;
+    }
+    if (visited == road_network.segments.size()) {
+      return {ticks_to_most, tick};
+    }
+  }
+  return {ticks_to_most, -1};
+}
+
+struct HotPathRun {
+  size_t cars{0};
+  int ticks{0};
+  size_t allocations{0};
+  int ticks_allocating{0};
+  double tick_us{0.0};
+  size_t newly_visited{0};
+};
+
+// Drives a fleet of cars through MazeTraversal, counting every heap
+// allocation made by the ticks after warm-up
+inline HotPathRun run_hot_path(World &w) {
+  RoadNetwork &road_network = *w.road_network;
+  reset_world(w);
+  w.shop->maze_algorithm_level = 0;
+  std::vector<Car> cars = make_cars(road_network, 256, 250.0f);
+
+  MazeTraversal traversal;
+  afterhours::Entity &unused = afterhours::EntityHelper::createEntity();
+  auto tick = [&]() {
+    traversal.once(1.0f / 60.0f);
+    for (Car &car : cars) {
+      traversal.for_each_with(unused, car.transform, car.road_following,
+                              1.0f / 60.0f);
+    }
+  };
+
+  for (int i = 0; i < 60; ++i) {
+    tick();
+  }
+  size_t visited_before = visited_count(road_network);
+
+  HotPathRun run;
+  run.cars = cars.size();
+  run.ticks = 1'200;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < run.ticks; ++i) {
+    AllocationCounter counter;
+    tick();
+    run.allocations += counter.count();
+    run.ticks_allocating += counter.count() == 0 ? 0 : 1;
+  }
+  run.tick_us = bench_elapsed_ms(start) * 1000.0 / run.ticks;
+  run.newly_visited = visited_count(road_network) - visited_before;
+  return run;
+}
+
+} // namespace maze_traversal_bench
+
+// Fails if any MazeTraversal tick after warm-up touches the heap; the
+// maze_traversal_allocations test asserts the same
+BENCHMARK(maze_traversal_allocations) {
+  using namespace maze_traversal_bench;
+  World &w = world();
+  HotPathRun run = run_hot_path(w);
+  const char *verdict = run.allocations == 0 ? "none" : "HOT PATH ALLOCATES";
+  if (!allocation_counter::ENABLED) {
+    verdict = "not counted, build with ALLOCATION_COUNTING=1";
+  }
+  std::cout << fmt::format(
+      "{} cars x {} ticks on {} segments: {:.1f} us per tick, {} segments "
+      "newly visited\n"
+      "  heap allocations: {} over {} ticks, {}\n",
+      run.cars, run.ticks, w.road_network->segments.size(), run.tick_us,
+      run.newly_visited, run.allocations, run.ticks_allocating, verdict);
+  return run.allocations == 0 && run.newly_visited > 0 ? 0 : 1;
+}
+
+// Runs the same small fleet under each algorithm the shop sells and
+// compares how many ticks it takes to cover most and then all of the map,
+// plus the worst tick, since every policy's per-junction work is meant to
+// stay bounded
+BENCHMARK(exploration_policies) {
+  using namespace maze_traversal_bench;
+  World &w = world();
+  RoadNetwork &road_network = *w.road_network;
+
+  constexpr int max_ticks = 10'000;
+  auto share = [&](double fraction) {
+    return static_cast<size_t>(
+        fraction * static_cast<double>(road_network.segments.size()));
+  };
+  int wall_follower_ticks = 0;
+  int failures = 0;
+  for (int level = 0; level < 4; ++level) {
+    reset_world(w);
+    w.shop->maze_algorithm_level = level;
+    // Fast enough to finish a segment every tick
+    std::vector<Car> cars = make_cars(road_network, 16, 6000.0f);
+
+    MazeTraversal traversal;
+    afterhours::Entity &unused = afterhours::EntityHelper::createEntity();
+    int ticks_to_half = -1;
+    int ticks_to_most = -1;
+    int ticks_to_all = -1;
+    double worst_tick_us = 0.0;
+    size_t allocations = 0;
+    int ticks = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (ticks < max_ticks && ticks_to_all < 0) {
+      auto tick_start = std::chrono::steady_clock::now();
+      AllocationCounter counter;
+      traversal.once(1.0f / 60.0f);
+      for (Car &car : cars) {
+        traversal.for_each_with(unused, car.transform, car.road_following,
+                                1.0f / 60.0f);
+      }
+      // The first few hundred ticks size each car's buffers
+      allocations += ticks < 300 ? 0 : counter.count();
+      worst_tick_us =
+          std::max(worst_tick_us, bench_elapsed_ms(tick_start) * 1000.0);
+      ++ticks;
+      size_t visited = visited_count(road_network);
+      if (ticks_to_half < 0 && visited >= share(0.5)) {
+        ticks_to_half = ticks;
+      }
+      if (ticks_to_most < 0 && visited >= share(0.95)) {
+        ticks_to_most = ticks;
+      }
+      if (visited == road_network.segments.size()) {
+        ticks_to_all = ticks;
+      }
+    }
+    double tick_us = bench_elapsed_ms(start) * 1000.0 / ticks;
+
+    int score = ticks_to_most < 0 ? max_ticks : ticks_to_most;
+    if (level == 0) {
+      wall_follower_ticks = score;
+    } else if (score > wall_follower_ticks || allocations != 0) {
+      failures++;
+    }
+    std::cout << fmt::format(
+        "{:>12}: {} cars on {} segments reach 50% in {} ticks, 95% in {}, "
+        "100% in {}; {:.1f} us per tick, worst {:.1f} us, {} allocations "
+        "after warm-up\n",
+        magic_enum::enum_name(w.shop->get_current_algorithm()), cars.size(),
+        road_network.segments.size(), ticks_to_half, ticks_to_most,
+        ticks_to_all, tick_us, worst_tick_us,
+        allocation_counter::ENABLED ? fmt::format("{}", allocations)
+                                    : std::string("uncounted"));
+  }
+  w.shop->maze_algorithm_level = 0;
+  return failures == 0 ? 0 : 1;
+}
+
+// A* gives up on road further off than its expansion budget reaches.
+// Leaves one segment unvisited, in the grid corner furthest from a car,
+// checks an A* search from the car runs out rather than finding it, then
+// that the car still gets there down the frontier field
+BENCHMARK(astar_search_budget) {
+  using namespace maze_traversal_bench;
+  World &w = world();
+  RoadNetwork &road_network = *w.road_network;
+  reset_world(w);
+
+  Car car;
+  car.road_following = RoadFollowing(6000.0f);
+  car.transform.position = road_network.segments[0].start;
+  size_t goal = 0;
+  float furthest = 0.0f;
+  for (size_t seg = 0; seg < road_network.segments.size(); ++seg) {
+    const RoadSegment &segment = road_network.segments[seg];
+    float d = std::hypot(segment.end.x - car.transform.position.x,
+                         segment.end.y - car.transform.position.y);
+    if (d > furthest) {
+      furthest = d;
+      goal = seg;
+    }
+  }
+  for (size_t seg = 0; seg < road_network.segments.size(); ++seg) {
+    if (seg != goal) {
+      road_network.mark_visited(seg);
+    }
+  }
+  MazeTraversal::refresh_frontier();
+
+  // The search A* runs at the car's first junction
+  ExplorationState state;
+  ExplorationScratch scratch;
+  ExplorationContext ctx{car.road_following, road_network, state, scratch,
+                         road_network.turns.at(RoadGraph::exit_port(0, false)),
+                         RoadGraph::make_link(0, true)};
+  auto start = std::chrono::steady_clock::now();
+  bool gave_up = AStarPolicy::choose(ctx) == RoadGraph::INVALID;
+  double search_us = bench_elapsed_ms(start) * 1000.0;
+
+  w.shop->maze_algorithm_level = 3;
+  MazeTraversal traversal;
+  afterhours::Entity &unused = afterhours::EntityHelper::createEntity();
+  constexpr int max_ticks = 5000;
+  int ticks = 0;
+  start = std::chrono::steady_clock::now();
+  while (ticks < max_ticks && !road_network.is_visited(goal)) {
+    traversal.once(1.0f / 60.0f);
+    traversal.for_each_with(unused, car.transform, car.road_following,
+                            1.0f / 60.0f);
+    ++ticks;
+  }
+  double drive_ms = bench_elapsed_ms(start);
+  bool reached = road_network.is_visited(goal);
+  w.shop->maze_algorithm_level = 0;
+
+  std::cout << fmt::format(
+      "one unvisited segment {:.0f} units off on {} segments: A* search "
+      "{} in {:.0f} us ({} expansions at most); car reached it in {} "
+      "ticks, {:.2f} ms\n",
+      furthest, road_network.segments.size(),
+      gave_up ? "gave up" : "FOUND IT WITHIN BUDGET", search_us,
+      ExplorationScratch::MAX_EXPANSIONS, reached ? ticks : -1, drive_ms);
+  return gave_up && reached ? 0 : 1;
+}
+
+// Coverage over time for growing fleets that all start on one segment, as
+// SpawnNewCars piles them up. Each fleet runs twice: with every car its own
+// agent, so claims spread them over the frontier, and with all of them
+// sharing one agent id, so nobody defers to anybody.
+BENCHMARK(fleet_coverage) {
+  using namespace maze_traversal_bench;
+  World &w = world();
+  RoadNetwork &road_network = *w.road_network;
+  w.shop->maze_algorithm_level = 0;
+
+  constexpr std::array<int, 5> checkpoints = {25, 50, 100, 200, 400};
+  auto run = [&](size_t car_count, bool coordinated) {
+    reset_world(w);
+    // Exactly one 80-unit segment per tick, so every tick ends on a
+    // junction and the whole pile-up decides before any car reveals the
+    // road ahead, as cars traversed in parallel would
+    constexpr float dt = 1.0f / 64.0f;
+    std::vector<Car> cars = make_cars(road_network, car_count, 80.0f / dt);
+    for (Car &car : cars) {
+      car.road_following.current_segment_index =
+          cars[0].road_following.current_segment_index;
+      car.transform.position = cars[0].transform.position;
+      car.road_following.agent_id = coordinated ? FrontierClaims::FREE : 1;
+    }
+    MazeTraversal traversal;
+    afterhours::Entity &unused = afterhours::EntityHelper::createEntity();
+    std::array<double, checkpoints.size()> coverage{};
+    size_t next_checkpoint = 0;
+    for (int tick = 1; next_checkpoint < checkpoints.size(); ++tick) {
+      traversal.once(dt);
+      for (Car &car : cars) {
+        traversal.for_each_with(unused, car.transform, car.road_following,
+                                dt);
+      }
+      if (tick == checkpoints[next_checkpoint]) {
+        coverage[next_checkpoint++] =
+            100.0 * static_cast<double>(visited_count(road_network)) /
+            static_cast<double>(road_network.segments.size());
+      }
+    }
+    return coverage;
+  };
+
+  std::cout << fmt::format("coverage % of {} segments after N ticks\n",
+                           road_network.segments.size());
+  std::cout << fmt::format("{:>6} {:>13}", "cars", "");
+  for (int checkpoint : checkpoints) {
+    std::cout << fmt::format(" {:>7}", checkpoint);
+  }
+  std::cout << "\n";
+
+  int failures = 0;
+  for (size_t car_count : {1, 10, 100, 1000}) {
+    std::array<double, checkpoints.size()> results[2];
+    for (bool coordinated : {true, false}) {
+      results[coordinated ? 0 : 1] = run(car_count, coordinated);
+      std::cout << fmt::format("{:>6} {:>13}", car_count,
+                               coordinated ? "claims" : "uncoordinated");
+      for (double pct : results[coordinated ? 0 : 1]) {
+        std::cout << fmt::format(" {:>7.2f}", pct);
+      }
+      std::cout << "\n";
+    }
+    // A lone car has nobody to coordinate with
+    if (car_count > 1 && results[0][1] < results[1][1]) {
+      failures++;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+// One car at increasing speed upgrades. Leftover distance carries across
+// segment ends, so coverage per tick should grow with speed rather than
+// stall at one segment per tick.
+BENCHMARK(speed_scaling) {
+  using namespace maze_traversal_bench;
+  World &w = world();
+  RoadNetwork &road_network = *w.road_network;
+  w.shop->maze_algorithm_level = 0;
+
+  constexpr int ticks = 600;
+  constexpr float base_speed = 250.0f;
+  double base_visited = 0.0;
+  int failures = 0;
+  for (float multiplier : {1.0f, 4.0f, 16.0f, 64.0f}) {
+    reset_world(w);
+    std::vector<Car> cars =
+        make_cars(road_network, 1, base_speed * multiplier);
+    MazeTraversal traversal;
+    afterhours::Entity &unused = afterhours::EntityHelper::createEntity();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) {
+      traversal.once(1.0f / 60.0f);
+      traversal.for_each_with(unused, cars[0].transform,
+                              cars[0].road_following, 1.0f / 60.0f);
+    }
+    double tick_us = bench_elapsed_ms(start) * 1000.0 / ticks;
+    double visited = static_cast<double>(visited_count(road_network));
+    if (multiplier == 1.0f) {
+      base_visited = visited;
+    }
+    double scaling = visited / std::max(base_visited, 1.0);
+    // Allow for the odd revisit eating into the faster runs
+    failures += scaling >= 0.75 * multiplier ? 0 : 1;
+    std::cout << fmt::format(
+        "{:>5.0f}x speed: {:>6.0f} segments in {} ticks ({:.1f}x the base "
+        "speed's coverage), {:.1f} us per tick\n",
+        multiplier, visited, ticks, scaling, tick_us);
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+// Plans a coverage tour for every NYC component on the planner's thread,
+// checks the tours are drivable and complete, then races the route planner
+// against the wall follower to full coverage on the grid and on NYC
+BENCHMARK(coverage_route) {
+  using namespace maze_traversal_bench;
+  World &w = world();
+  int failures = 0;
+
+  std::filesystem::path nyc_roads_path =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  RoadNetwork nyc;
+  bool has_nyc = load_road_network_from_json(nyc, nyc_roads_path);
+  if (has_nyc) {
+    nyc.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+    nyc.completed_components.reserve(nyc.component_count());
+    std::vector<size_t> roots;
+    for (size_t seg = 0; seg < nyc.segments.size(); ++seg) {
+      if (nyc.components.is_root(seg)) {
+        roots.push_back(seg);
+      }
+    }
+    CoveragePlanner planner;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t root : roots) {
+      planner.request(nyc, root, 0);
+    }
+    planner.wait_idle();
+    double plan_ms = bench_elapsed_ms(start);
+    std::vector<std::shared_ptr<const CoverageRoute>> routes =
+        planner.take_finished();
+
+    double length = 0.0;
+    double repeated = 0.0;
+    size_t unreached = 0;
+    size_t undrivable = 0;
+    size_t steps = 0;
+    for (const std::shared_ptr<const CoverageRoute> &route : routes) {
+      length += route->length;
+      repeated += route->repeated_length;
+      unreached += route->unreached_segments;
+      undrivable += undrivable_steps(nyc, *route);
+      steps += route->links.size();
+    }
+    bool fast = plan_ms < 1000.0;
+    failures += fast && routes.size() == roots.size() ? 0 : 1;
+    std::cout << fmt::format(
+        "nyc_roads.json: {} components, {} segments planned in {:.1f} ms{}; "
+        "tours drive {:.0f} units, {:.1f}% of it repeated road; {} "
+        "segments unreached, {} of {} steps not drivable\n",
+        roots.size(), nyc.segments.size(), plan_ms,
+        fast ? "" : " (OVER 1 s)", length,
+        100.0 * repeated / std::max(length, 1.0), unreached, undrivable,
+        steps);
+  } else {
+    std::cout << "nyc_roads.json not found, skipping planner timing\n";
+  }
+
+  constexpr int max_ticks = 20'000;
+  auto race = [&](const std::string &label) {
+    for (size_t car_count : {1, 16}) {
+      auto [wall_most, wall_all] = ticks_to_cover(w, 0, car_count, max_ticks);
+      auto [route_most, route_all] =
+          ticks_to_cover(w, 4, car_count, max_ticks);
+      // The tour should at least finish the map sooner
+      int wall_score = wall_all < 0 ? max_ticks : wall_all;
+      if (route_all < 0 || route_all > wall_score) {
+        failures++;
+      }
+      std::cout << fmt::format(
+          "{}: {:>2} cars, wall follower 95% in {} ticks, 100% in {}; route "
+          "planner 95% in {}, 100% in {}\n",
+          label, car_count, wall_most, wall_all, route_most, route_all);
+    }
+  };
+  race("grid");
+  if (has_nyc) {
+    std::swap(*w.road_network, nyc);
+    race("nyc_roads.json");
+    std::swap(*w.road_network, nyc);
+  }
+  w.shop->maze_algorithm_level = 0;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../systems/DiscoverySystem.h"
+#include "../../systems/HandleCollisions.h"
+#include "../../systems/OfflineProgress.h"
+#include "../../systems/RevealFogOfWar.h"
+#include "../bench_macros.h"
+#include "maze_traversal_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+
+namespace offline_progress_bench {
+
+using maze_traversal_bench::World;
+
+constexpr float CAR_SPEED = 250.0f;
+
+struct Outcome {
+  size_t visited{0};
+  int pixels{0};
+  size_t discovered{0};
+};
+
+// Pooled cars and POI entities, found the same way the game finds them
+inline void spawn_entities(size_t car_count, size_t poi_count) {
+  CarPool &cars = *maze_traversal_bench::world().cars;
+  for (size_t i = 0; i < car_count; ++i) {
+    cars.add({0.0f, 0.0f}, 6.0f, CAR_SPEED, 1);
+  }
+  for (size_t i = 0; i < poi_count; ++i) {
+    afterhours::Entity &poi = afterhours::EntityHelper::createEntity();
+    poi.addComponent<PointOfInterest>(vec2{0.0f, 0.0f}, POIType::Area, 10);
+  }
+  afterhours::EntityHelper::merge_entity_arrays();
+}
+
+// A dark map, every car back on its own seeded segment, every POI hidden
+// again and a fresh wall of bricks of mixed health
+inline void reset(World &w, int level) {
+  maze_traversal_bench::reset_world(w);
+  w.shop->maze_algorithm_level = level;
+  w.shop->pixels_collected = 0;
+  const RoadNetwork &road_network = *w.road_network;
+  ExplorationPool *pool =
+      afterhours::EntityHelper::get_singleton_cmp<ExplorationPool>();
+  // Tours and the shared junction memory start over too, so back to back
+  // runs from here are alike
+  CoverageRouting *routing =
+      afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>();
+  if (routing->planner) {
+    routing->planner->wait_idle();
+    routing->planner->take_finished();
+  }
+  routing->routes.clear();
+  routing->requested.clear();
+  // As in a deterministic run, so a tour lands on the same tick every time
+  // rather than whenever the planner thread gets to it
+  routing->wait_for_plans = true;
+  MazeTraversal::last_segment_index = SIZE_MAX;
+  MazeTraversal::second_last_segment_index = SIZE_MAX;
+  std::mt19937 rng(7);
+  CarPool &cars = *w.cars;
+  for (size_t car = 0; car < cars.size(); ++car) {
+    pool->release(cars.cold[car]);
+    cars.cold[car] = RoadFollowingState(CAR_SPEED);
+    cars.cold[car].current_segment_index =
+        rng() % road_network.segments.size();
+    cars.store(car);
+    cars.position[car] = road_network.segments[cars.segment[car]].start;
+  }
+  // POIs spread evenly over whichever network is loaded
+  size_t poi_index = 0;
+  for (PointOfInterest &poi : afterhours::EntityQuery()
+                                  .whereHasComponent<PointOfInterest>()
+                                  .gen_as<PointOfInterest>()) {
+    const RoadSegment &segment =
+        road_network.segments[(poi_index++ * 7919) %
+                              road_network.segments.size()];
+    poi.position = {(segment.start.x + segment.end.x) * 0.5f,
+                    (segment.start.y + segment.end.y) * 0.5f};
+    poi.is_discovered = false;
+  }
+  BrickGrid &bricks =
+      *afterhours::EntityHelper::get_singleton_cmp<BrickGrid>();
+  for (int grid_y = 0; grid_y < game_constants::GRID_HEIGHT; ++grid_y) {
+    for (int grid_x = 0; grid_x < game_constants::GRID_WIDTH; ++grid_x) {
+      bricks.set_health(grid_x, grid_y,
+                        static_cast<short>(1 + (grid_x * 7 + grid_y) % 15));
+    }
+  }
+  afterhours::EntityHelper::get_singleton_cmp<IsPhotoReveal>()
+      ->revealed_cells.reset();
+}
+
+inline Outcome outcome(const World &w) {
+  Outcome result;
+  result.visited = maze_traversal_bench::visited_count(*w.road_network);
+  result.pixels = w.shop->pixels_collected;
+  for (const PointOfInterest &poi : afterhours::EntityQuery()
+                                        .whereHasComponent<PointOfInterest>()
+                                        .gen_as<PointOfInterest>()) {
+    result.discovered += poi.is_discovered ? 1 : 0;
+  }
+  return result;
+}
+
+// The live game's simulation systems, stepped every fixed tick, calling
+// after_tick() after each
+template <typename Fn>
+inline Outcome run_per_tick(World &w, float seconds, Fn &&after_tick) {
+  MazeTraversal traversal;
+  RevealFogOfWar reveal_fog;
+  DiscoverySystem discovery;
+  HandleCollisions collisions;
+  HandleComponentCompletion completion;
+  afterhours::Entity &network_entity =
+      afterhours::EntityHelper::get_singleton<RoadNetwork>();
+  float dt = game_constants::FIXED_TICK_SECONDS;
+  int ticks = static_cast<int>(std::lround(seconds / dt));
+  for (int tick = 0; tick < ticks; ++tick) {
+    // Pooled cars are driven, revealed around, checked for POIs and chip
+    // at bricks in once()
+    traversal.once(dt);
+    reveal_fog.once(dt);
+    discovery.once(dt);
+    collisions.once(dt);
+    completion.for_each_with(network_entity, *w.road_network, dt);
+    after_tick();
+  }
+  return outcome(w);
+}
+
+inline Outcome run_per_tick(World &w, float seconds) {
+  return run_per_tick(w, seconds, []() {});
+}
+
+inline bool within(double caught_up, double per_tick, double tolerance) {
+  return std::abs(caught_up - per_tick) <=
+         tolerance * std::max(per_tick, 1.0);
+}
+
+} // namespace offline_progress_bench
+
+// Checks a catch-up over a short gap lands within 1% of stepping every tick
+// on segments visited and within 5% on pixels earned, bricks included,
+// then times catching up eight hours. NYC, the map the game ships, must
+// take under a second; the grid is sixteen times its size and only reports.
+BENCHMARK(offline_catch_up) {
+  using namespace offline_progress_bench;
+  World &w = maze_traversal_bench::world();
+  int failures = 0;
+
+  std::filesystem::path nyc_roads_path =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  RoadNetwork nyc;
+  bool has_nyc = load_road_network_from_json(nyc, nyc_roads_path);
+  if (has_nyc) {
+    nyc.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+    nyc.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+    nyc.completed_components.reserve(nyc.component_count());
+  }
+
+  constexpr size_t car_count = 8;
+  constexpr float gap_seconds = 120.0f;
+  constexpr float offline_seconds = 8.0f * 60.0f * 60.0f;
+  spawn_entities(car_count, 100);
+
+  auto compare = [&](const std::string &label, bool must_be_fast) {
+    for (int level : {0, 4}) {
+      reset(w, level);
+      auto start = std::chrono::steady_clock::now();
+      Outcome per_tick = run_per_tick(w, gap_seconds);
+      double per_tick_ms = bench_elapsed_ms(start);
+
+      reset(w, level);
+      start = std::chrono::steady_clock::now();
+      OfflineProgress::catch_up(gap_seconds);
+      double caught_up_ms = bench_elapsed_ms(start);
+      Outcome caught_up = outcome(w);
+
+      bool faithful = within(caught_up.visited, per_tick.visited, 0.01) &&
+                      within(caught_up.pixels, per_tick.pixels, 0.05);
+      failures += faithful ? 0 : 1;
+      std::cout << fmt::format(
+          "{} level {}: {:.0f} s per tick {} segments, {} pixels, {} POIs "
+          "in {:.0f} ms; caught up {} segments, {} pixels, {} POIs in "
+          "{:.1f} ms{}\n",
+          label, level, gap_seconds, per_tick.visited, per_tick.pixels,
+          per_tick.discovered, per_tick_ms, caught_up.visited,
+          caught_up.pixels, caught_up.discovered, caught_up_ms,
+          faithful ? "" : " (TOO FAR OFF)");
+
+      reset(w, level);
+      start = std::chrono::steady_clock::now();
+      OfflineProgress::Report report =
+          OfflineProgress::catch_up(offline_seconds);
+      double offline_ms = bench_elapsed_ms(start);
+      bool fast = offline_ms < 1000.0;
+      failures += fast || !must_be_fast ? 0 : 1;
+      std::cout << fmt::format(
+          "{} level {}: 8 h caught up in {:.0f} ms{} ({} steps, {:.0f} s "
+          "driven, {} of {} segments, {} pixels)\n",
+          label, level, offline_ms, fast ? "" : " (OVER 1 s)", report.steps,
+          report.simulated_seconds, report.segments_visited,
+          w.road_network->segments.size(), report.pixels_earned);
+    }
+  };
+  compare("grid", false);
+  if (has_nyc) {
+    std::swap(*w.road_network, nyc);
+    compare("nyc_roads.json", true);
+    std::swap(*w.road_network, nyc);
+  } else {
+    std::cout << "nyc_roads.json not found, skipping NYC\n";
+  }
+  w.shop->maze_algorithm_level = 0;
+  w.cars->clear();
+  afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>()
+      ->wait_for_plans = false;
+  return failures == 0 ? 0 : 1;
+}
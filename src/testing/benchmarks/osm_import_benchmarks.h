@@ -0,0 +1,269 @@
+#pragma once
+
+#include "../../osm_import.h"
+#include "../../rl.h"
+#include "../bench_macros.h"
+#include "road_cache_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+#include <thread>
+
+namespace osm_import_bench {
+
+// Just enough protobuf encoding to write a synthetic extract
+struct PbfWriter {
+  std::string out;
+
+  void varint(uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+  }
+  void svarint(int64_t value) {
+    varint((static_cast<uint64_t>(value) << 1) ^
+           static_cast<uint64_t>(value >> 63));
+  }
+  void key(uint32_t field, uint32_t wire_type) {
+    varint((static_cast<uint64_t>(field) << 3) | wire_type);
+  }
+  void varint_field(uint32_t field, uint64_t value) {
+    key(field, 0);
+    varint(value);
+  }
+  void bytes_field(uint32_t field, std::string_view bytes) {
+    key(field, 2);
+    varint(bytes.size());
+    out.append(bytes);
+  }
+};
+
+inline uint32_t adler32(std::string_view data) {
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (char c : data) {
+    a = (a + static_cast<uint8_t>(c)) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+inline void write_blob(std::ofstream &file, std::string_view type,
+                       std::string_view raw) {
+  int deflated_size = 0;
+  unsigned char *deflated = raylib::CompressData(
+      reinterpret_cast<const unsigned char *>(raw.data()),
+      static_cast<int>(raw.size()), &deflated_size);
+  std::string zlib_data = "\x78\x01";
+  zlib_data.append(reinterpret_cast<const char *>(deflated),
+                   static_cast<size_t>(deflated_size));
+  raylib::MemFree(deflated);
+  uint32_t checksum = adler32(raw);
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    zlib_data.push_back(static_cast<char>((checksum >> shift) & 0xff));
+  }
+
+  PbfWriter blob;
+  blob.varint_field(2, raw.size());
+  blob.bytes_field(3, zlib_data);
+
+  PbfWriter header;
+  header.bytes_field(1, type);
+  header.varint_field(3, blob.out.size());
+
+  uint32_t header_size = static_cast<uint32_t>(header.out.size());
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    file.put(static_cast<char>((header_size >> shift) & 0xff));
+  }
+  file.write(header.out.data(),
+             static_cast<std::streamsize>(header.out.size()));
+  file.write(blob.out.data(), static_cast<std::streamsize>(blob.out.size()));
+}
+
+// side x side lattice of nodes 0.0001 degrees apart, joined by one
+// residential way per row and column. Every tenth row gets a parallel
+// footway that the drive filter has to drop.
+struct SyntheticExtract {
+  size_t side{0};
+  double origin_lat{40.70};
+  double origin_lon{-74.02};
+  double step{0.0001};
+
+  size_t expected_segments() const { return 2 * side * (side - 1); }
+  int64_t node_id(size_t x, size_t y) const {
+    return static_cast<int64_t>(y * side + x + 1);
+  }
+  int64_t to_units(double degrees) const {
+    return static_cast<int64_t>(std::llround(degrees * 1e7));
+  }
+
+  void write(const std::filesystem::path &path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    PbfWriter header;
+    header.bytes_field(4, "OsmSchema-V0.6");
+    header.bytes_field(4, "DenseNodes");
+    write_blob(file, "OSMHeader", header.out);
+
+    size_t node_count = side * side;
+    for (size_t first = 0; first < node_count; first += 8000) {
+      size_t last = std::min(node_count, first + 8000);
+      PbfWriter ids, lats, lons;
+      int64_t prev_id = 0, prev_lat = 0, prev_lon = 0;
+      for (size_t n = first; n < last; ++n) {
+        int64_t id = static_cast<int64_t>(n + 1);
+        int64_t lat = to_units(origin_lat + static_cast<double>(n / side) * step);
+        int64_t lon = to_units(origin_lon + static_cast<double>(n % side) * step);
+        ids.svarint(id - prev_id);
+        lats.svarint(lat - prev_lat);
+        lons.svarint(lon - prev_lon);
+        prev_id = id;
+        prev_lat = lat;
+        prev_lon = lon;
+      }
+      PbfWriter dense;
+      dense.bytes_field(1, ids.out);
+      dense.bytes_field(8, lats.out);
+      dense.bytes_field(9, lons.out);
+      PbfWriter group;
+      group.bytes_field(2, dense.out);
+      PbfWriter block;
+      block.bytes_field(1, PbfWriter{}.out);
+      block.bytes_field(2, group.out);
+      write_blob(file, "OSMData", block.out);
+    }
+
+    // String table: 0 is always empty
+    PbfWriter strings;
+    for (std::string_view s : {"", "highway", "residential", "footway"}) {
+      strings.bytes_field(1, s);
+    }
+
+    PbfWriter group;
+    size_t ways_in_group = 0;
+    int64_t way_id = 1;
+    auto flush = [&]() {
+      if (ways_in_group == 0) {
+        return;
+      }
+      PbfWriter block;
+      block.bytes_field(1, strings.out);
+      block.bytes_field(2, group.out);
+      write_blob(file, "OSMData", block.out);
+      group.out.clear();
+      ways_in_group = 0;
+    };
+    auto add_way = [&](uint64_t highway_value, auto &&node_at) {
+      PbfWriter keys, values, refs;
+      keys.varint(1);
+      values.varint(highway_value);
+      int64_t prev = 0;
+      for (size_t i = 0; i < side; ++i) {
+        int64_t id = node_at(i);
+        refs.svarint(id - prev);
+        prev = id;
+      }
+      PbfWriter way;
+      way.varint_field(1, static_cast<uint64_t>(way_id++));
+      way.bytes_field(2, keys.out);
+      way.bytes_field(3, values.out);
+      way.bytes_field(8, refs.out);
+      group.bytes_field(3, way.out);
+      if (++ways_in_group == 2000) {
+        flush();
+      }
+    };
+    for (size_t row = 0; row < side; ++row) {
+      add_way(2, [&](size_t i) { return node_id(i, row); });
+      if (row % 10 == 0) {
+        add_way(3, [&](size_t i) { return node_id(i, row); });
+      }
+    }
+    for (size_t column = 0; column < side; ++column) {
+      add_way(2, [&](size_t i) { return node_id(column, i); });
+    }
+    flush();
+  }
+};
+
+struct ImportRun {
+  double ms{0.0};
+  bool ok{false};
+  OsmImportStats stats;
+  RoadNetwork road_network;
+};
+
+inline ImportRun run_import(const std::filesystem::path &path,
+                            unsigned threads) {
+  ImportRun run;
+  OsmImportOptions options;
+  options.thread_count = threads;
+  auto start = std::chrono::steady_clock::now();
+  run.ok = import_osm_pbf(run.road_network, path, options, &run.stats);
+  run.ms = bench_elapsed_ms(start);
+  return run;
+}
+
+} // namespace osm_import_bench
+
+BENCHMARK(osm_import) {
+  using namespace osm_import_bench;
+
+  std::filesystem::path work_dir =
+      std::filesystem::temp_directory_path() / "break_ross_osm_import_bench";
+  std::filesystem::create_directories(work_dir);
+  int failures = 0;
+
+  // At least four threads so the parallel path runs even on small machines
+  unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+  for (size_t side : {50u, 708u}) {
+    SyntheticExtract extract;
+    extract.side = side;
+    std::filesystem::path pbf = work_dir / fmt::format("grid_{}.osm.pbf", side);
+    extract.write(pbf);
+
+    ImportRun single = run_import(pbf, 1);
+    ImportRun parallel = run_import(pbf, threads);
+    if (!single.ok || !parallel.ok) {
+      std::cout << fmt::format("grid {}: import failed\n", side);
+      failures++;
+      continue;
+    }
+
+    // First segment runs from the south west corner one step east
+    GeoBounds bounds = single.stats.bounds;
+    vec2 expected_start = lat_lon_to_game_coords(
+        extract.origin_lat, extract.origin_lon, bounds);
+    const RoadSegment &first = single.road_network.segments[0];
+    bool geometry_ok =
+        std::abs(first.start.x - expected_start.x) < 0.01f &&
+        std::abs(first.start.y - expected_start.y) < 0.01f &&
+        std::abs(bounds.max_lat - (extract.origin_lat +
+                                   static_cast<double>(side - 1) *
+                                       extract.step)) < 1e-6;
+    bool count_ok =
+        single.road_network.segments.size() == extract.expected_segments();
+    bool same = road_cache_bench::same_bytes(single.road_network.segments,
+                                             parallel.road_network.segments);
+
+    std::cout << fmt::format(
+        "grid {0}x{0}: {1:.0f} KB pbf, {2} blocks, {3} ways, {4} nodes\n"
+        "  {5} segments (expected {6}), 1 thread {7:.0f} ms, {8} threads "
+        "{9:.0f} ms\n  {10}, {11}\n",
+        side,
+        static_cast<double>(std::filesystem::file_size(pbf)) /
+            1024.0,
+        single.stats.blocks, single.stats.ways, single.stats.nodes,
+        single.road_network.segments.size(), extract.expected_segments(),
+        single.ms, threads, parallel.ms,
+        geometry_ok ? "projection matches" : "PROJECTION MISMATCH",
+        same ? "thread count does not change output"
+             : "THREADED OUTPUT DIFFERS");
+    failures += (count_ok && geometry_ok && same) ? 0 : 1;
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(work_dir, ec);
+  return failures == 0 ? 0 : 1;
+}
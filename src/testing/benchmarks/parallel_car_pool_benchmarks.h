@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../sim_random.h"
+#include "../../systems/TrackSimulationChecksum.h"
+#include "../bench_macros.h"
+#include "car_pool_benchmarks.h"
+#include "offline_progress_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+#include <thread>
+
+namespace parallel_car_pool_bench {
+
+using maze_traversal_bench::World;
+
+// Serial for 1 lane, otherwise a fresh pool of that many
+inline void use_lanes(World &w, unsigned lanes) {
+  if (lanes <= 1) {
+    w.workers->pool.reset();
+  } else {
+    w.workers->start(lanes);
+  }
+}
+
+} // namespace parallel_car_pool_bench
+
+// Drives a seeded fleet large enough to go parallel from a dark map and
+// fails unless the state checksum on every tick matches the serial run,
+// for the wall follower, A* and the route planner, on 2 and 4 lanes. Then
+// times 100k cars on each lane count up to the machine's cores; how well
+// that scales is only reported, since it depends on the machine.
+BENCHMARK(parallel_car_pool) {
+  using namespace parallel_car_pool_bench;
+  World &w = maze_traversal_bench::world();
+  offline_progress_bench::spawn_entities(4000, 100);
+  afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>()
+      ->wait_for_plans = true;
+  afterhours::Entity &entity = afterhours::EntityHelper::createEntity();
+  SimulationChecksum &checksum =
+      maze_traversal_bench::add_singleton<SimulationChecksum>(entity);
+  TrackSimulationChecksum tracker;
+
+  constexpr float seconds = 10.0f;
+  auto record = [&](int level, unsigned lanes) {
+    use_lanes(w, lanes);
+    SimRandom::seed(42);
+    offline_progress_bench::reset(w, level);
+    checksum.tick = 0;
+    std::vector<uint64_t> sums;
+    offline_progress_bench::run_per_tick(w, seconds, [&]() {
+      tracker.for_each_with(entity, checksum,
+                            game_constants::FIXED_TICK_SECONDS);
+      sums.push_back(checksum.value);
+    });
+    return sums;
+  };
+
+  int failures = 0;
+  for (int level : {0, 3, 4}) {
+    std::vector<uint64_t> serial = record(level, 1);
+    for (unsigned lanes : {2u, 4u}) {
+      std::vector<uint64_t> parallel = record(level, lanes);
+      auto [at, _] = std::mismatch(serial.begin(), serial.end(),
+                                   parallel.begin(), parallel.end());
+      bool identical = at == serial.end() && parallel.size() == serial.size();
+      failures += identical ? 0 : 1;
+      std::cout << fmt::format(
+          "level {}: {} cars over {} ticks on {} lanes {}\n", level,
+          w.cars->size(), serial.size(), lanes,
+          identical ? "match serial"
+                    : fmt::format("DIVERGE at tick {}",
+                                  at - serial.begin() + 1));
+    }
+  }
+
+  car_pool_bench::release_slots(*w.cars);
+
+  // The fleet from car_pool_100k, timed once the map is lit
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  constexpr float dt = 1.0f / 60.0f;
+  constexpr int ticks = 120;
+  MazeTraversal traversal;
+  RevealFogOfWar reveal_fog;
+  DiscoverySystem discovery;
+  double serial_ms = 0.0;
+  for (unsigned lanes = 1; lanes <= std::max(cores, 2u); lanes *= 2) {
+    use_lanes(w, lanes);
+    car_pool_bench::reset(w, 0);
+    car_pool_bench::place(w, 100'000);
+    for (int i = 0; i < 60; ++i) {
+      traversal.once(dt);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) {
+      traversal.once(dt);
+      reveal_fog.once(dt);
+      discovery.once(dt);
+    }
+    double mean_ms = bench_elapsed_ms(start) / ticks;
+    serial_ms = lanes == 1 ? mean_ms : serial_ms;
+    std::cout << fmt::format(
+        "100000 cars on {} lane{}: {:.2f} ms a tick ({:.2f}x serial, {} "
+        "core{} here)\n",
+        lanes, lanes == 1 ? "" : "s", mean_ms, serial_ms / mean_ms, cores,
+        cores == 1 ? "" : "s");
+    car_pool_bench::release_slots(*w.cars);
+  }
+
+  use_lanes(w, 1);
+  w.shop->maze_algorithm_level = 0;
+  w.cars->clear();
+  return failures == 0 ? 0 : 1;
+}
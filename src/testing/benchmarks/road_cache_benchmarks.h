@@ -0,0 +1,278 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../game_setup.h"
+#include "../../road_cache.h"
+#include "../bench_macros.h"
+#include "road_network_benchmarks.h"
+#include <afterhours/src/plugins/files.h>
+#include <cstring>
+#include <functional>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+
+namespace road_cache_bench {
+
+template <typename T>
+inline bool same_bytes(const MappedArray<T> &a, const MappedArray<T> &b) {
+  return a.size() == b.size() &&
+         (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) ==
+                           0);
+}
+
+inline bool same_network(const RoadNetwork &a, const RoadNetwork &b) {
+  return same_bytes(a.segments, b.segments) &&
+         same_bytes(a.graph.port_offsets, b.graph.port_offsets) &&
+         same_bytes(a.graph.links, b.graph.links) &&
+         same_bytes(a.graph.port_node, b.graph.port_node) &&
+         same_bytes(a.graph.nodes, b.graph.nodes) &&
+         same_bytes(a.graph.node_ports, b.graph.node_ports) &&
+         same_bytes(a.components.parent, b.components.parent) &&
+         same_bytes(a.components.next_member, b.components.next_member) &&
+         same_bytes(a.components.size, b.components.size) &&
+         a.components.count() == b.components.count() &&
+         same_bytes(a.chunks.segment_offsets, b.chunks.segment_offsets) &&
+         same_bytes(a.chunks.bounds, b.chunks.bounds) &&
+         same_bytes(a.chains.pass_through, b.chains.pass_through) &&
+         same_bytes(a.chains.chain_offsets, b.chains.chain_offsets) &&
+         same_bytes(a.chains.chain_links, b.chains.chain_links) &&
+         same_bytes(a.chains.segment_chain, b.chains.segment_chain) &&
+         same_bytes(a.turns.offsets, b.turns.offsets) &&
+         same_bytes(a.turns.turns, b.turns.turns);
+}
+
+// Same layout as resources/nyc_roads.json, without the indentation
+inline void write_network_json(const RoadNetwork &road_network,
+                               const std::filesystem::path &path) {
+  std::ofstream out(path, std::ios::trunc);
+  out << "{\"segments\":[";
+  for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    const RoadSegment &seg = road_network.segments[i];
+    out << fmt::format("{}{{\"start\":{{\"x\":{},\"y\":{}}},\"end\":{{\"x\":{},"
+                       "\"y\":{}}},\"width\":{}}}",
+                       i == 0 ? "" : ",", seg.start.x, seg.start.y, seg.end.x,
+                       seg.end.y, seg.width);
+  }
+  out << "]}\n";
+}
+
+struct ColdStart {
+  size_t segments{0};
+  double json_ms{0.0};
+  double build_ms{0.0};
+  double write_ms{0.0};
+  double first_map_ms{0.0};
+  double best_map_ms{0.0};
+  // The frontier field is left out of the load and built on first use
+  double frontier_ms{0.0};
+  bool matches{false};
+};
+
+inline bool measure(const std::filesystem::path &json_path,
+                    const std::filesystem::path &cache_path,
+                    ColdStart &result) {
+  constexpr float tolerance = road_network_bench::CONNECTION_TOLERANCE;
+  std::error_code ec;
+  std::filesystem::remove(cache_path, ec);
+
+  RoadNetwork built;
+  auto start = std::chrono::steady_clock::now();
+  if (!load_road_network_from_json(built, json_path)) {
+    return false;
+  }
+  result.json_ms = bench_elapsed_ms(start);
+  result.segments = built.segments.size();
+
+  start = std::chrono::steady_clock::now();
+  built.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+  built.build_connected_components(tolerance);
+  result.build_ms = bench_elapsed_ms(start);
+
+  start = std::chrono::steady_clock::now();
+  if (!road_cache::write(built, cache_path, json_path, tolerance)) {
+    return false;
+  }
+  result.write_ms = bench_elapsed_ms(start);
+
+  result.best_map_ms = std::numeric_limits<double>::max();
+  for (int run = 0; run < 5; ++run) {
+    RoadNetwork mapped;
+    start = std::chrono::steady_clock::now();
+    if (!road_cache::load(mapped, cache_path, json_path, tolerance)) {
+      return false;
+    }
+    double elapsed = bench_elapsed_ms(start);
+    if (run == 0) {
+      result.first_map_ms = elapsed;
+      result.matches = same_network(built, mapped);
+      start = std::chrono::steady_clock::now();
+      mapped.step_toward_frontier(0, false);
+      result.frontier_ms = bench_elapsed_ms(start);
+    }
+    result.best_map_ms = std::min(result.best_map_ms, elapsed);
+  }
+  return true;
+}
+
+inline void print(const std::string &name, const ColdStart &result) {
+  double parse_and_build = result.json_ms + result.build_ms;
+  std::cout << fmt::format(
+      "{}: {} segments\n"
+      "  json {:.1f} ms + build {:.1f} ms, cache write {:.1f} ms\n"
+      "  mapped load {:.3f} ms first, {:.3f} ms best ({:.0f}x faster), {}\n"
+      "  frontier field on first use {:.1f} ms, {:.1f} ms with the load\n",
+      name, result.segments, result.json_ms, result.build_ms, result.write_ms,
+      result.first_map_ms, result.best_map_ms,
+      parse_and_build / std::max(result.best_map_ms, 0.001),
+      result.matches ? "contents match" : "CONTENTS DIFFER",
+      result.frontier_ms, result.first_map_ms + result.frontier_ms);
+}
+
+// Writes a small network with one value broken but every size intact, and
+// reports whether load() still accepted it
+template <typename Corrupt>
+inline bool accepts_corrupt(const std::filesystem::path &json_path,
+                            const std::filesystem::path &cache_path,
+                            Corrupt &&corrupt) {
+  constexpr float tolerance = road_network_bench::CONNECTION_TOLERANCE;
+  RoadNetwork network;
+  road_network_bench::make_synthetic_grid(network, 10'000);
+  network.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+  network.build_connected_components(tolerance);
+  corrupt(network);
+  if (!road_cache::write(network, cache_path, json_path, tolerance)) {
+    return true;
+  }
+  RoadNetwork loaded;
+  return road_cache::load(loaded, cache_path, json_path, tolerance);
+}
+
+} // namespace road_cache_bench
+
+BENCHMARK(road_cache) {
+  using namespace road_cache_bench;
+  constexpr float tolerance = road_network_bench::CONNECTION_TOLERANCE;
+
+  std::filesystem::path work_dir =
+      std::filesystem::temp_directory_path() / "break_ross_road_cache_bench";
+  std::filesystem::create_directories(work_dir);
+  int failures = 0;
+
+  std::filesystem::path nyc_json =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  ColdStart nyc;
+  if (measure(nyc_json, work_dir / "nyc_roads.roads", nyc)) {
+    print("nyc_roads.json", nyc);
+    failures += nyc.matches ? 0 : 1;
+  } else {
+    std::cout << "nyc_roads.json not found, skipping\n";
+  }
+
+  RoadNetwork synthetic;
+  road_network_bench::make_synthetic_grid(synthetic, 1'000'000);
+  std::filesystem::path synthetic_json = work_dir / "synthetic.json";
+  std::filesystem::path synthetic_cache = work_dir / "synthetic.roads";
+  write_network_json(synthetic, synthetic_json);
+  ColdStart large;
+  if (measure(synthetic_json, synthetic_cache, large)) {
+    print("synthetic grid", large);
+    failures += large.matches ? 0 : 1;
+  } else {
+    std::cout << "synthetic grid: cache round trip failed\n";
+    failures++;
+  }
+
+  // Right sizes, wrong values: each must be rejected, never indexed
+  std::vector<std::pair<std::string, std::function<void(RoadNetwork &)>>>
+      corruptions = {
+          {"link past the last port",
+           [](RoadNetwork &n) {
+             n.graph.links[0] = static_cast<uint32_t>(n.segments.size() * 2);
+           }},
+          {"port on a missing node",
+           [](RoadNetwork &n) {
+             n.graph.port_node[0] = static_cast<uint32_t>(n.graph.nodes.size());
+           }},
+          {"node ports past the end",
+           [](RoadNetwork &n) {
+             n.graph.nodes[0].port_count =
+                 static_cast<uint32_t>(n.graph.node_ports.size() + 1);
+           }},
+          {"component parent cycle",
+           [](RoadNetwork &n) {
+             n.components.parent[0] = 1;
+             n.components.parent[1] = 0;
+           }},
+          {"chain link past the last port",
+           [](RoadNetwork &n) {
+             n.chains.chain_links[0] =
+                 static_cast<uint32_t>(n.segments.size() * 2);
+           }},
+          {"turn onto a missing port",
+           [](RoadNetwork &n) {
+             n.turns.turns[0].link =
+                 static_cast<uint32_t>(n.segments.size() * 2);
+           }},
+          {"chunk offsets out of order",
+           [](RoadNetwork &n) {
+             n.chunks.segment_offsets[1] =
+                 static_cast<uint32_t>(n.segments.size() + 1);
+           }},
+      };
+  for (const auto &[label, corrupt] : corruptions) {
+    bool accepted =
+        accepts_corrupt(synthetic_json, work_dir / "corrupt.roads", corrupt);
+    std::cout << fmt::format("  corrupt cache, {}: {}\n", label,
+                             accepted ? "ACCEPTED" : "rejected");
+    failures += accepted ? 1 : 0;
+  }
+
+  // A new timestamp on identical contents still matches the source hash
+  std::filesystem::last_write_time(
+      synthetic_json,
+      std::filesystem::last_write_time(synthetic_json) + std::chrono::hours(1));
+  RoadNetwork touched;
+  auto start = std::chrono::steady_clock::now();
+  bool touched_loaded =
+      road_cache::load(touched, synthetic_cache, synthetic_json, tolerance);
+  std::cout << fmt::format("  touched source: {} in {:.1f} ms\n",
+                           touched_loaded ? "reused" : "REBUILT",
+                           bench_elapsed_ms(start));
+  failures += touched_loaded ? 0 : 1;
+
+  // A same-size edit that keeps the old timestamp is caught by the hash
+  std::filesystem::file_time_type stamp =
+      std::filesystem::last_write_time(synthetic_json);
+  {
+    std::fstream flip(synthetic_json,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    char first = 0;
+    flip.get(first);
+    flip.seekp(0);
+    flip.put(first == ' ' ? '\n' : ' ');
+  }
+  std::filesystem::last_write_time(synthetic_json, stamp);
+  RoadNetwork flipped;
+  bool flipped_loaded =
+      road_cache::load(flipped, synthetic_cache, synthetic_json, tolerance);
+  std::cout << fmt::format("  same-size edit, same timestamp: {}\n",
+                           flipped_loaded ? "STALE CACHE USED" : "rejected");
+  failures += flipped_loaded ? 1 : 0;
+
+  // Any content change has to invalidate the cache
+  {
+    std::ofstream append(synthetic_json, std::ios::app);
+    append << " ";
+  }
+  RoadNetwork edited;
+  bool edited_loaded =
+      road_cache::load(edited, synthetic_cache, synthetic_json, tolerance);
+  std::cout << fmt::format("  edited source: {}\n",
+                           edited_loaded ? "STALE CACHE USED" : "rejected");
+  failures += edited_loaded ? 1 : 0;
+
+  std::error_code ec;
+  std::filesystem::remove_all(work_dir, ec);
+  return failures == 0 ? 0 : 1;
+}
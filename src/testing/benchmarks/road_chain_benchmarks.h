@@ -0,0 +1,155 @@
+#pragma once
+
+#include "../../components.h"
+#include "../bench_macros.h"
+#include "road_network_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+
+namespace road_chain_bench {
+
+// Grid whose every block edge is split into `pieces` collinear segments,
+// the shape OSM polylines arrive in
+inline void make_subdivided_grid(RoadNetwork &road_network, size_t side,
+                                 size_t pieces) {
+  road_network.segments.clear();
+  float spacing = 160.0f;
+  float step = spacing / static_cast<float>(pieces);
+  for (size_t y = 0; y < side; ++y) {
+    for (size_t x = 0; x + 1 < side; ++x) {
+      for (size_t p = 0; p < pieces; ++p) {
+        float along = x * spacing + p * step;
+        RoadSegment horizontal;
+        horizontal.start = {along, y * spacing};
+        horizontal.end = {along + step, y * spacing};
+        road_network.segments.push_back(horizontal);
+
+        RoadSegment vertical;
+        vertical.start = {y * spacing, along};
+        vertical.end = {y * spacing, along + step};
+        road_network.segments.push_back(vertical);
+      }
+    }
+  }
+  road_network.visited_segments.assign(road_network.segments.size(), false);
+  road_network.is_loaded = true;
+}
+
+// Every segment sits in exactly one chain, consecutive links really are
+// joined, and pass-through ports only ever point at each other
+inline bool chains_consistent(const RoadNetwork &road_network) {
+  const RoadGraph &graph = road_network.graph;
+  const RoadChains &chains = road_network.chains;
+  std::vector<int> seen(graph.segment_count(), 0);
+  for (size_t c = 0; c < chains.chain_count(); ++c) {
+    std::span<const uint32_t> links = chains.chain(c);
+    for (size_t i = 0; i < links.size(); ++i) {
+      size_t seg = RoadGraph::link_segment(links[i]);
+      seen[seg]++;
+      if (chains.chain_of(seg) != c) {
+        return false;
+      }
+      if (i + 1 < links.size() &&
+          chains.continue_link(links[i] ^ 1u) != links[i + 1]) {
+        return false;
+      }
+    }
+  }
+  for (size_t port = 0; port < chains.pass_through.size(); ++port) {
+    uint32_t link = chains.pass_through[port];
+    if (link != RoadChains::INVALID && chains.pass_through[link] != port) {
+      return false;
+    }
+  }
+  return std::all_of(seen.begin(), seen.end(),
+                     [](int count) { return count == 1; });
+}
+
+struct Drive {
+  size_t transitions{0};
+  size_t decisions{0};
+  double ms{0.0};
+};
+
+// Random walk standing in for a car: every segment end is a junction
+// decision unless the chain says there is only one way on
+inline Drive drive(const RoadNetwork &road_network, size_t transitions,
+                   bool use_chains) {
+  const RoadGraph &graph = road_network.graph;
+  std::mt19937 rng(99);
+  Drive result;
+  uint32_t link = RoadGraph::make_link(0, false);
+  auto start = std::chrono::steady_clock::now();
+  for (; result.transitions < transitions; ++result.transitions) {
+    uint32_t exit_port = link ^ 1u;
+    if (use_chains) {
+      uint32_t next = road_network.chains.continue_link(exit_port);
+      if (next != RoadChains::INVALID) {
+        link = next;
+        continue;
+      }
+    }
+    result.decisions++;
+    std::span<const uint32_t> links = graph.port_links(exit_port);
+    if (links.empty()) {
+      link = RoadGraph::make_link(rng() % graph.segment_count(), false);
+      continue;
+    }
+    link = links[rng() % links.size()];
+  }
+  result.ms = bench_elapsed_ms(start);
+  return result;
+}
+
+inline int report(const std::string &label, const RoadNetwork &road_network) {
+  constexpr size_t transitions = 2'000'000;
+  Drive plain = drive(road_network, transitions, false);
+  Drive chained = drive(road_network, transitions, true);
+  bool consistent = chains_consistent(road_network);
+  std::cout << fmt::format(
+      "{}: {} segments -> {} chains ({:.1f} segments each, {:.1f} KB)\n"
+      "  junction decisions per {} segment ends: {} -> {} ({:.1f}x fewer), "
+      "chains {}\n",
+      label, road_network.segments.size(), road_network.chains.chain_count(),
+      static_cast<double>(road_network.segments.size()) /
+          static_cast<double>(std::max<size_t>(
+              road_network.chains.chain_count(), 1)),
+      road_network.chains.memory_bytes() / 1024.0, transitions,
+      plain.decisions, chained.decisions,
+      static_cast<double>(plain.decisions) /
+          static_cast<double>(std::max<size_t>(chained.decisions, 1)),
+      consistent ? "consistent" : "INCONSISTENT");
+  return consistent ? 0 : 1;
+}
+
+} // namespace road_chain_bench
+
+BENCHMARK(road_chains) {
+  using namespace road_chain_bench;
+  int failures = 0;
+
+  std::filesystem::path nyc_roads_path =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  RoadNetwork nyc;
+  if (load_road_network_from_json(nyc, nyc_roads_path)) {
+    nyc.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+    failures += report("nyc_roads.json", nyc);
+  } else {
+    std::cout << "nyc_roads.json not found, skipping\n";
+  }
+
+  RoadNetwork subdivided;
+  make_subdivided_grid(subdivided, 120, 8);
+  auto start = std::chrono::steady_clock::now();
+  subdivided.build_connected_components(
+      road_network_bench::CONNECTION_TOLERANCE);
+  double build_ms = bench_elapsed_ms(start);
+  start = std::chrono::steady_clock::now();
+  subdivided.chains.build(subdivided.graph);
+  double chain_ms = bench_elapsed_ms(start);
+  std::cout << fmt::format("grid, 8 pieces per block: graph {:.1f} ms, "
+                           "chains {:.1f} ms\n",
+                           build_ms, chain_ms);
+  failures += report("grid, 8 pieces per block", subdivided);
+  return failures == 0 ? 0 : 1;
+}
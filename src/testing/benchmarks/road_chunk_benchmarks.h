@@ -0,0 +1,341 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../road_cache.h"
+#include "../../road_streamer.h"
+#include "../bench_macros.h"
+#include "road_network_benchmarks.h"
+#include <charconv>
+#include <cstdio>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+
+namespace road_chunk_bench {
+
+// Game viewport at the default zoom of 0.75
+constexpr float VIEW_HALF_WIDTH = 640.0f / 0.75f;
+constexpr float VIEW_HALF_HEIGHT = 360.0f / 0.75f;
+
+inline double mb(size_t bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// Current resident set, or 0 where /proc is not available
+// Resident bytes of the cache mapping alone, summed over its regions in
+// /proc/self/smaps, so memory the load allocates for itself doesn't count
+inline size_t mapped_rss_bytes(const MappedFile &file) {
+  std::ifstream smaps("/proc/self/smaps");
+  uintptr_t first = reinterpret_cast<uintptr_t>(file.data());
+  uintptr_t last = first + file.size();
+  bool inside = false;
+  size_t bytes = 0;
+  std::string line;
+  while (std::getline(smaps, line)) {
+    uintptr_t start = 0;
+    size_t dash = line.find('-');
+    if (dash != std::string::npos &&
+        std::from_chars(line.data(), line.data() + dash, start, 16).ec ==
+            std::errc()) {
+      inside = start >= first && start < last;
+      continue;
+    }
+    size_t kb = 0;
+    if (inside && line.rfind("Rss:", 0) == 0 &&
+        std::sscanf(line.c_str(), "Rss: %zu kB", &kb) == 1) {
+      bytes += kb * 1024;
+    }
+  }
+  return bytes;
+}
+
+inline size_t count_misplaced(const RoadNetwork &road_network) {
+  const RoadChunkGrid &chunks = road_network.chunks;
+  size_t misplaced = 0;
+  for (size_t c = 0; c < chunks.chunk_count(); ++c) {
+    for (uint32_t i = chunks.first_segment(c); i < chunks.last_segment(c);
+         ++i) {
+      const RoadSegment &segment = road_network.segments[i];
+      vec2 mid{(segment.start.x + segment.end.x) * 0.5f,
+               (segment.start.y + segment.end.y) * 0.5f};
+      misplaced += chunks.chunk_at(mid) == c ? 0 : 1;
+    }
+  }
+  return misplaced;
+}
+
+// Every segment touching the view, the slow way
+inline size_t count_in_view(const RoadNetwork &road_network, vec2 view_min,
+                            vec2 view_max) {
+  size_t count = 0;
+  for (const RoadSegment &segment : road_network.segments) {
+    bool outside =
+        std::max(segment.start.x, segment.end.x) < view_min.x ||
+        std::min(segment.start.x, segment.end.x) > view_max.x ||
+        std::max(segment.start.y, segment.end.y) < view_min.y ||
+        std::min(segment.start.y, segment.end.y) > view_max.y;
+    count += outside ? 0 : 1;
+  }
+  return count;
+}
+
+// Segments in chunks the culled renderer visits, and how many of those
+// actually touch the view
+inline void count_culled(const RoadNetwork &road_network, vec2 view_min,
+                         vec2 view_max, size_t &visited, size_t &in_view) {
+  visited = 0;
+  in_view = 0;
+  const RoadChunkGrid &chunks = road_network.chunks;
+  chunks.for_each_overlapping(view_min, view_max, [&](uint32_t chunk) {
+    for (uint32_t i = chunks.first_segment(chunk);
+         i < chunks.last_segment(chunk); ++i) {
+      const RoadSegment &segment = road_network.segments[i];
+      visited++;
+      bool outside = std::max(segment.start.x, segment.end.x) < view_min.x ||
+                     std::min(segment.start.x, segment.end.x) > view_max.x ||
+                     std::max(segment.start.y, segment.end.y) < view_min.y ||
+                     std::min(segment.start.y, segment.end.y) > view_max.y;
+      in_view += outside ? 0 : 1;
+    }
+  });
+}
+
+inline std::vector<uint32_t> wanted_around(const RoadChunkGrid &chunks,
+                                           vec2 center) {
+  std::vector<uint32_t> wanted;
+  float margin = chunks.layout.chunk_size;
+  chunks.for_each_overlapping(
+      {center.x - VIEW_HALF_WIDTH - margin,
+       center.y - VIEW_HALF_HEIGHT - margin},
+      {center.x + VIEW_HALF_WIDTH + margin,
+       center.y + VIEW_HALF_HEIGHT + margin},
+      [&](uint32_t chunk) { wanted.push_back(chunk); });
+  return wanted;
+}
+
+inline uint64_t touch_everything(const RoadNetwork &road_network) {
+  uint64_t sum = 0;
+  for (const RoadSegment &segment : road_network.segments) {
+    sum += static_cast<uint64_t>(segment.start.x);
+  }
+  for (uint32_t link : road_network.graph.links) {
+    sum += link;
+  }
+  for (uint32_t node : road_network.graph.port_node) {
+    sum += node;
+  }
+  for (const RoadNode &node : road_network.graph.nodes) {
+    sum += node.port_count;
+  }
+  return sum;
+}
+
+// make_car's nearest-segment scan before the chunk search
+inline size_t legacy_nearest_segment(const RoadNetwork &road_network,
+                                     vec2 position) {
+  size_t nearest_segment = 0;
+  float min_dist_sq = std::numeric_limits<float>::max();
+  for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    float dist_sq =
+        RoadNetwork::distance_sq_to_segment(road_network.segments[i], position);
+    if (dist_sq < min_dist_sq) {
+      min_dist_sq = dist_sq;
+      nearest_segment = i;
+    }
+  }
+  return nearest_segment;
+}
+
+} // namespace road_chunk_bench
+
+// A 20k x 20k synthetic world mapped from the cache, with the streamer
+// following a camera that pans corner to corner
+BENCHMARK(road_chunks) {
+  using namespace road_chunk_bench;
+  constexpr float tolerance = road_network_bench::CONNECTION_TOLERANCE;
+  int failures = 0;
+
+  std::filesystem::path work_dir =
+      std::filesystem::temp_directory_path() / "break_ross_road_chunk_bench";
+  std::filesystem::create_directories(work_dir);
+  std::filesystem::path source_path = work_dir / "source.json";
+  std::filesystem::path cache_path = work_dir / "world.roads";
+  std::ofstream(source_path) << "{}\n";
+
+  {
+    RoadNetwork built;
+    road_network_bench::make_synthetic_grid(built, 2'000'000);
+    auto start = std::chrono::steady_clock::now();
+    built.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+    double chunk_ms = bench_elapsed_ms(start);
+    built.build_connected_components(tolerance);
+    size_t misplaced = count_misplaced(built);
+    const RoadChunkLayout &layout = built.chunks.layout;
+    std::cout << fmt::format(
+        "synthetic world: {} segments, {:.0f} x {:.0f} units\n"
+        "  {} x {} chunks of {:.0f}, sorted in {:.1f} ms, {} misplaced, {} "
+        "components\n",
+        built.segments.size(), layout.columns * layout.chunk_size,
+        layout.rows * layout.chunk_size, layout.columns, layout.rows,
+        layout.chunk_size, chunk_ms, misplaced, built.component_count());
+    failures += misplaced == 0 && built.component_count() == 1 ? 0 : 1;
+    if (!road_cache::write(built, cache_path, source_path, tolerance)) {
+      std::cout << "could not write the cache\n";
+      return 1;
+    }
+  }
+
+  RoadNetwork mapped;
+  if (!road_cache::load(mapped, cache_path, source_path, tolerance)) {
+    std::cout << "could not map the cache\n";
+    return 1;
+  }
+  const MappedFile &file = *mapped.segments.mapping();
+  const RoadChunkGrid &chunks = mapped.chunks;
+  vec2 world_max{chunks.layout.origin.x +
+                     chunks.layout.columns * chunks.layout.chunk_size,
+                 chunks.layout.origin.y +
+                     chunks.layout.rows * chunks.layout.chunk_size};
+
+  // Culling
+  vec2 center{world_max.x * 0.5f, world_max.y * 0.5f};
+  vec2 view_min{center.x - VIEW_HALF_WIDTH, center.y - VIEW_HALF_HEIGHT};
+  vec2 view_max{center.x + VIEW_HALF_WIDTH, center.y + VIEW_HALF_HEIGHT};
+  auto start = std::chrono::steady_clock::now();
+  size_t expected = count_in_view(mapped, view_min, view_max);
+  double all_ms = bench_elapsed_ms(start);
+  size_t visited = 0;
+  size_t in_view = 0;
+  start = std::chrono::steady_clock::now();
+  count_culled(mapped, view_min, view_max, visited, in_view);
+  double culled_ms = bench_elapsed_ms(start);
+  std::cout << fmt::format(
+      "  view culling: {} of {} segments visited ({} on screen), "
+      "{:.3f} ms vs {:.2f} ms for all, {}\n",
+      visited, mapped.segments.size(), in_view, culled_ms, all_ms,
+      in_view == expected ? "nothing missed" : "SEGMENTS MISSED");
+  failures += in_view == expected ? 0 : 1;
+
+  // Streaming
+  uint64_t checksum = touch_everything(mapped);
+  size_t full_bytes = mapped_rss_bytes(file);
+  RoadChunkStreamer streamer;
+  streamer.attach(mapped);
+  size_t max_resident = 0;
+  size_t max_wanted = 0;
+  double max_request_ms = 0.0;
+  uint64_t view_sum = 0;
+  int steps = 40;
+  for (int step = 0; step <= steps; ++step) {
+    float t = static_cast<float>(step) / static_cast<float>(steps);
+    vec2 camera{world_max.x * t, world_max.y * t};
+    std::vector<uint32_t> wanted = wanted_around(chunks, camera);
+    max_wanted = std::max(max_wanted, wanted.size());
+    start = std::chrono::steady_clock::now();
+    streamer.request(wanted);
+    streamer.wait_idle();
+    max_request_ms = std::max(max_request_ms, bench_elapsed_ms(start));
+    // Read the wanted chunks the way rendering and traversal would
+    for (uint32_t chunk : wanted) {
+      for (uint32_t i = chunks.first_segment(chunk);
+           i < chunks.last_segment(chunk); ++i) {
+        view_sum += static_cast<uint64_t>(mapped.segments[i].start.x) +
+                    mapped.graph.next_links(i, false).size();
+      }
+    }
+    max_resident = std::max(max_resident, mapped_rss_bytes(file));
+  }
+  bool same_after = touch_everything(mapped) == checksum;
+  std::cout << fmt::format(
+      "  resident: {:.1f} MB of {:.1f} MB mapped after touching everything\n"
+      "  panning: <= {} of {} chunks wanted, peak {:.1f} MB resident, "
+      "slowest page-in {:.1f} ms, {}\n",
+      mb(full_bytes), mb(file.size()), max_wanted, chunks.chunk_count(),
+      mb(max_resident), max_request_ms,
+      same_after && view_sum > 0 ? "released pages read back intact"
+                                 : "CONTENTS CHANGED");
+  failures += same_after ? 0 : 1;
+  if (full_bytes > 0 && max_resident * 4 > full_bytes) {
+    std::cout << "  RESIDENT MEMORY NOT BOUNDED\n";
+    failures++;
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(work_dir, ec);
+  return failures == 0 ? 0 : 1;
+}
+
+BENCHMARK(nearest_segment) {
+  using namespace road_chunk_bench;
+  int failures = 0;
+
+  RoadNetwork road_network;
+  road_network_bench::make_synthetic_grid(road_network, 1'000'000);
+  road_network.build_chunks(RoadChunkGrid::DEFAULT_CHUNK_SIZE);
+  const RoadChunkLayout &layout = road_network.chunks.layout;
+  float world = std::max(layout.columns, layout.rows) * layout.chunk_size;
+
+  // Mostly on the map, some well off it the way a click or spawn can be
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> coord(-0.1f * world, 1.1f * world);
+  std::vector<vec2> positions(10'000);
+  for (vec2 &position : positions) {
+    position = {coord(rng), coord(rng)};
+  }
+
+  constexpr size_t legacy_queries = 100;
+  std::vector<size_t> legacy(legacy_queries);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < legacy_queries; ++i) {
+    legacy[i] = legacy_nearest_segment(road_network, positions[i]);
+  }
+  double legacy_ms = bench_elapsed_ms(start) / legacy_queries;
+
+  std::vector<size_t> indexed(positions.size());
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < positions.size(); ++i) {
+    indexed[i] = road_network.find_nearest_segment(positions[i]);
+  }
+  double indexed_ms = bench_elapsed_ms(start) / positions.size();
+
+  size_t wrong = 0;
+  for (size_t i = 0; i < legacy_queries; ++i) {
+    float want = RoadNetwork::distance_sq_to_segment(
+        road_network.segments[legacy[i]], positions[i]);
+    float got = RoadNetwork::distance_sq_to_segment(
+        road_network.segments[indexed[i]], positions[i]);
+    wrong += want == got ? 0 : 1;
+  }
+
+  // Radius query against a scan
+  constexpr float radius = 60.0f;
+  size_t radius_wrong = 0;
+  size_t radius_hits = 0;
+  for (size_t i = 0; i < 20; ++i) {
+    size_t expected = 0;
+    for (const RoadSegment &segment : road_network.segments) {
+      expected += RoadNetwork::distance_sq_to_segment(segment, positions[i]) <=
+                          radius * radius
+                      ? 1
+                      : 0;
+    }
+    size_t found = 0;
+    road_network.for_each_segment_in_radius(positions[i], radius,
+                                            [&](size_t) { found++; });
+    radius_hits += found;
+    radius_wrong += found == expected ? 0 : 1;
+  }
+
+  std::cout << fmt::format(
+      "{} segments, {} x {} chunks\n"
+      "  nearest: scan {:.2f} ms, chunks {:.4f} ms ({:.0f}x); 10k cars "
+      "{:.0f} ms vs {:.0f} ms, {}\n"
+      "  within {:.0f}: {} hits over 20 queries, {}\n",
+      road_network.segments.size(), layout.columns, layout.rows, legacy_ms,
+      indexed_ms, legacy_ms / std::max(indexed_ms, 0.000001),
+      indexed_ms * positions.size(), legacy_ms * positions.size(),
+      wrong == 0 ? "same distances as the scan" : "NEAREST DIFFERS", radius,
+      radius_hits, radius_wrong == 0 ? "same as the scan" : "COUNTS DIFFER");
+  failures += wrong == 0 && radius_wrong == 0 ? 0 : 1;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../../components.h"
+#include "../bench_macros.h"
+#include "road_chain_benchmarks.h"
+#include "road_network_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+
+namespace road_frontier_bench {
+
+// Links whose repaired distance disagrees with a from-scratch build, or
+// whose next link doesn't actually realise that distance
+inline size_t count_wrong(const RoadNetwork &road_network) {
+  FrontierField fresh;
+  fresh.build(road_network.graph, road_network.chains, road_network.segments,
+              road_network.visited_segments);
+  const FrontierField &field = road_network.frontier;
+  size_t wrong = 0;
+  for (uint32_t link = 0; link < fresh.distance.size(); ++link) {
+    float want = fresh.distance[link];
+    float got = field.distance[link];
+    if (want == FrontierField::UNREACHABLE ||
+        got == FrontierField::UNREACHABLE) {
+      wrong += want == got ? 0 : 1;
+      continue;
+    }
+    float tolerance = 1e-3f * std::max(1.0f, want);
+    if (std::abs(want - got) > tolerance) {
+      wrong++;
+      continue;
+    }
+    uint32_t next = field.next[link];
+    if (got > 0.0f &&
+        (next == FrontierField::INVALID ||
+         std::abs(field.length[RoadGraph::link_segment(link)] +
+                  field.distance[next] - got) > tolerance)) {
+      wrong++;
+    }
+  }
+  return wrong;
+}
+
+inline int report(const std::string &label, RoadNetwork &road_network) {
+  std::vector<size_t> order(road_network.segments.size());
+  std::iota(order.begin(), order.end(), 0);
+  // Visit in runs along the segment order, the way cars sweep through
+  // streets, with the occasional jump elsewhere
+  std::mt19937 rng(11);
+  for (size_t i = 0; i + 64 < order.size(); i += 64) {
+    if (rng() % 4 == 0) {
+      std::swap(order[i], order[rng() % order.size()]);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  road_network.frontier.build(road_network.graph, road_network.chains,
+                              road_network.segments,
+                              road_network.visited_segments);
+  double build_ms = bench_elapsed_ms(start);
+
+  constexpr size_t batch = 32;
+  size_t checks = 0;
+  size_t wrong = 0;
+  double refresh_ms = 0.0;
+  double worst_refresh_ms = 0.0;
+  for (size_t i = 0; i < order.size(); i += batch) {
+    for (size_t j = i; j < std::min(i + batch, order.size()); ++j) {
+      road_network.mark_visited(order[j]);
+    }
+    start = std::chrono::steady_clock::now();
+    road_network.frontier.refresh(road_network.graph, road_network.chains);
+    double ms = bench_elapsed_ms(start);
+    refresh_ms += ms;
+    worst_refresh_ms = std::max(worst_refresh_ms, ms);
+    // Spot checks through the run, always including the very end
+    if ((i / batch) % 17 == 0 || i + batch >= order.size()) {
+      wrong += count_wrong(road_network);
+      checks++;
+    }
+  }
+  size_t batches = (order.size() + batch - 1) / batch;
+  bool all_unreachable = true;
+  for (float d : road_network.frontier.distance) {
+    all_unreachable = all_unreachable && d == FrontierField::UNREACHABLE;
+  }
+
+  std::cout << fmt::format(
+      "{}: {} segments, full build {:.1f} ms, incremental refresh {:.3f} ms "
+      "per {} visits (worst {:.2f} ms), {:.2f} us per visit, field {:.1f} "
+      "MB, {} spot checks, {}\n",
+      label, road_network.segments.size(), build_ms, refresh_ms / batches,
+      batch, worst_refresh_ms,
+      refresh_ms * 1000.0 / static_cast<double>(order.size()),
+      road_network.frontier.memory_bytes() / (1024.0 * 1024.0), checks,
+      wrong == 0 && all_unreachable
+          ? "matches rebuild"
+          : fmt::format("{} LINKS WRONG", wrong + (all_unreachable ? 0 : 1)));
+  return wrong == 0 && all_unreachable ? 0 : 1;
+}
+
+} // namespace road_frontier_bench
+
+// Visits a whole map in batches and checks that the incrementally repaired
+// frontier field always agrees with one rebuilt from scratch
+BENCHMARK(frontier_field) {
+  using namespace road_frontier_bench;
+  int failures = 0;
+
+  std::filesystem::path nyc_roads_path =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  RoadNetwork nyc;
+  if (load_road_network_from_json(nyc, nyc_roads_path)) {
+    nyc.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+    failures += report("nyc_roads.json", nyc);
+  } else {
+    std::cout << "nyc_roads.json not found, skipping\n";
+  }
+
+  RoadNetwork grid;
+  road_chain_bench::make_subdivided_grid(grid, 100, 2);
+  grid.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+  failures += report("grid", grid);
+  return failures == 0 ? 0 : 1;
+}
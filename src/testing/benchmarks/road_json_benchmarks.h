@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../game_setup.h"
+#include "../bench_macros.h"
+#include "road_cache_benchmarks.h"
+#include "road_network_benchmarks.h"
+#include <afterhours/src/plugins/files.h>
+#include <fmt/format.h>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace road_json_bench {
+
+// Peak resident set so far in MB, or 0 where it is not available
+inline double peak_rss_mb() {
+#if defined(_WIN32)
+  return 0.0;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+}
+
+struct ParseRun {
+  double best_ms{0.0};
+  double mb_per_s{0.0};
+  double peak_growth_mb{0.0};
+  bool loaded{false};
+};
+
+inline ParseRun time_parse(const std::filesystem::path &path,
+                           RoadJsonLoadMode mode, int runs,
+                           RoadNetwork &result) {
+  ParseRun run;
+  double file_mb = static_cast<double>(std::filesystem::file_size(path)) /
+                   (1024.0 * 1024.0);
+  double peak_before = peak_rss_mb();
+  run.best_ms = std::numeric_limits<double>::max();
+  for (int i = 0; i < runs; ++i) {
+    RoadNetwork network;
+    auto start = std::chrono::steady_clock::now();
+    run.loaded = load_road_network_from_json(network, path, mode);
+    run.best_ms = std::min(run.best_ms, bench_elapsed_ms(start));
+    if (!run.loaded) {
+      return run;
+    }
+    if (i + 1 == runs) {
+      result = std::move(network);
+    }
+  }
+  run.mb_per_s = file_mb / (std::max(run.best_ms, 0.001) / 1000.0);
+  run.peak_growth_mb = peak_rss_mb() - peak_before;
+  return run;
+}
+
+inline void print(const std::string &name, const ParseRun &streaming,
+                  const ParseRun &dom, size_t segments, bool same) {
+  std::cout << fmt::format(
+      "{}: {} segments\n"
+      "  streaming {:.1f} ms ({:.0f} MB/s), peak +{:.0f} MB\n"
+      "  dom       {:.1f} ms ({:.0f} MB/s), peak +{:.0f} MB\n"
+      "  {:.1f}x faster, {}\n",
+      name, segments, streaming.best_ms, streaming.mb_per_s,
+      streaming.peak_growth_mb, dom.best_ms, dom.mb_per_s, dom.peak_growth_mb,
+      dom.best_ms / std::max(streaming.best_ms, 0.001),
+      same ? "segments match" : "SEGMENTS DIFFER");
+}
+
+} // namespace road_json_bench
+
+// Streaming runs first each time so its peak is not hidden behind the DOM's
+BENCHMARK(road_json) {
+  using namespace road_json_bench;
+  int failures = 0;
+
+  std::filesystem::path nyc_json =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  if (std::filesystem::exists(nyc_json)) {
+    RoadNetwork streamed;
+    RoadNetwork dom_loaded;
+    ParseRun streaming =
+        time_parse(nyc_json, RoadJsonLoadMode::Streaming, 20, streamed);
+    ParseRun dom = time_parse(nyc_json, RoadJsonLoadMode::Dom, 20, dom_loaded);
+    bool same = streaming.loaded && dom.loaded &&
+                road_cache_bench::same_bytes(streamed.segments,
+                                             dom_loaded.segments);
+    print("nyc_roads.json", streaming, dom, streamed.segments.size(), same);
+    failures += same ? 0 : 1;
+  } else {
+    std::cout << "nyc_roads.json not found, skipping\n";
+  }
+
+  std::filesystem::path work_dir =
+      std::filesystem::temp_directory_path() / "break_ross_road_json_bench";
+  std::filesystem::create_directories(work_dir);
+  std::filesystem::path synthetic_json = work_dir / "synthetic.json";
+  {
+    RoadNetwork synthetic;
+    road_network_bench::make_synthetic_grid(synthetic, 1'000'000);
+    road_cache_bench::write_network_json(synthetic, synthetic_json);
+  }
+  std::cout << fmt::format(
+      "synthetic.json: {:.0f} MB on disk\n",
+      static_cast<double>(std::filesystem::file_size(synthetic_json)) /
+          (1024.0 * 1024.0));
+
+  RoadNetwork streamed;
+  RoadNetwork dom_loaded;
+  ParseRun streaming =
+      time_parse(synthetic_json, RoadJsonLoadMode::Streaming, 1, streamed);
+  ParseRun dom =
+      time_parse(synthetic_json, RoadJsonLoadMode::Dom, 1, dom_loaded);
+  bool same = streaming.loaded && dom.loaded &&
+              road_cache_bench::same_bytes(streamed.segments,
+                                           dom_loaded.segments);
+  print("synthetic grid", streaming, dom, streamed.segments.size(), same);
+  failures += same ? 0 : 1;
+
+  std::error_code ec;
+  std::filesystem::remove_all(work_dir, ec);
+  return failures == 0 ? 0 : 1;
+}
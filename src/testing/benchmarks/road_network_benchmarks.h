@@ -0,0 +1,288 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../game_setup.h"
+#include "../bench_macros.h"
+#include <afterhours/src/plugins/files.h>
+#include <fmt/format.h>
+#include <iostream>
+
+namespace road_network_bench {
+
+constexpr float CONNECTION_TOLERANCE = game_constants::ROAD_CONNECTION_TOLERANCE;
+
+// Per-segment [start, end] lists of (segment, reverse), the layout the
+// junction graph replaced
+using LegacyConnections =
+    std::vector<std::array<std::vector<std::pair<size_t, bool>>, 2>>;
+
+// The all-pairs builder that shipped before endpoint welding, kept so the
+// benchmark can compare against it. Returns the number of components.
+inline size_t
+legacy_build_connected_components(const RoadNetwork &road_network,
+                                  float connection_tolerance,
+                                  LegacyConnections &connections) {
+  const MappedArray<RoadSegment> &segments = road_network.segments;
+  std::vector<std::vector<size_t>> components;
+  connections.clear();
+  connections.resize(segments.size());
+
+  std::vector<std::vector<size_t>> adjacency(segments.size());
+  auto dist = [](vec2 a, vec2 b) {
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+  };
+
+  for (size_t i = 0; i < segments.size(); ++i) {
+    for (size_t j = i + 1; j < segments.size(); ++j) {
+      float dist_ss = dist(segments[i].start, segments[j].start);
+      float dist_se = dist(segments[i].start, segments[j].end);
+      float dist_es = dist(segments[i].end, segments[j].start);
+      float dist_ee = dist(segments[i].end, segments[j].end);
+      if (dist_ss >= connection_tolerance && dist_se >= connection_tolerance &&
+          dist_es >= connection_tolerance && dist_ee >= connection_tolerance) {
+        continue;
+      }
+      adjacency[i].push_back(j);
+      adjacency[j].push_back(i);
+      auto &con_i = connections[i];
+      auto &con_j = connections[j];
+      if (dist_es < connection_tolerance) {
+        con_i[1].push_back({j, false});
+        con_j[0].push_back({i, true});
+      }
+      if (dist_ee < connection_tolerance) {
+        con_i[1].push_back({j, true});
+        con_j[1].push_back({i, true});
+      }
+      if (dist_ss < connection_tolerance) {
+        con_i[0].push_back({j, false});
+        con_j[0].push_back({i, false});
+      }
+      if (dist_se < connection_tolerance) {
+        con_i[0].push_back({j, true});
+        con_j[1].push_back({i, false});
+      }
+    }
+  }
+
+  std::vector<bool> visited(segments.size(), false);
+  for (size_t i = 0; i < segments.size(); ++i) {
+    if (visited[i]) {
+      continue;
+    }
+    std::vector<size_t> component;
+    std::vector<size_t> stack{i};
+    visited[i] = true;
+    while (!stack.empty()) {
+      size_t current = stack.back();
+      stack.pop_back();
+      component.push_back(current);
+      for (size_t neighbor : adjacency[current]) {
+        if (!visited[neighbor]) {
+          visited[neighbor] = true;
+          stack.push_back(neighbor);
+        }
+      }
+    }
+    components.push_back(std::move(component));
+  }
+  return components.size();
+}
+
+// Square lattice of two-point streets with 20 unit blocks, comfortably
+// wider than the connection tolerance so only shared corners connect
+inline void make_synthetic_grid(RoadNetwork &road_network,
+                                size_t target_segments) {
+  road_network.segments.clear();
+  size_t side = static_cast<size_t>(std::ceil(
+                    std::sqrt(static_cast<double>(target_segments) / 2.0))) +
+                1;
+  float spacing = 20.0f;
+  road_network.segments.reserve(side * (side - 1) * 2);
+  for (size_t y = 0; y < side; ++y) {
+    for (size_t x = 0; x + 1 < side; ++x) {
+      RoadSegment horizontal;
+      horizontal.start = {x * spacing, y * spacing};
+      horizontal.end = {(x + 1) * spacing, y * spacing};
+      road_network.segments.push_back(horizontal);
+
+      RoadSegment vertical;
+      vertical.start = {y * spacing, x * spacing};
+      vertical.end = {y * spacing, (x + 1) * spacing};
+      road_network.segments.push_back(vertical);
+    }
+  }
+  if (road_network.segments.size() > target_segments) {
+    road_network.segments.resize(target_segments);
+  }
+  road_network.visited_segments.assign(road_network.segments.size(), false);
+  road_network.is_loaded = true;
+}
+
+inline LegacyConnections to_legacy_connections(const RoadGraph &graph) {
+  LegacyConnections connections(graph.segment_count());
+  for (size_t seg = 0; seg < connections.size(); ++seg) {
+    for (size_t side = 0; side < 2; ++side) {
+      for (uint32_t link : graph.port_links(RoadGraph::make_port(seg, side))) {
+        connections[seg][side].push_back(
+            {RoadGraph::link_segment(link), RoadGraph::link_reverse(link)});
+      }
+    }
+  }
+  return connections;
+}
+
+// Heap footprint of the nested layout, counting 16 bytes of allocator
+// bookkeeping per non-empty list
+inline size_t legacy_connection_bytes(const LegacyConnections &connections) {
+  size_t bytes = connections.capacity() * sizeof(connections[0]);
+  for (const auto &endpoint_connections : connections) {
+    for (const auto &list : endpoint_connections) {
+      if (list.capacity() > 0) {
+        bytes += list.capacity() * sizeof(list[0]) + 16;
+      }
+    }
+  }
+  return bytes;
+}
+
+inline size_t count_connection_mismatches(const RoadGraph &graph,
+                                          const LegacyConnections &legacy) {
+  LegacyConnections current = to_legacy_connections(graph);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < legacy.size(); ++i) {
+    for (size_t side = 0; side < 2; ++side) {
+      auto rhs = legacy[i][side];
+      std::sort(rhs.begin(), rhs.end());
+      if (i >= current.size() || current[i][side] != rhs) {
+        mismatches++;
+      }
+    }
+  }
+  return mismatches;
+}
+
+inline std::string memory_text(const RoadGraph &graph) {
+  constexpr double MB = 1024.0 * 1024.0;
+  size_t legacy_bytes = legacy_connection_bytes(to_legacy_connections(graph));
+  size_t link_bytes = graph.link_bytes();
+  return fmt::format(
+      "links {:.2f} MB vs nested lists {:.2f} MB ({:.1f}x), {:.2f} MB with "
+      "node records",
+      static_cast<double>(link_bytes) / MB,
+      static_cast<double>(legacy_bytes) / MB,
+      static_cast<double>(legacy_bytes) /
+          static_cast<double>(std::max<size_t>(link_bytes, 1)),
+      static_cast<double>(graph.memory_bytes()) / MB);
+}
+
+inline double time_welded(RoadNetwork &road_network) {
+  auto start = std::chrono::steady_clock::now();
+  road_network.build_connected_components(CONNECTION_TOLERANCE);
+  return bench_elapsed_ms(start);
+}
+
+inline double time_legacy(const RoadNetwork &road_network,
+                          LegacyConnections &connections,
+                          size_t &component_count) {
+  auto start = std::chrono::steady_clock::now();
+  component_count = legacy_build_connected_components(
+      road_network, CONNECTION_TOLERANCE, connections);
+  return bench_elapsed_ms(start);
+}
+
+} // namespace road_network_bench
+
+BENCHMARK(road_components) {
+  using namespace road_network_bench;
+
+  std::filesystem::path nyc_roads_path =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  RoadNetwork nyc;
+  if (load_road_network_from_json(nyc, nyc_roads_path)) {
+    LegacyConnections legacy_connections;
+    size_t legacy_components = 0;
+    double welded_ms = time_welded(nyc);
+    double legacy_ms = time_legacy(nyc, legacy_connections, legacy_components);
+    size_t mismatches =
+        count_connection_mismatches(nyc.graph, legacy_connections);
+    std::cout << fmt::format(
+        "nyc_roads.json: {} segments, {} components, {} nodes\n"
+        "  welded {:.2f} ms, all-pairs {:.2f} ms ({:.1f}x), {} endpoint "
+        "lists differ\n  {}\n",
+        nyc.segments.size(), nyc.component_count(), nyc.graph.nodes.size(),
+        welded_ms, legacy_ms, legacy_ms / std::max(welded_ms, 0.001),
+        mismatches, memory_text(nyc.graph));
+    if (mismatches > 0 || nyc.component_count() != legacy_components) {
+      std::cout << "  welded connections do not match the all-pairs result\n";
+      return 1;
+    }
+
+  } else {
+    std::cout << "nyc_roads.json not found, skipping\n";
+  }
+
+  // All-pairs is quadratic, so it is only timed on the smaller networks and
+  // extrapolated from the largest of those
+  double largest_legacy_ms = 0.0;
+  size_t largest_legacy_size = 0;
+  for (size_t size : {10'000u, 40'000u, 1'000'000u}) {
+    RoadNetwork synthetic;
+    make_synthetic_grid(synthetic, size);
+    double welded_ms = time_welded(synthetic);
+
+    std::string legacy_text;
+    if (size <= 40'000u) {
+      LegacyConnections legacy_connections;
+      size_t legacy_components = 0;
+      double legacy_ms =
+          time_legacy(synthetic, legacy_connections, legacy_components);
+      largest_legacy_ms = legacy_ms;
+      largest_legacy_size = size;
+      legacy_text = fmt::format("all-pairs {:.2f} ms", legacy_ms);
+    } else {
+      double scale = static_cast<double>(size) /
+                     static_cast<double>(std::max<size_t>(largest_legacy_size, 1));
+      legacy_text = fmt::format("all-pairs ~{:.0f} s (extrapolated)",
+                                largest_legacy_ms * scale * scale / 1000.0);
+    }
+    std::cout << fmt::format("synthetic grid: {} segments, {} components\n"
+                             "  welded {:.2f} ms, {}\n  {}\n",
+                             synthetic.segments.size(),
+                             synthetic.component_count(), welded_ms,
+                             legacy_text, memory_text(synthetic.graph));
+  }
+
+  // Two copies of a grid side by side, joined in place instead of rebuilt
+  RoadNetwork pair;
+  make_synthetic_grid(pair, 40'000);
+  size_t half = pair.segments.size();
+  for (size_t i = 0; i < half; ++i) {
+    RoadSegment copy = pair.segments[i];
+    copy.start.x += 10'000.0f;
+    copy.end.x += 10'000.0f;
+    pair.segments.push_back(copy);
+  }
+  double rebuild_ms = time_welded(pair);
+  size_t expected_size =
+      pair.get_component_size(pair.get_component_id(0)) +
+      pair.get_component_size(pair.get_component_id(half));
+  size_t expected_count = pair.component_count() - 1;
+  auto start = std::chrono::steady_clock::now();
+  bool merged = pair.connect_segments(0, half);
+  double connect_us = bench_elapsed_ms(start) * 1000.0;
+  size_t root = pair.get_component_id(half);
+  size_t listed = 0;
+  pair.components.for_each_member(root, [&](size_t) { listed++; });
+  bool merge_ok = merged && expected_count == 1 &&
+                  pair.component_count() == expected_count &&
+                  pair.get_component_id(0) == root &&
+                  pair.get_component_size(root) == expected_size &&
+                  listed == pair.segments.size();
+  std::cout << fmt::format(
+      "two grids: {} segments joined by connect_segments in {:.2f} us vs "
+      "{:.2f} ms to rebuild, {}\n",
+      expected_size, connect_us, rebuild_ms,
+      merge_ok ? "sizes and member lists agree" : "INCREMENTAL MERGE WRONG");
+  return merge_ok ? 0 : 1;
+}
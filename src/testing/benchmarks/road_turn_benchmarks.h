@@ -0,0 +1,210 @@
+#pragma once
+
+#include "../../components.h"
+#include "../bench_macros.h"
+#include "road_network_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+#include <set>
+
+namespace road_turn_bench {
+
+struct Junction {
+  size_t segment;
+  bool reverse;
+  std::vector<size_t> history;
+};
+
+// MazeTraversal::select_next_wall_follower before the turn tables:
+// geometry, tolerance checks, a std::set and a sort at every junction
+inline uint32_t legacy_wall_follower(const RoadNetwork &road_network,
+                                     const Junction &junction) {
+  const RoadSegment &current = road_network.segments[junction.segment];
+  vec2 current_start = junction.reverse ? current.end : current.start;
+  vec2 current_end = junction.reverse ? current.start : current.end;
+  vec2 current_dir = {current_end.x - current_start.x,
+                      current_end.y - current_start.y};
+  float current_len = std::sqrt(current_dir.x * current_dir.x +
+                                current_dir.y * current_dir.y);
+  if (current_len <= 0.001f) {
+    return RoadGraph::INVALID;
+  }
+  current_dir.x /= current_len;
+  current_dir.y /= current_len;
+
+  struct Candidate {
+    uint32_t link;
+    float angle;
+    bool is_unvisited;
+  };
+  std::vector<Candidate> candidates;
+  std::set<size_t> recent(junction.history.begin(), junction.history.end());
+  for (uint32_t link :
+       road_network.graph.next_links(junction.segment, junction.reverse)) {
+    size_t seg = RoadGraph::link_segment(link);
+    if (seg == junction.segment || recent.count(seg) != 0) {
+      continue;
+    }
+    bool reverse = RoadGraph::link_reverse(link);
+    const RoadSegment &candidate = road_network.segments[seg];
+    vec2 start = reverse ? candidate.end : candidate.start;
+    vec2 end = reverse ? candidate.start : candidate.end;
+    vec2 dir = {end.x - start.x, end.y - start.y};
+    float len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+    if (len < 0.001f) {
+      continue;
+    }
+    dir.x /= len;
+    dir.y /= len;
+    float cross = current_dir.x * dir.y - current_dir.y * dir.x;
+    float dot = current_dir.x * dir.x + current_dir.y * dir.y;
+    float dist_to_start =
+        std::sqrt((start.x - current_end.x) * (start.x - current_end.x) +
+                  (start.y - current_end.y) * (start.y - current_end.y));
+    float dist_to_end =
+        std::sqrt((end.x - current_end.x) * (end.x - current_end.x) +
+                  (end.y - current_end.y) * (end.y - current_end.y));
+    if (dist_to_start >= road_network_bench::CONNECTION_TOLERANCE &&
+        dist_to_end >= road_network_bench::CONNECTION_TOLERANCE) {
+      continue;
+    }
+    candidates.push_back(
+        {link, std::atan2(cross, dot), !road_network.is_visited(seg)});
+  }
+  if (candidates.empty()) {
+    return RoadGraph::INVALID;
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) {
+              if (a.is_unvisited != b.is_unvisited) {
+                return a.is_unvisited;
+              }
+              return RoadTurns::wall_follower_rank(a.angle) <
+                     RoadTurns::wall_follower_rank(b.angle);
+            });
+  return candidates[0].link;
+}
+
+// The same decision read off the turn table
+inline uint32_t table_wall_follower(const RoadNetwork &road_network,
+                                    const Junction &junction) {
+  const RoadTurn *fallback = nullptr;
+  for (const RoadTurn &turn : road_network.turns.at(
+           RoadGraph::exit_port(junction.segment, junction.reverse))) {
+    size_t seg = RoadGraph::link_segment(turn.link);
+    if (std::find(junction.history.begin(), junction.history.end(), seg) !=
+        junction.history.end()) {
+      continue;
+    }
+    if (!road_network.is_visited(seg)) {
+      return turn.link;
+    }
+    if (!fallback) {
+      fallback = &turn;
+    }
+  }
+  return fallback ? fallback->link : RoadGraph::INVALID;
+}
+
+// Rank of a chosen link, so ties the old unstable sort broke differently
+// still count as the same decision
+inline float rank_of(const RoadNetwork &road_network, const Junction &junction,
+                     uint32_t link) {
+  for (const RoadTurn &turn : road_network.turns.at(
+           RoadGraph::exit_port(junction.segment, junction.reverse))) {
+    if (turn.link == link) {
+      return RoadTurns::wall_follower_rank(turn.angle);
+    }
+  }
+  return -1.0f;
+}
+
+inline int report(const std::string &label, RoadNetwork &road_network) {
+  std::mt19937 rng(5);
+  for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    if (rng() % 2 == 0) {
+      road_network.mark_visited(i);
+    }
+  }
+  // Real junctions only, each with a short history of nearby segments
+  std::vector<Junction> junctions;
+  for (size_t seg = 0; seg < road_network.graph.segment_count(); ++seg) {
+    for (bool reverse : {false, true}) {
+      if (road_network.graph.next_links(seg, reverse).size() < 2) {
+        continue;
+      }
+      Junction junction{seg, reverse, {}};
+      for (size_t h = 0; h < 4; ++h) {
+        junction.history.push_back(
+            (seg + rng() % 64) % road_network.segments.size());
+      }
+      junctions.push_back(junction);
+    }
+  }
+
+  std::vector<uint32_t> legacy(junctions.size());
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < junctions.size(); ++i) {
+    legacy[i] = legacy_wall_follower(road_network, junctions[i]);
+  }
+  double legacy_ns = bench_elapsed_ms(start) * 1e6 / junctions.size();
+
+  std::vector<uint32_t> table(junctions.size());
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < junctions.size(); ++i) {
+    table[i] = table_wall_follower(road_network, junctions[i]);
+  }
+  double table_ns = bench_elapsed_ms(start) * 1e6 / junctions.size();
+
+  size_t differ = 0;
+  for (size_t i = 0; i < junctions.size(); ++i) {
+    if (legacy[i] == table[i]) {
+      continue;
+    }
+    bool same_kind =
+        legacy[i] != RoadGraph::INVALID && table[i] != RoadGraph::INVALID &&
+        road_network.is_visited(RoadGraph::link_segment(legacy[i])) ==
+            road_network.is_visited(RoadGraph::link_segment(table[i])) &&
+        rank_of(road_network, junctions[i], legacy[i]) ==
+            rank_of(road_network, junctions[i], table[i]);
+    differ += same_kind ? 0 : 1;
+  }
+  std::cout << fmt::format(
+      "{}: {} junction decisions, recompute {:.0f} ns, table {:.0f} ns "
+      "({:.1f}x), tables {:.1f} KB, {}\n",
+      label, junctions.size(), legacy_ns, table_ns,
+      legacy_ns / std::max(table_ns, 0.001),
+      road_network.turns.memory_bytes() / 1024.0,
+      differ == 0 ? "same choices" : fmt::format("{} CHOICES DIFFER", differ));
+  return differ == 0 ? 0 : 1;
+}
+
+} // namespace road_turn_bench
+
+BENCHMARK(road_turns) {
+  using namespace road_turn_bench;
+  int failures = 0;
+
+  std::filesystem::path nyc_roads_path =
+      afterhours::files::get_resource_path("", "nyc_roads.json");
+  RoadNetwork nyc;
+  if (load_road_network_from_json(nyc, nyc_roads_path)) {
+    nyc.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+    failures += report("nyc_roads.json", nyc);
+  } else {
+    std::cout << "nyc_roads.json not found, skipping\n";
+  }
+
+  RoadNetwork grid;
+  road_network_bench::make_synthetic_grid(grid, 200'000);
+  auto start = std::chrono::steady_clock::now();
+  grid.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+  double build_ms = bench_elapsed_ms(start);
+  start = std::chrono::steady_clock::now();
+  grid.turns.build(grid.graph, grid.segments);
+  double turns_ms = bench_elapsed_ms(start);
+  std::cout << fmt::format("grid: graph {:.1f} ms, turn tables {:.1f} ms\n",
+                           build_ms, turns_ms);
+  failures += report("grid", grid);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "../../components.h"
+#include "../bench_macros.h"
+#include "road_network_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+
+namespace road_unvisited_bench {
+
+// RoadNetwork::find_random_unvisited_segment before the sparse set
+inline size_t legacy_find_random_unvisited(const RoadNetwork &road_network,
+                                           std::mt19937 &rng) {
+  std::vector<size_t> unvisited;
+  for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    if (!road_network.is_visited(i)) {
+      unvisited.push_back(i);
+    }
+  }
+  if (unvisited.empty()) {
+    return SIZE_MAX;
+  }
+  std::uniform_int_distribution<size_t> dist(0, unvisited.size() - 1);
+  return unvisited[dist(rng)];
+}
+
+inline size_t scan_unvisited_count(const RoadNetwork &road_network) {
+  size_t count = 0;
+  for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    count += road_network.is_visited(i) ? 0 : 1;
+  }
+  return count;
+}
+
+// Every component's counter and list agree with a scan of its members
+inline bool components_consistent(const RoadNetwork &road_network) {
+  for (size_t root = 0; root < road_network.segments.size(); ++root) {
+    if (!road_network.components.is_root(root)) {
+      continue;
+    }
+    size_t scanned = 0;
+    road_network.components.for_each_member(root, [&](size_t seg) {
+      scanned += road_network.is_visited(seg) ? 0 : 1;
+    });
+    size_t listed = 0;
+    bool all_unvisited = true;
+    road_network.for_each_unvisited_in_component(root, [&](size_t seg) {
+      listed++;
+      all_unvisited = all_unvisited && !road_network.is_visited(seg) &&
+                      road_network.get_component_id(seg) == root;
+    });
+    if (scanned != listed || !all_unvisited ||
+        road_network.get_unvisited_count_in_component(root) != scanned) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Per-component visited count before the unvisited index kept it
+inline size_t legacy_visited_in_component(const RoadNetwork &road_network,
+                                          size_t root) {
+  size_t visited = 0;
+  road_network.components.for_each_member(root, [&](size_t seg) {
+    visited += road_network.is_visited(seg) ? 1 : 0;
+  });
+  return visited;
+}
+
+inline bool road_type_counts_consistent(const RoadNetwork &road_network) {
+  std::array<size_t, RoadNetwork::ROAD_TYPE_COUNT> total{};
+  std::array<size_t, RoadNetwork::ROAD_TYPE_COUNT> visited{};
+  for (size_t i = 0; i < road_network.segments.size(); ++i) {
+    size_t type = static_cast<size_t>(road_network.segments[i].road_type);
+    total[type]++;
+    visited[type] += road_network.is_visited(i) ? 1 : 0;
+  }
+  for (RoadType road_type : magic_enum::enum_values<RoadType>()) {
+    size_t type = static_cast<size_t>(road_type);
+    if (road_network.get_road_type_count(road_type) != total[type] ||
+        road_network.get_road_type_visited_count(road_type) != visited[type]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace road_unvisited_bench
+
+BENCHMARK(road_unvisited) {
+  using namespace road_unvisited_bench;
+  int failures = 0;
+  std::mt19937 rng(1234);
+
+  RoadNetwork road_network;
+  road_network_bench::make_synthetic_grid(road_network, 1'000'000);
+  road_network.build_connected_components(
+      road_network_bench::CONNECTION_TOLERANCE);
+
+  std::vector<size_t> order(road_network.segments.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), rng);
+
+  size_t marked = 0;
+  for (double fraction : {0.0, 0.9, 0.99}) {
+    size_t target = static_cast<size_t>(fraction * order.size());
+    auto start = std::chrono::steady_clock::now();
+    for (; marked < target; ++marked) {
+      road_network.mark_visited(order[marked]);
+    }
+    double mark_ms = bench_elapsed_ms(start);
+
+    constexpr int legacy_calls = 20;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < legacy_calls; ++i) {
+      legacy_find_random_unvisited(road_network, rng);
+    }
+    double legacy_us = bench_elapsed_ms(start) * 1000.0 / legacy_calls;
+
+    constexpr int calls = 100'000;
+    bool all_unvisited = true;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) {
+      size_t seg = road_network.find_random_unvisited_segment();
+      all_unvisited = all_unvisited && !road_network.is_visited(seg);
+    }
+    double sparse_us = bench_elapsed_ms(start) * 1000.0 / calls;
+
+    bool counts_match = road_network.get_unvisited_count() ==
+                        scan_unvisited_count(road_network);
+    std::cout << fmt::format(
+        "{} segments, {:.0f}% visited (marking took {:.1f} ms)\n"
+        "  sample: scan {:.0f} us, sparse set {:.3f} us ({:.0f}x), {}\n",
+        road_network.segments.size(), fraction * 100.0, mark_ms, legacy_us,
+        sparse_us, legacy_us / std::max(sparse_us, 0.0001),
+        all_unvisited && counts_match ? "samples and count agree"
+                                      : "SAMPLES OR COUNT WRONG");
+    failures += all_unvisited && counts_match ? 0 : 1;
+  }
+
+  // Uniformity on a few survivors, and per-component lists after a merge
+  RoadNetwork pair;
+  road_network_bench::make_synthetic_grid(pair, 2'000);
+  size_t half = pair.segments.size();
+  for (size_t i = 0; i < half; ++i) {
+    RoadSegment copy = pair.segments[i];
+    copy.start.x += 10'000.0f;
+    copy.end.x += 10'000.0f;
+    pair.segments.push_back(copy);
+  }
+  pair.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+  for (size_t i = 0; i < pair.segments.size(); ++i) {
+    if (i % 400 != 7) {
+      pair.mark_visited(i);
+    }
+  }
+  bool before_merge = components_consistent(pair);
+  pair.connect_segments(0, half);
+  bool after_merge = components_consistent(pair) &&
+                     pair.get_unvisited_count_in_component(
+                         pair.get_component_id(0)) == pair.get_unvisited_count();
+
+  std::map<size_t, int> hits;
+  constexpr int samples = 200'000;
+  for (int i = 0; i < samples; ++i) {
+    hits[pair.find_random_unvisited_segment()]++;
+  }
+  double expected = static_cast<double>(samples) /
+                    static_cast<double>(pair.get_unvisited_count());
+  double worst = 0.0;
+  for (const auto &[seg, count] : hits) {
+    worst = std::max(worst, std::abs(count - expected) / expected);
+  }
+  bool uniform = hits.size() == pair.get_unvisited_count() && worst < 0.1;
+  std::cout << fmt::format(
+      "{} unvisited of {}: worst bucket {:.1f}% off uniform, component "
+      "lists {}\n",
+      pair.get_unvisited_count(), pair.segments.size(), worst * 100.0,
+      before_merge && after_merge ? "consistent across a merge"
+                                  : "INCONSISTENT");
+  failures += uniform && before_merge && after_merge ? 0 : 1;
+
+  // Completion events: many small components visited in random order, each
+  // must report exactly once and on the visit that finishes it
+  RoadNetwork islands;
+  for (size_t i = 0; i < 20'000; ++i) {
+    // Far enough apart that each segment starts as its own component
+    vec2 start{static_cast<float>(i % 200) * 50.0f,
+               static_cast<float>(i / 200) * 50.0f};
+    RoadSegment segment;
+    segment.start = start;
+    segment.end = {start.x + 1.0f, start.y};
+    segment.road_type =
+        static_cast<RoadType>(i % RoadNetwork::ROAD_TYPE_COUNT);
+    islands.segments.push_back(segment);
+  }
+  islands.build_connected_components(road_network_bench::CONNECTION_TOLERANCE);
+  for (size_t i = 0; i + 2 < islands.segments.size(); i += 4) {
+    islands.connect_segments(i, i + 1);
+    islands.connect_segments(i + 1, i + 2);
+  }
+  std::vector<size_t> island_order(islands.segments.size());
+  std::iota(island_order.begin(), island_order.end(), 0);
+  std::shuffle(island_order.begin(), island_order.end(), rng);
+
+  std::vector<int> reported(islands.segments.size(), 0);
+  bool events_timely = true;
+  bool types_match = true;
+  for (size_t step = 0; step < island_order.size(); ++step) {
+    size_t seg = island_order[step];
+    size_t root = islands.get_component_id(seg);
+    bool finishes = islands.get_unvisited_count_in_component(root) == 1;
+    islands.mark_visited(seg);
+    bool fired = islands.completed_components.size() == 1 &&
+                 islands.completed_components.front() == root;
+    events_timely = events_timely &&
+                    (finishes ? fired : islands.completed_components.empty()) &&
+                    islands.is_component_complete(root) == finishes;
+    for (size_t done : islands.completed_components) {
+      reported[done]++;
+    }
+    islands.completed_components.clear();
+    if (step % 997 == 0) {
+      types_match = types_match && road_type_counts_consistent(islands);
+    }
+  }
+  size_t events = 0;
+  bool once_each = true;
+  for (size_t root = 0; root < islands.segments.size(); ++root) {
+    bool is_root = islands.components.is_root(root);
+    once_each = once_each && reported[root] == (is_root ? 1 : 0);
+    events += reported[root];
+  }
+  types_match = types_match && road_type_counts_consistent(islands);
+  std::cout << fmt::format(
+      "{} components: {} completion events, {}, road type counters {}\n",
+      islands.component_count(), events,
+      once_each && events_timely ? "one per component on its final visit"
+                                 : "MISSED OR DUPLICATED",
+      types_match ? "agree with a scan" : "DISAGREE WITH A SCAN");
+  failures += once_each && events_timely && types_match ? 0 : 1;
+
+  // Visited-in-component on the big network, counter vs member walk
+  size_t big_root = road_network.get_component_id(0);
+  constexpr int visited_calls = 20;
+  size_t legacy_visited = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < visited_calls; ++i) {
+    legacy_visited = legacy_visited_in_component(road_network, big_root);
+  }
+  double legacy_visited_us =
+      bench_elapsed_ms(start) * 1000.0 / visited_calls;
+  constexpr int counter_calls = 1'000'000;
+  size_t counted = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < counter_calls; ++i) {
+    counted += road_network.get_visited_count_in_component(big_root);
+  }
+  double counter_us = bench_elapsed_ms(start) * 1000.0 / counter_calls;
+  bool visited_match =
+      counted == legacy_visited * counter_calls &&
+      road_type_counts_consistent(road_network);
+  std::cout << fmt::format(
+      "visited in a {}-segment component: walk {:.0f} us, counter {:.4f} us, "
+      "{}\n",
+      road_network.get_component_size(big_root), legacy_visited_us, counter_us,
+      visited_match ? "counts agree" : "COUNTS DIFFER");
+  failures += visited_match ? 0 : 1;
+  return failures == 0 ? 0 : 1;
+}
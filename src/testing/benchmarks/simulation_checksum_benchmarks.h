@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../sim_random.h"
+#include "../../systems/TrackSimulationChecksum.h"
+#include "../bench_macros.h"
+#include "offline_progress_benchmarks.h"
+#include <fmt/format.h>
+#include <iostream>
+
+// Drives the same seeded fleet twice from a dark map and fails unless the
+// state checksums match on every tick: the wall follower, A*, which samples
+// random targets, and the route planner, whose tours come off a background
+// thread
+BENCHMARK(deterministic_replay) {
+  using namespace offline_progress_bench;
+  World &w = maze_traversal_bench::world();
+  spawn_entities(8, 100);
+  afterhours::EntityHelper::get_singleton_cmp<CoverageRouting>()
+      ->wait_for_plans = true;
+  afterhours::Entity &entity = afterhours::EntityHelper::createEntity();
+  SimulationChecksum &checksum =
+      maze_traversal_bench::add_singleton<SimulationChecksum>(entity);
+  TrackSimulationChecksum tracker;
+
+  constexpr float seconds = 20.0f;
+  auto record = [&](uint32_t seed, int level) {
+    SimRandom::seed(seed);
+    reset(w, level);
+    checksum.tick = 0;
+    std::vector<uint64_t> sums;
+    run_per_tick(w, seconds, [&]() {
+      tracker.for_each_with(entity, checksum,
+                            game_constants::FIXED_TICK_SECONDS);
+      sums.push_back(checksum.value);
+    });
+    return sums;
+  };
+  auto first_difference = [](const std::vector<uint64_t> &a,
+                             const std::vector<uint64_t> &b) {
+    auto [at, _] = std::mismatch(a.begin(), a.end(), b.begin(), b.end());
+    return static_cast<long>(at - a.begin());
+  };
+
+  int failures = 0;
+  for (int level : {0, 3, 4}) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> first = record(42, level);
+    double run_ms = bench_elapsed_ms(start);
+    std::vector<uint64_t> again = record(42, level);
+    std::vector<uint64_t> other = record(43, level);
+    bool identical = first == again;
+    failures += identical ? 0 : 1;
+    std::cout << fmt::format(
+        "level {}: {} ticks in {:.0f} ms, seed 42 twice {} (final "
+        "{:016x}); seed 43 {}\n",
+        level, first.size(), run_ms,
+        identical ? "identical"
+                  : fmt::format("DIVERGES at tick {}",
+                                first_difference(first, again) + 1),
+        first.back(),
+        first == other ? "identical"
+                       : fmt::format("differs from tick {}",
+                                     first_difference(first, other) + 1));
+  }
+  w.shop->maze_algorithm_level = 0;
+  w.cars->clear();
+  return failures == 0 ? 0 : 1;
+}
@@ -1 +1,5 @@
 #pragma once
+
+#include "exploration_tests.h"
+#include "fog_reveal_tests.h"
+#include "simulation_tests.h"
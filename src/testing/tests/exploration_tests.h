@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../../components.h"
+#include "../../exploration_policies.h"
+#include "../test_macros.h"
+#include <fmt/format.h>
+#include <stdexcept>
+
+namespace exploration_test {
+
+// A binary tree of single-segment roads hanging off a trunk, `depth`
+// junctions deep, so every dead end is a leaf
+inline void make_tree(RoadNetwork &road_network, int depth) {
+  road_network.segments.clear();
+  RoadSegment trunk;
+  trunk.start = {0.0f, -100.0f};
+  trunk.end = {0.0f, 0.0f};
+  road_network.segments.push_back(trunk);
+  struct Branch {
+    vec2 at;
+    float spread;
+    int level;
+  };
+  std::vector<Branch> open{{trunk.end, 800.0f, 0}};
+  while (!open.empty()) {
+    Branch branch = open.back();
+    open.pop_back();
+    if (branch.level == depth) {
+      continue;
+    }
+    for (float side : {-1.0f, 1.0f}) {
+      RoadSegment road;
+      road.start = branch.at;
+      road.end = {branch.at.x + side * branch.spread, branch.at.y + 100.0f};
+      road_network.segments.push_back(road);
+      open.push_back({road.end, branch.spread * 0.5f, branch.level + 1});
+    }
+  }
+  road_network.visited_segments.assign(road_network.segments.size(), false);
+  road_network.is_loaded = true;
+  road_network.build_connected_components(
+      RoadNetwork::NODE_WELD_DISTANCE);
+  road_network.rebuild_visit_tracking();
+}
+
+} // namespace exploration_test
+
+// DFS must cover a tree on its own: every dead end sends the car back up,
+// as many junctions as it takes, and no junction asks the frontier field
+// for help. Each road is driven at most once down and once back up.
+TEST(dfs_backtracks_up_a_tree) {
+  RoadNetwork road_network;
+  exploration_test::make_tree(road_network, 4);
+  size_t segment_count = road_network.segments.size();
+
+  RoadFollowingState car(1.0f);
+  ExplorationState state;
+  ExplorationScratch scratch;
+  uint32_t link = RoadGraph::make_link(0, false);
+  road_network.mark_visited(0);
+  size_t driven = 1;
+  size_t deepest_climb = 0;
+  size_t climb = 0;
+  while (road_network.get_unvisited_count() > 0) {
+    if (driven > segment_count * 2) {
+      throw std::runtime_error(fmt::format(
+          "drove {} roads on a {}-road tree with {} still unvisited",
+          driven, segment_count, road_network.get_unvisited_count()));
+    }
+    size_t seg = RoadGraph::link_segment(link);
+    ExplorationContext ctx{
+        car,
+        road_network,
+        state,
+        scratch,
+        road_network.turns.at(
+            RoadGraph::exit_port(seg, RoadGraph::link_reverse(link))),
+        link ^ 1u};
+    uint32_t next = DfsPolicy::choose(ctx);
+    if (next == RoadGraph::INVALID) {
+      throw std::runtime_error(fmt::format(
+          "DFS gave up after {} roads with {} still unvisited", driven,
+          road_network.get_unvisited_count()));
+    }
+    size_t next_seg = RoadGraph::link_segment(next);
+    if (road_network.is_visited(next_seg)) {
+      car.segments_without_reveal++;
+      deepest_climb = std::max(deepest_climb, ++climb);
+    } else {
+      car.segments_without_reveal = 0;
+      climb = 0;
+      road_network.mark_visited(next_seg);
+    }
+    link = next;
+    driven++;
+  }
+  if (deepest_climb < 2) {
+    throw std::runtime_error(fmt::format(
+        "never backtracked more than {} junction", deepest_climb));
+  }
+  co_return;
+}
+
+// Tremaux's marks forget the passages entered longest ago, never the ones
+// just entered, and a mark bumped after its table aged keeps its count
+TEST(passage_marks_forget_oldest_first) {
+  PassageMarks marks;
+  constexpr uint32_t total = 2000;
+  for (uint32_t passage = 0; passage < total; ++passage) {
+    marks.bump(passage);
+    if (passage % 3 == 0) {
+      marks.bump(passage);
+    }
+  }
+  // However the tables have swapped, the last quarter table is recent
+  for (uint32_t passage = total - PassageMarks::CAPACITY / 4;
+       passage < total; ++passage) {
+    uint8_t expected = passage % 3 == 0 ? 2 : 1;
+    if (marks.get(passage) != expected) {
+      throw std::runtime_error(
+          fmt::format("recent passage {} has {} marks, expected {}",
+                      passage, marks.get(passage), expected));
+    }
+  }
+  if (marks.get(0) != 0) {
+    throw std::runtime_error("passage 0 still remembered after 2000 more");
+  }
+  // Entered once, aged into the older table, then entered again
+  PassageMarks aged;
+  aged.bump(7);
+  for (uint32_t passage = 1000; passage < 1000 + PassageMarks::CAPACITY / 2;
+       ++passage) {
+    aged.bump(passage);
+  }
+  aged.bump(7);
+  if (aged.get(7) != 2) {
+    throw std::runtime_error(fmt::format(
+        "passage 7 has {} marks after aging, expected 2", aged.get(7)));
+  }
+  co_return;
+}
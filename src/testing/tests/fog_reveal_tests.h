@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../benchmarks/fog_reveal_benchmarks.h"
+#include "../test_macros.h"
+#include <fmt/format.h>
+#include <stdexcept>
+
+// A segment's capsule reveal must light every cell the old per-sample
+// discs did, match the per-cell distance test exactly, and its crossed
+// cells must cover every cell the old query sampled
+TEST(segment_reveal_coverage) {
+  std::vector<RoadSegment> roads = fog_reveal_bench::segments(3000);
+  for (float radius : {20.0f, 50.0f, 200.0f}) {
+    fog_reveal_bench::SegmentCoverage coverage =
+        fog_reveal_bench::check_coverage(roads, radius);
+    if (!coverage.good()) {
+      throw std::runtime_error(fmt::format(
+          "radius {:.0f}: {} segments not exact, {} stamped cells missed, "
+          "{} sampled cells not crossed",
+          radius, coverage.inexact, coverage.missed, coverage.unsampled));
+    }
+  }
+  co_return;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../../sim_random.h"
+#include "../benchmarks/maze_traversal_benchmarks.h"
+#include "../test_macros.h"
+#include <array>
+#include <fmt/format.h>
+#include <stdexcept>
+
+// Once warmed up, a MazeTraversal tick must never touch the heap. Only
+// checked in builds that count allocations (make ALLOCATION_COUNTING=1).
+TEST(maze_traversal_allocations) {
+  maze_traversal_bench::HotPathRun run =
+      maze_traversal_bench::run_hot_path(maze_traversal_bench::world());
+  if (allocation_counter::ENABLED && run.allocations != 0) {
+    throw std::runtime_error(
+        fmt::format("{} heap allocations over {} of {} ticks",
+                    run.allocations, run.ticks_allocating, run.ticks));
+  }
+  if (run.newly_visited == 0) {
+    throw std::runtime_error("no car reached a new segment");
+  }
+  co_return;
+}
+
+// A seed must draw the same values on every standard library. mt19937's
+// output is fixed by the standard, so these are pinned to what SimRandom
+// maps it to.
+TEST(sim_random_is_portable) {
+  SimRandom::Engine rng(42);
+  std::array<uint32_t, 6> expected_ints{374, 796, 950, 183, 731, 779};
+  for (uint32_t expected : expected_ints) {
+    uint32_t drawn = SimRandom::below(rng, 1000);
+    if (drawn != expected) {
+      throw std::runtime_error(
+          fmt::format("below(1000) drew {}, expected {}", drawn, expected));
+    }
+  }
+  std::array<float, 3> expected_floats{1.57853508f, 1.54960251f,
+                                       -5.50370216f};
+  for (float expected : expected_floats) {
+    float drawn = SimRandom::between(rng, -8.0f, 8.0f);
+    if (drawn != expected) {
+      throw std::runtime_error(fmt::format(
+          "between(-8, 8) drew {:.9g}, expected {:.9g}", drawn, expected));
+    }
+  }
+  co_return;
+}
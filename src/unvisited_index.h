@@ -0,0 +1,159 @@
+#pragma once
+
+#include "road_components.h"
+#include "sim_random.h"
+#include <cstdint>
+#include <vector>
+
+// Unvisited segments as a sparse set (dense array plus position index) for
+// O(1) uniform sampling and counting, and as one circular doubly linked
+// list per component so a component's unvisited segments can be listed in
+// O(answer) and two components can still be merged in O(1).
+struct UnvisitedIndex {
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  std::vector<uint32_t> dense;
+  // Index into dense, NONE once visited
+  std::vector<uint32_t> position;
+  std::vector<uint32_t> next;
+  std::vector<uint32_t> prev;
+  // Indexed by component root
+  std::vector<uint32_t> component_head;
+  std::vector<uint32_t> component_count;
+
+  size_t count() const { return dense.size(); }
+  bool empty() const { return dense.empty(); }
+
+  bool contains(size_t segment) const {
+    return segment < position.size() && position[segment] != NONE;
+  }
+
+  void build(const RoadComponents &components,
+             const std::vector<bool> &visited) {
+    size_t segment_count = components.segment_count();
+    dense.clear();
+    position.assign(segment_count, NONE);
+    next.assign(segment_count, NONE);
+    prev.assign(segment_count, NONE);
+    component_head.assign(segment_count, NONE);
+    component_count.assign(segment_count, 0);
+    for (size_t i = 0; i < segment_count; ++i) {
+      if (i < visited.size() && visited[i]) {
+        continue;
+      }
+      append(i, components.find(i));
+    }
+  }
+
+  // Adds segments appended since the last build as unvisited singletons
+  void grow(size_t segment_count) {
+    for (size_t i = position.size(); i < segment_count; ++i) {
+      position.push_back(NONE);
+      next.push_back(NONE);
+      prev.push_back(NONE);
+      component_head.push_back(NONE);
+      component_count.push_back(0);
+      append(i, static_cast<uint32_t>(i));
+    }
+  }
+
+  void erase(size_t segment, uint32_t root) {
+    if (!contains(segment)) {
+      return;
+    }
+    uint32_t last = dense.back();
+    dense[position[segment]] = last;
+    position[last] = position[segment];
+    dense.pop_back();
+    position[segment] = NONE;
+
+    uint32_t seg = static_cast<uint32_t>(segment);
+    if (--component_count[root] == 0) {
+      component_head[root] = NONE;
+    } else {
+      next[prev[seg]] = next[seg];
+      prev[next[seg]] = prev[seg];
+      if (component_head[root] == seg) {
+        component_head[root] = next[seg];
+      }
+    }
+    next[seg] = NONE;
+    prev[seg] = NONE;
+  }
+
+  // Moves the lists of two old roots onto the root of their union
+  void merge(uint32_t root_a, uint32_t root_b, uint32_t new_root) {
+    uint32_t head_a = component_head[root_a];
+    uint32_t head_b = component_head[root_b];
+    if (head_a != NONE && head_b != NONE) {
+      uint32_t tail_a = prev[head_a];
+      uint32_t tail_b = prev[head_b];
+      next[tail_a] = head_b;
+      prev[head_b] = tail_a;
+      next[tail_b] = head_a;
+      prev[head_a] = tail_b;
+    }
+    uint32_t head = head_a != NONE ? head_a : head_b;
+    uint32_t merged_count = component_count[root_a] + component_count[root_b];
+    component_head[root_a] = NONE;
+    component_head[root_b] = NONE;
+    component_count[root_a] = 0;
+    component_count[root_b] = 0;
+    component_head[new_root] = head;
+    component_count[new_root] = merged_count;
+  }
+
+  template <typename Rng> size_t sample(Rng &rng) const {
+    if (dense.empty()) {
+      return SIZE_MAX;
+    }
+    return dense[SimRandom::below(rng, static_cast<uint32_t>(dense.size()))];
+  }
+
+  size_t count_in_component(size_t root) const {
+    return root < component_count.size() ? component_count[root] : 0;
+  }
+
+  template <typename Fn>
+  void for_each_in_component(size_t root, Fn &&fn) const {
+    if (root >= component_head.size() || component_head[root] == NONE) {
+      return;
+    }
+    uint32_t first = component_head[root];
+    uint32_t member = first;
+    do {
+      fn(static_cast<size_t>(member));
+      member = next[member];
+    } while (member != first);
+  }
+
+  void clear() {
+    dense.clear();
+    position.clear();
+    next.clear();
+    prev.clear();
+    component_head.clear();
+    component_count.clear();
+  }
+
+private:
+  void append(size_t segment, uint32_t root) {
+    uint32_t seg = static_cast<uint32_t>(segment);
+    position[seg] = static_cast<uint32_t>(dense.size());
+    dense.push_back(seg);
+    uint32_t head = component_head[root];
+    if (head == NONE) {
+      component_head[root] = seg;
+      next[seg] = seg;
+      prev[seg] = seg;
+    } else {
+      // Insert before the head, i.e. at the tail
+      uint32_t tail = prev[head];
+      next[tail] = seg;
+      prev[seg] = tail;
+      next[seg] = head;
+      prev[head] = seg;
+    }
+    component_count[root]++;
+  }
+};
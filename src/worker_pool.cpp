@@ -0,0 +1,61 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned lane_count) {
+  if (lane_count == 0) {
+    lane_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads.reserve(lane_count - 1);
+  for (unsigned lane = 1; lane < lane_count; ++lane) {
+    threads.emplace_back([this, lane]() { work(lane); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+void WorkerPool::run(const std::function<void(size_t)> &job_in) {
+  if (threads.empty()) {
+    job_in(0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &job_in;
+    running = threads.size();
+    generation++;
+  }
+  wake.notify_all();
+  job_in(0);
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [this]() { return running == 0; });
+  job = nullptr;
+}
+
+void WorkerPool::work(size_t lane) {
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [&]() { return stopping || generation != seen; });
+    if (stopping) {
+      return;
+    }
+    seen = generation;
+    const std::function<void(size_t)> &current = *job;
+    lock.unlock();
+    current(lane);
+    lock.lock();
+    if (--running == 0) {
+      finished.notify_one();
+    }
+  }
+}
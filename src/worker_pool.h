@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that run one job at a time across every lane at
+// once. The calling thread takes lane 0, so n lanes start n - 1 threads and
+// a single lane runs the job inline. Threads sleep between jobs rather than
+// spin, so an idle pool costs nothing.
+class WorkerPool {
+public:
+  // 0 lanes means one per core
+  explicit WorkerPool(unsigned lane_count = 0);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  void operator=(const WorkerPool &) = delete;
+
+  size_t lanes() const { return threads.size() + 1; }
+
+  // Calls job(lane) once for every lane and returns when all have returned
+  void run(const std::function<void(size_t)> &job);
+
+  // The part of [0, count) that lane covers when split evenly over lanes,
+  // lower lanes first
+  static size_t slice_begin(size_t count, size_t lane, size_t lanes) {
+    return count * lane / lanes;
+  }
+
+private:
+  void work(size_t lane);
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  const std::function<void(size_t)> *job{nullptr};
+  // Bumped for every job, so a thread never runs the same one twice
+  uint64_t generation{0};
+  size_t running{0};
+  bool stopping{false};
+  std::vector<std::thread> threads;
+};